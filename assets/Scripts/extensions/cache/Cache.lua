@@ -5,6 +5,8 @@ Cache = class {
 
     images = {},
     
+    requests = {},
+    
     fonts = {},
     
     windowskins = {}
@@ -22,8 +24,15 @@ function Cache:image(filename)
     local image = self.images[filename]
     
     if image == nil then -- image not yet cached
-        -- load image
-        image = graphics.readImage(filename)
+        -- take the image from a preload, waiting for it if needed
+        local request = self.requests[filename]
+        if request ~= nil then
+            self.requests[filename] = nil
+            image = request:wait()
+        else
+            -- load image
+            image = graphics.readImage(filename)
+        end
         
          -- make sure readImage succeeded
         if image == nil then
@@ -37,6 +46,24 @@ function Cache:image(filename)
     return image
 end
 
+function Cache:preload(filename)
+    -- sanity checks
+    assert(type(filename) == "string" and #filename > 0, "invalid filename")
+    
+    -- decode in the background, Cache:image picks the result up
+    if self.images[filename] == nil and self.requests[filename] == nil then
+        self.requests[filename] = graphics.readImageAsync(filename)
+    end
+end
+
+function Cache:isLoaded(filename)
+    if self.images[filename] ~= nil then
+        return true
+    end
+    local request = self.requests[filename]
+    return request ~= nil and request.ready
+end
+
 function Cache:font(filename)
     -- sanity checks
     assert(type(filename) == "string" and #filename > 0, "invalid filename")
@@ -14,10 +14,12 @@ LightmapManager = class {
     
     onSceneDrawn = function(self, scene)
         self:update(scene)
-        self:render(scene)
     end
 }
 
+-- the lightmap is drawn natively under everything the scripts draw
+game.lightmap.setBlendMode("mix")
+
 function LightmapManager:getLightmapFilename(mapId)
     local id = ""
     if mapId < 1000 then
@@ -44,27 +46,10 @@ function LightmapManager:update(scene)
         else
             self.currentLightmap = nil
         end
+        game.lightmap.setImage(self.currentLightmap)
     end
     self.lightmapOpacity:update(dt)
-end
-
-function LightmapManager:render(scene)
-    if scene == "map" and self.currentLightmap then
-        local cx, cy = game.map.getCameraPosition()
-        game.screen.draw(
-            self.currentLightmap,
-            -cx,
-            -cy,
-            0.0,
-            1.0,
-            graphics.packColor(
-                255,
-                255,
-                255,
-                self.lightmapOpacity:getValue()
-            )
-        )
-    end
+    game.lightmap.opacity = self.lightmapOpacity:getValue()
 end
 
 function LightmapManager:changeOpacity(opacity, ms)
@@ -0,0 +1,66 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_BYTEORDER_HPP_INCLUDED
+#define RPGSS_BYTEORDER_HPP_INCLUDED
+
+#include "types.hpp"
+
+
+namespace rpgss {
+
+    // little endian integers in file formats, independent of the host
+
+    //-----------------------------------------------------------------
+    inline void Put16(u8* p, u32 n)
+    {
+        p[0] = (u8)n;
+        p[1] = (u8)(n >> 8);
+    }
+
+    //-----------------------------------------------------------------
+    inline void Put32(u8* p, u32 n)
+    {
+        p[0] = (u8)n;
+        p[1] = (u8)(n >> 8);
+        p[2] = (u8)(n >> 16);
+        p[3] = (u8)(n >> 24);
+    }
+
+    //-----------------------------------------------------------------
+    inline u32 Get16(const u8* p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+    //-----------------------------------------------------------------
+    inline u32 Get32(const u8* p)
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24);
+    }
+
+} // namespace rpgss
+
+
+#endif // RPGSS_BYTEORDER_HPP_INCLUDED
@@ -34,6 +34,8 @@ namespace rpgss {
         bool SseSupported = false;
         bool Sse2Supported = false;
         bool Sse3Supported = false;
+        bool AvxSupported = false;
+        bool Avx2Supported = false;
 
         //-----------------------------------------------------------------
         bool Initialize()
@@ -42,6 +44,8 @@ namespace rpgss {
             SseSupported  = __builtin_cpu_supports("sse")  != 0;
             Sse2Supported = __builtin_cpu_supports("sse2") != 0;
             Sse3Supported = __builtin_cpu_supports("sse3") != 0;
+            AvxSupported  = __builtin_cpu_supports("avx")  != 0;
+            Avx2Supported = __builtin_cpu_supports("avx2") != 0;
 
             return true;
         }
@@ -73,4 +77,16 @@ namespace rpgss {
         return Sse3Supported;
     }
 
+    //-----------------------------------------------------------------
+    bool CpuSupportsAvx()
+    {
+        return AvxSupported;
+    }
+
+    //-----------------------------------------------------------------
+    bool CpuSupportsAvx2()
+    {
+        return Avx2Supported;
+    }
+
 } // namespace rpgss
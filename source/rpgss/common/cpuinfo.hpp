@@ -32,6 +32,8 @@ namespace rpgss {
     bool CpuSupportsSse();
     bool CpuSupportsSse2();
     bool CpuSupportsSse3();
+    bool CpuSupportsAvx();
+    bool CpuSupportsAvx2();
 
 } // namespace rpgss
 
@@ -0,0 +1,244 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "lz.hpp"
+
+
+namespace rpgss {
+
+    namespace {
+
+        const int MinMatch  = 4;
+        const int MaxOffset = 65535;
+        const int HashBits  = 14;
+
+        //---------------------------------------------------------
+        inline u32 Read32(const u8* p)
+        {
+            u32 n;
+            std::memcpy(&n, p, 4);
+            return n;
+        }
+
+        //---------------------------------------------------------
+        inline u32 Hash(u32 n)
+        {
+            return (n * 2654435761U) >> (32 - HashBits);
+        }
+
+        //---------------------------------------------------------
+        // 15 in the token nibble is continued in bytes of up to 255
+        inline bool WriteLength(u8*& op, u8* end, int length)
+        {
+            for (; length >= 255; length -= 255) {
+                if (op == end) {
+                    return false;
+                }
+                *op++ = 255;
+            }
+            if (op == end) {
+                return false;
+            }
+            *op++ = (u8)length;
+            return true;
+        }
+
+        //---------------------------------------------------------
+        inline bool ReadLength(const u8*& ip, const u8* end, int& length)
+        {
+            for (;;) {
+                if (ip == end) {
+                    return false;
+                }
+                int n = *ip++;
+                length += n;
+                if (n != 255) {
+                    return true;
+                }
+                // longer than any input could be
+                if (length > 0x40000000) {
+                    return false;
+                }
+            }
+        }
+
+        //---------------------------------------------------------
+        // a match length of 0 ends the block after the literals
+        bool WriteSequence(u8*& op, u8* end, const u8* literals, int literalCount, int offset, int matchLength)
+        {
+            if (op == end) {
+                return false;
+            }
+
+            int match_code = (matchLength > 0 ? matchLength - MinMatch : 0);
+            u8* token = op++;
+            *token = (u8)((std::min(literalCount, 15) << 4) | std::min(match_code, 15));
+
+            if (literalCount >= 15 && !WriteLength(op, end, literalCount - 15)) {
+                return false;
+            }
+
+            if (end - op < literalCount) {
+                return false;
+            }
+            std::memcpy(op, literals, literalCount);
+            op += literalCount;
+
+            if (matchLength == 0) {
+                return true;
+            }
+
+            if (end - op < 2) {
+                return false;
+            }
+            *op++ = (u8)offset;
+            *op++ = (u8)(offset >> 8);
+
+            if (match_code >= 15 && !WriteLength(op, end, match_code - 15)) {
+                return false;
+            }
+
+            return true;
+        }
+
+    } // anonymous namespace
+
+    //---------------------------------------------------------
+    int LzCompressBound(int size)
+    {
+        return size + size / 255 + 16;
+    }
+
+    //---------------------------------------------------------
+    int LzCompress(const u8* src, int srcSize, u8* dst, int dstCapacity)
+    {
+        // positions plus one, 0 is an empty slot
+        std::vector<int> table(1 << HashBits, 0);
+
+        u8* op  = dst;
+        u8* end = dst + dstCapacity;
+
+        int anchor = 0;
+        int pos    = 0;
+
+        while (pos + MinMatch <= srcSize) {
+            u32 seq = Read32(src + pos);
+            int& slot = table[Hash(seq)];
+            int ref = slot - 1;
+            slot = pos + 1;
+
+            if (ref < 0 || pos - ref > MaxOffset || Read32(src + ref) != seq) {
+                pos++;
+                continue;
+            }
+
+            int length = MinMatch;
+            while (pos + length < srcSize && src[ref + length] == src[pos + length]) {
+                length++;
+            }
+
+            if (!WriteSequence(op, end, src + anchor, pos - anchor, pos - ref, length)) {
+                return 0;
+            }
+
+            pos   += length;
+            anchor = pos;
+        }
+
+        if (!WriteSequence(op, end, src + anchor, srcSize - anchor, 0, 0)) {
+            return 0;
+        }
+
+        return op - dst;
+    }
+
+    //---------------------------------------------------------
+    bool LzDecompress(const u8* src, int srcSize, u8* dst, int dstSize)
+    {
+        const u8* ip      = src;
+        const u8* in_end  = src + srcSize;
+        u8*       op      = dst;
+        u8*       out_end = dst + dstSize;
+
+        for (;;) {
+            if (ip == in_end) {
+                return false;
+            }
+
+            int token = *ip++;
+
+            int literal_count = token >> 4;
+            if (literal_count == 15 && !ReadLength(ip, in_end, literal_count)) {
+                return false;
+            }
+
+            if (in_end - ip < literal_count || out_end - op < literal_count) {
+                return false;
+            }
+            std::memcpy(op, ip, literal_count);
+            ip += literal_count;
+            op += literal_count;
+
+            // the last sequence has no match
+            if (ip == in_end) {
+                return op == out_end;
+            }
+
+            if (in_end - ip < 2) {
+                return false;
+            }
+            int offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+
+            if (offset == 0 || offset > op - dst) {
+                return false;
+            }
+
+            int length = token & 15;
+            if (length == 15 && !ReadLength(ip, in_end, length)) {
+                return false;
+            }
+            length += MinMatch;
+
+            if (out_end - op < length) {
+                return false;
+            }
+
+            // the output from match on repeats every offset bytes, so an
+            // overlapping match is copied in non-overlapping doubling steps
+            const u8* match = op - offset;
+            while (length > 0) {
+                int n = std::min(length, (int)(op - match));
+                std::memcpy(op, match, n);
+                op     += n;
+                length -= n;
+            }
+        }
+    }
+
+} // namespace rpgss
@@ -0,0 +1,53 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_LZ_HPP_INCLUDED
+#define RPGSS_LZ_HPP_INCLUDED
+
+#include "types.hpp"
+
+
+namespace rpgss {
+
+    // a byte oriented lz77 block format in the style of lz4: sequences of
+    // literals followed by a match with a 16-bit offset, built for fast
+    // decompression rather than for ratio
+
+    // the largest size LzCompress may need for size input bytes
+    int LzCompressBound(int size);
+
+    // returns the compressed size or 0 if it does not fit into dstCapacity
+    int LzCompress(const u8* src, int srcSize, u8* dst, int dstCapacity);
+
+    // no input decompresses to more than this many times its size
+    const int LzMaxRatio = 255;
+
+    // fails unless src decompresses to exactly dstSize bytes,
+    // malformed input is detected rather than trusted
+    bool LzDecompress(const u8* src, int srcSize, u8* dst, int dstSize);
+
+} // namespace rpgss
+
+
+#endif // RPGSS_LZ_HPP_INCLUDED
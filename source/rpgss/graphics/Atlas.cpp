@@ -0,0 +1,212 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+
+#include "Atlas.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+
+        //-----------------------------------------------------------------
+        Atlas::Ptr
+        Atlas::New(int pageWidth, int pageHeight)
+        {
+            if (pageWidth <= 0 || pageHeight <= 0) {
+                return 0;
+            }
+            return new Atlas(pageWidth, pageHeight);
+        }
+
+        //-----------------------------------------------------------------
+        Atlas::Atlas(int pageWidth, int pageHeight)
+            : _pageWidth(pageWidth)
+            , _pageHeight(pageHeight)
+        {
+        }
+
+        //-----------------------------------------------------------------
+        Atlas::~Atlas()
+        {
+        }
+
+        //-----------------------------------------------------------------
+        bool
+        Atlas::insert(const std::string& name, const Image* image, Entry* entry)
+        {
+            if (!image || _entries.count(name)) {
+                return false;
+            }
+
+            int w = image->getWidth();
+            int h = image->getHeight();
+
+            int         page_index = -1;
+            core::Vec2i pos;
+
+            for (int i = 0; i < (int)_pages.size(); i++) {
+                if (pack(_pages[i], w, h, pos)) {
+                    page_index = i;
+                    break;
+                }
+            }
+
+            if (page_index < 0) {
+                // images larger than a page get a page of their own
+                Page page;
+                page.image = Image::New(std::max(w, _pageWidth), std::max(h, _pageHeight), RGBA(0, 0, 0, 0));
+                if (!page.image) {
+                    return false;
+                }
+
+                SkylineNode node = { 0, 0, page.image->getWidth() };
+                page.skyline.push_back(node);
+
+                if (!pack(page, w, h, pos)) {
+                    return false;
+                }
+
+                _pages.push_back(page);
+                page_index = (int)_pages.size() - 1;
+            }
+
+            Image* page_image = _pages[page_index].image;
+            page_image->draw(image, pos, 0.0, 1.0, RGBA(255, 255, 255, 255), BlendMode::Set);
+
+            // pages store straight alpha
+            if (image->isPremultiplied()) {
+                RGBA* p = page_image->getPixels() + pos.y * page_image->getPitch() + pos.x;
+                for (int y = 0; y < h; y++) {
+                    for (int x = 0; x < w; x++) {
+                        p[x] = UnpremultiplyRGBA(p[x]);
+                    }
+                    p += page_image->getPitch();
+                }
+            }
+
+            Entry new_entry;
+            new_entry.page = page_index;
+            new_entry.rect = core::Recti(pos.x, pos.y, w, h);
+            _entries[name] = new_entry;
+
+            if (entry) {
+                *entry = new_entry;
+            }
+
+            return true;
+        }
+
+        //-----------------------------------------------------------------
+        const Atlas::Entry*
+        Atlas::find(const std::string& name) const
+        {
+            std::map<std::string, Entry>::const_iterator it = _entries.find(name);
+            if (it == _entries.end()) {
+                return 0;
+            }
+            return &it->second;
+        }
+
+        //-----------------------------------------------------------------
+        bool
+        Atlas::fit(const Page& page, int index, int width, int height, int& y) const
+        {
+            const std::vector<SkylineNode>& skyline = page.skyline;
+
+            if (skyline[index].x + width > page.image->getWidth()) {
+                return false;
+            }
+
+            // the rectangle rests on the highest node below it
+            y = 0;
+            int width_left = width;
+            for (int i = index; width_left > 0; i++) {
+                y = std::max(y, skyline[i].y);
+                width_left -= skyline[i].width;
+            }
+
+            return y + height <= page.image->getHeight();
+        }
+
+        //-----------------------------------------------------------------
+        bool
+        Atlas::pack(Page& page, int width, int height, core::Vec2i& pos)
+        {
+            std::vector<SkylineNode>& skyline = page.skyline;
+
+            // bottom-left heuristic: lowest top edge, then narrowest node
+            int best_index  = -1;
+            int best_bottom = 0;
+            int best_width  = 0;
+
+            for (int i = 0; i < (int)skyline.size(); i++) {
+                int y;
+                if (fit(page, i, width, height, y)) {
+                    int bottom = y + height;
+                    if (best_index < 0 || bottom < best_bottom || (bottom == best_bottom && skyline[i].width < best_width)) {
+                        best_index  = i;
+                        best_bottom = bottom;
+                        best_width  = skyline[i].width;
+                        pos = core::Vec2i(skyline[i].x, y);
+                    }
+                }
+            }
+
+            if (best_index < 0) {
+                return false;
+            }
+
+            SkylineNode node = { pos.x, pos.y + height, width };
+            skyline.insert(skyline.begin() + best_index, node);
+
+            // cut away what the new node covers
+            int right = node.x + node.width;
+            int i = best_index + 1;
+            while (i < (int)skyline.size() && skyline[i].x < right) {
+                int shrink = right - skyline[i].x;
+                if (shrink >= skyline[i].width) {
+                    skyline.erase(skyline.begin() + i);
+                } else {
+                    skyline[i].x     += shrink;
+                    skyline[i].width -= shrink;
+                    break;
+                }
+            }
+
+            // merge neighbours of equal height
+            for (i = 0; i + 1 < (int)skyline.size(); ) {
+                if (skyline[i].y == skyline[i + 1].y) {
+                    skyline[i].width += skyline[i + 1].width;
+                    skyline.erase(skyline.begin() + i + 1);
+                } else {
+                    i++;
+                }
+            }
+
+            return true;
+        }
+
+    } // namespace graphics
+} // namespace rpgss
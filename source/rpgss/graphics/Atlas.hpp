@@ -0,0 +1,133 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_GRAPHICS_ATLAS_HPP_INCLUDED
+#define RPGSS_GRAPHICS_ATLAS_HPP_INCLUDED
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../common/RefCountedObject.hpp"
+#include "../common/RefCountedObjectPtr.hpp"
+#include "../core/Rect.hpp"
+#include "Image.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+
+        // packs many small images into a few large pages,
+        // images can be added at any time and are looked up by name
+        class Atlas : public RefCountedObject {
+        public:
+            typedef RefCountedObjectPtr<Atlas> Ptr;
+
+            struct Entry {
+                int         page;
+                core::Recti rect;
+            };
+
+        public:
+            static Atlas::Ptr New(int pageWidth = 1024, int pageHeight = 1024);
+
+        public:
+            int getPageWidth() const;
+            int getPageHeight() const;
+            int getPageCount() const;
+            Image* getPage(int index);
+            int getEntryCount() const;
+
+            // fails if the name is already taken
+            bool insert(const std::string& name, const Image* image, Entry* entry = 0);
+            const Entry* find(const std::string& name) const;
+
+        private:
+            // top edge of the packed area over [x, x + width)
+            struct SkylineNode {
+                int x;
+                int y;
+                int width;
+            };
+
+            struct Page {
+                Image::Ptr               image;
+                std::vector<SkylineNode> skyline;
+            };
+
+        private:
+            // use New()
+            Atlas(int pageWidth, int pageHeight);
+            ~Atlas();
+
+            bool fit(const Page& page, int index, int width, int height, int& y) const;
+            bool pack(Page& page, int width, int height, core::Vec2i& pos);
+
+        private:
+            int _pageWidth;
+            int _pageHeight;
+            std::vector<Page> _pages;
+            std::map<std::string, Entry> _entries;
+        };
+
+        //-----------------------------------------------------------------
+        inline int
+        Atlas::getPageWidth() const
+        {
+            return _pageWidth;
+        }
+
+        //-----------------------------------------------------------------
+        inline int
+        Atlas::getPageHeight() const
+        {
+            return _pageHeight;
+        }
+
+        //-----------------------------------------------------------------
+        inline int
+        Atlas::getPageCount() const
+        {
+            return (int)_pages.size();
+        }
+
+        //-----------------------------------------------------------------
+        inline Image*
+        Atlas::getPage(int index)
+        {
+            return _pages[index].image;
+        }
+
+        //-----------------------------------------------------------------
+        inline int
+        Atlas::getEntryCount() const
+        {
+            return (int)_entries.size();
+        }
+
+    } // namespace graphics
+} // namespace rpgss
+
+
+#endif // RPGSS_GRAPHICS_ATLAS_HPP_INCLUDED
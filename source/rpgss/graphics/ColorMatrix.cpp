@@ -0,0 +1,173 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <cmath>
+
+#include "ColorMatrix.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+
+        namespace {
+
+            // luminance weights of the hue and saturation matrices
+            const float LumRed   = 0.213f;
+            const float LumGreen = 0.715f;
+            const float LumBlue  = 0.072f;
+
+            //-----------------------------------------------------------------
+            int ToFixed(float f, int min, int max)
+            {
+                float v = std::floor(f * 256.0f + 0.5f);
+                if (v < min) {
+                    return min;
+                }
+                if (v > max) {
+                    return max;
+                }
+                return (int)v;
+            }
+
+        } // anonymous namespace
+
+        //-----------------------------------------------------------------
+        ColorMatrix::ColorMatrix()
+        {
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 5; j++) {
+                    m[i][j] = (i == j ? 1.0f : 0.0f);
+                }
+            }
+        }
+
+        //-----------------------------------------------------------------
+        ColorMatrix
+        ColorMatrix::Tone(int red, int green, int blue, int grey)
+        {
+            ColorMatrix result = Saturation(1.0f - grey / 255.0f);
+            result.m[0][4] = (float)red;
+            result.m[1][4] = (float)green;
+            result.m[2][4] = (float)blue;
+            return result;
+        }
+
+        //-----------------------------------------------------------------
+        ColorMatrix
+        ColorMatrix::Saturation(float saturation)
+        {
+            float s = saturation;
+            float t = 1.0f - s;
+
+            ColorMatrix result;
+            result.m[0][0] = LumRed * t + s; result.m[0][1] = LumGreen * t;     result.m[0][2] = LumBlue * t;
+            result.m[1][0] = LumRed * t;     result.m[1][1] = LumGreen * t + s; result.m[1][2] = LumBlue * t;
+            result.m[2][0] = LumRed * t;     result.m[2][1] = LumGreen * t;     result.m[2][2] = LumBlue * t + s;
+            return result;
+        }
+
+        //-----------------------------------------------------------------
+        ColorMatrix
+        ColorMatrix::HueRotation(float angle)
+        {
+            float rad = angle * 3.14159265f / 180.0f;
+            float c   = std::cos(rad);
+            float s   = std::sin(rad);
+
+            ColorMatrix result;
+            result.m[0][0] = LumRed   + c * (1.0f - LumRed)   - s * LumRed;
+            result.m[0][1] = LumGreen - c * LumGreen          - s * LumGreen;
+            result.m[0][2] = LumBlue  - c * LumBlue           + s * (1.0f - LumBlue);
+            result.m[1][0] = LumRed   - c * LumRed            + s * 0.143f;
+            result.m[1][1] = LumGreen + c * (1.0f - LumGreen) + s * 0.140f;
+            result.m[1][2] = LumBlue  - c * LumBlue           - s * 0.283f;
+            result.m[2][0] = LumRed   - c * LumRed            - s * (1.0f - LumRed);
+            result.m[2][1] = LumGreen - c * LumGreen          + s * LumGreen;
+            result.m[2][2] = LumBlue  + c * (1.0f - LumBlue)  + s * LumBlue;
+            return result;
+        }
+
+        //-----------------------------------------------------------------
+        ColorMatrix
+        ColorMatrix::operator*(const ColorMatrix& rhs) const
+        {
+            ColorMatrix result;
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 5; j++) {
+                    float sum = (j == 4 ? m[i][4] : 0.0f);
+                    for (int k = 0; k < 4; k++) {
+                        sum += m[i][k] * rhs.m[k][j];
+                    }
+                    result.m[i][j] = sum;
+                }
+            }
+            return result;
+        }
+
+        //-----------------------------------------------------------------
+        bool
+        ColorMatrix::isIdentity() const
+        {
+            int fixed[20];
+            toFixed(fixed);
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 5; j++) {
+                    if (fixed[i * 5 + j] != (i == j ? 256 : 0)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        //-----------------------------------------------------------------
+        bool
+        ColorMatrix::keepsAlpha() const
+        {
+            int fixed[20];
+            toFixed(fixed);
+            for (int i = 0; i < 4; i++) {
+                // the alpha column and row
+                if (fixed[i * 5 + 3] != (i == 3 ? 256 : 0) || fixed[15 + i] != (i == 3 ? 256 : 0)) {
+                    return false;
+                }
+            }
+            return fixed[19] == 0;
+        }
+
+        //-----------------------------------------------------------------
+        void
+        ColorMatrix::toFixed(int fixed[20]) const
+        {
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    fixed[i * 5 + j] = ToFixed(m[i][j], -32768, 32767);
+                }
+                // the offsets may go further, they are added in 32 bits
+                fixed[i * 5 + 4] = ToFixed(m[i][4], -(1 << 22), 1 << 22);
+            }
+        }
+
+    } // namespace graphics
+} // namespace rpgss
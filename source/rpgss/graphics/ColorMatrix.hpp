@@ -0,0 +1,65 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_GRAPHICS_COLORMATRIX_HPP_INCLUDED
+#define RPGSS_GRAPHICS_COLORMATRIX_HPP_INCLUDED
+
+
+namespace rpgss {
+    namespace graphics {
+
+        // maps (r, g, b, a, 1) to (r', g', b', a'), channels and
+        // offsets range from 0 to 255
+        struct ColorMatrix {
+            float m[4][5];
+
+            ColorMatrix(); // identity
+
+            // adds the offsets to the color channels after desaturating
+            // by grey (0 to 255), like the tone of the game screen
+            static ColorMatrix Tone(int red, int green, int blue, int grey = 0);
+
+            // 0 is grey, 1 leaves the colors as they are, above 1 oversaturates
+            static ColorMatrix Saturation(float saturation);
+
+            // rotates the hues by angle degrees, keeping the luminance
+            static ColorMatrix HueRotation(float angle);
+
+            // applies rhs first, then this
+            ColorMatrix operator*(const ColorMatrix& rhs) const;
+
+            bool isIdentity() const;
+
+            // true if alpha is neither changed nor affects the colors
+            bool keepsAlpha() const;
+
+            // 8.8 fixed point, row by row, coefficients are clamped to 16 bits
+            void toFixed(int fixed[20]) const;
+        };
+
+    } // namespace graphics
+} // namespace rpgss
+
+
+#endif // RPGSS_GRAPHICS_COLORMATRIX_HPP_INCLUDED
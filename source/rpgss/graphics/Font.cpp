@@ -87,13 +87,20 @@ namespace rpgss {
                 return false;
             }
 
-            _chars.resize(256);
+            _glyphRects.resize(256);
             _maxCharWidth  = (fontImage->getWidth()  - 17) / 16;
             _maxCharHeight = (fontImage->getHeight() - 17) / 16;
 
             RGBA skip_color = fontImage->getPixel(0, 0);
 
-            // extract char images
+            // glyphs are packed into rows as wide as the font image without
+            // separators, so the glyph image is at most as large as that
+            core::Recti char_rects[256];
+            int row_width = 16 * _maxCharWidth;
+            int pack_x    = 0;
+            int pack_y    = 0;
+
+            // find char rects
             for (int char_index = 0; char_index < 256; char_index++)
             {
                 int char_row    = (char_index / 16);
@@ -113,9 +120,39 @@ namespace rpgss {
                         }
                     }
 
-                    // extract char image
-                    core::Recti image_rect = core::Recti(char_x, char_y, char_width, char_height);
-                    _chars[char_index] = fontImage->copyRect(image_rect);
+                    if (pack_x + char_width > row_width) {
+                        pack_x  = 0;
+                        pack_y += _maxCharHeight;
+                    }
+
+                    char_rects[char_index]  = core::Recti(char_x, char_y, char_width, char_height);
+                    _glyphRects[char_index] = core::Recti(pack_x, pack_y, char_width, char_height);
+                    pack_x += char_width;
+                }
+            }
+
+            // copy glyphs
+            _glyphImage = Image::New(row_width, pack_y + _maxCharHeight, RGBA(0, 0, 0, 0));
+            if (!_glyphImage) {
+                return false;
+            }
+
+            // keep the pixels as they are
+            if (fontImage->isPremultiplied()) {
+                _glyphImage->premultiply();
+            }
+
+            for (int char_index = 0; char_index < 256; char_index++) {
+                if (!_glyphRects[char_index].isEmpty()) {
+                    _glyphImage->draw(
+                        fontImage,
+                        char_rects[char_index],
+                        _glyphRects[char_index].getPosition(),
+                        0.0,
+                        1.0,
+                        RGBA(255, 255, 255, 255),
+                        BlendMode::Set
+                    );
                 }
             }
 
@@ -138,8 +175,7 @@ namespace rpgss {
                 if (str[i] == '\n') {
                     break;
                 }
-                Image* char_image = _chars[(u8)str[i]];
-                str_width += (char_image ? char_image->getWidth() : 0);
+                str_width += getCharWidth(str[i]);
             }
 
             return str_width;
@@ -173,8 +209,7 @@ namespace rpgss {
                         wc = 0;
                         ww = 0;
 
-                        Image* space_char_image = _chars[(u8)' '];
-                        int space_w = (space_char_image ? space_char_image->getWidth() : 0);
+                        int space_w = getCharWidth(' ');
 
                         if (lw + space_w > max_line_width && lw > 0) {
                             lines.push_back(std::make_pair(i-lc, lc));
@@ -193,8 +228,7 @@ namespace rpgss {
                         wc = 0;
                         ww = 0;
 
-                        Image* space_char_image = _chars[(u8)' '];
-                        int tab_w = (space_char_image ? space_char_image->getWidth() : 0) * _tabWidth;
+                        int tab_w = getCharWidth(' ') * _tabWidth;
 
                         if (tab_w > 0) {
                             tab_w = tab_w - (lw % tab_w);
@@ -225,8 +259,7 @@ namespace rpgss {
                     }
                     default:
                     {
-                        Image* char_image = _chars[(u8)str[i]];
-                        int char_w = (char_image ? char_image->getWidth() : 0);
+                        int char_w = getCharWidth(str[i]);
 
                         if (lw + ww + char_w > max_line_width) {
                             if (lw > 0) {
@@ -252,5 +285,60 @@ namespace rpgss {
             }
         }
 
+        //-----------------------------------------------------------------
+        void
+        Font::layoutText(core::Vec2i pos, const char* str, int len, float scale, std::vector<Glyph>& glyphs) const
+        {
+            assert(str);
+
+            glyphs.clear();
+
+            if (len < 0) {
+                len = std::strlen(str);
+            }
+
+            int cur_x = pos.x;
+            int cur_y = pos.y;
+
+            for (int i = 0; i < len; i++)
+            {
+                switch (str[i])
+                {
+                    case ' ':
+                    {
+                        cur_x += (int)(getCharWidth(' ') * scale);
+                        break;
+                    }
+                    case '\t':
+                    {
+                        int tab_w = (int)(getCharWidth(' ') * _tabWidth * scale);
+                        if (tab_w > 0) {
+                            tab_w = tab_w - ((cur_x - pos.x) % tab_w);
+                        }
+                        cur_x += tab_w;
+                        break;
+                    }
+                    case '\n':
+                    {
+                        cur_x = pos.x;
+                        cur_y += (int)(_maxCharHeight * scale);
+                        break;
+                    }
+                    default:
+                    {
+                        const core::Recti& rect = getGlyphRect(str[i]);
+                        if (!rect.isEmpty()) {
+                            Glyph glyph;
+                            glyph.srcRect = rect;
+                            glyph.dstRect = core::Recti(cur_x, cur_y, rect.getWidth(), rect.getHeight()).scale(scale);
+                            glyphs.push_back(glyph);
+                            cur_x += (int)(rect.getWidth() * scale);
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+
     } // namespace graphics
 } // namespace rpgss
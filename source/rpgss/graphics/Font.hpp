@@ -30,6 +30,7 @@
 
 #include "../common/RefCountedObject.hpp"
 #include "../common/RefCountedObjectPtr.hpp"
+#include "../core/Rect.hpp"
 #include "Image.hpp"
 
 
@@ -40,6 +41,12 @@ namespace rpgss {
         public:
             typedef RefCountedObjectPtr<Font> Ptr;
 
+            // a char placed by layoutText
+            struct Glyph {
+                core::Recti srcRect; // in the glyph image
+                core::Recti dstRect;
+            };
+
         public:
             static Font::Ptr New(Image* atlas);
 
@@ -50,10 +57,14 @@ namespace rpgss {
             int getTabWidth() const;
             void setTabWidth(int tabWidth);
 
-            const Image* getCharImage(char c) const;
+            // all glyphs packed into one image
+            const Image* getGlyphImage() const;
+            const core::Recti& getGlyphRect(char c) const;
+            int getCharWidth(char c) const;
 
             int getTextWidth(const char* str, int len);
             void wordWrapText(const char* str, int len, int max_line_width, std::vector<std::pair<int, int> >& lines);
+            void layoutText(core::Vec2i pos, const char* str, int len, float scale, std::vector<Glyph>& glyphs) const;
 
         private:
             // use New()
@@ -63,7 +74,8 @@ namespace rpgss {
             bool initFromImage(Image* fontImage);
 
         private:
-            std::vector<Image::Ptr> _chars;
+            Image::Ptr _glyphImage;
+            std::vector<core::Recti> _glyphRects;
             int _maxCharWidth;
             int _maxCharHeight;
             int _tabWidth;
@@ -97,10 +109,25 @@ namespace rpgss {
             _tabWidth = (tabWidth >= 0 ? tabWidth : 0);
         }
 
+        //-----------------------------------------------------------------
         inline const Image*
-        Font::getCharImage(char c) const
+        Font::getGlyphImage() const
+        {
+            return _glyphImage;
+        }
+
+        //-----------------------------------------------------------------
+        inline const core::Recti&
+        Font::getGlyphRect(char c) const
+        {
+            return _glyphRects[(u8)c];
+        }
+
+        //-----------------------------------------------------------------
+        inline int
+        Font::getCharWidth(char c) const
         {
-            return _chars[(u8)c];
+            return _glyphRects[(u8)c].getWidth();
         }
 
     } // namespace graphics
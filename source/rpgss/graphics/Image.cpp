@@ -22,15 +22,19 @@
     THE SOFTWARE.
 */
 
+#include <cassert>
 #include <cstring>
 #include <cstdlib>
 #include <algorithm>
 
-#include <emmintrin.h>
-
-#include "../common/cpuinfo.hpp"
 #include "../debug/debug.hpp"
+#include "ColorMatrix.hpp"
 #include "primitives.hpp"
+#include "renderers.hpp"
+#include "kernels.hpp"
+#include "parallel.hpp"
+#include "pixelpool.hpp"
+#include "textcache.hpp"
 #include "Font.hpp"
 #include "WindowSkin.hpp"
 #include "Image.hpp"
@@ -39,97 +43,580 @@
 namespace rpgss {
     namespace graphics {
 
+        namespace {
+
+            // beyond this many dirty rects, new ones are merged into old ones
+            const int MaxDirtyRects = 16;
+
+            //-----------------------------------------------------------------
+            // the size in bytes has to fit into an int
+            inline bool IsValidSize(int width, int height)
+            {
+                return width > 0 && height > 0 && width <= 0x7FFFFFFF / (int)sizeof(RGBA) / height;
+            }
+
+            //-----------------------------------------------------------------
+            core::Recti BoundingRect(const core::Recti& a, const core::Recti& b)
+            {
+                core::Recti rect;
+                rect.ul.x = std::min(a.ul.x, b.ul.x);
+                rect.ul.y = std::min(a.ul.y, b.ul.y);
+                rect.lr.x = std::max(a.lr.x, b.lr.x);
+                rect.lr.y = std::max(a.lr.y, b.lr.y);
+                return rect;
+            }
+
+            //-----------------------------------------------------------------
+            core::Recti BoundingRect(const core::Vec2i* points, int count)
+            {
+                core::Recti rect(points[0].x, points[0].y, 1, 1);
+                for (int i = 1; i < count; i++) {
+                    rect = BoundingRect(rect, core::Recti(points[i].x, points[i].y, 1, 1));
+                }
+                return rect;
+            }
+
+            //-----------------------------------------------------------------
+            core::Recti BoundingRect(const std::vector<Font::Glyph>& glyphs)
+            {
+                core::Recti rect;
+                for (int i = 0; i < (int)glyphs.size(); i++) {
+                    if (glyphs[i].dstRect.isEmpty()) {
+                        continue;
+                    }
+                    rect = (rect.isEmpty() ? glyphs[i].dstRect : BoundingRect(rect, glyphs[i].dstRect));
+                }
+                return rect;
+            }
+
+            //-----------------------------------------------------------------
+            // blit kernel for drawing an already resampled scanline
+            kernels::BlitFunc GetBlitKernel(int blendMode, const Image* source, int alphaClass)
+            {
+                switch (blendMode) {
+                case BlendMode::Set:      return kernels::Table.set;
+                case BlendMode::Mix:
+                    switch (alphaClass) {
+                    case AlphaClass::Opaque: return kernels::Table.setRgb;
+                    case AlphaClass::Binary: return kernels::Table.setRgbMasked;
+                    default:
+                        return source->isPremultiplied() ? kernels::Table.mixPremul : kernels::Table.mix;
+                    }
+                case BlendMode::Add:      return kernels::Table.add;
+                case BlendMode::Subtract: return kernels::Table.sub;
+                case BlendMode::Multiply: return kernels::Table.mul;
+                default:
+                    return 0;
+                }
+            }
+
+            //-----------------------------------------------------------------
+            // straight colors are weighted by their alpha when interpolated,
+            // otherwise invisible texels bleed into the edges of the visible ones
+            kernels::SampleFunc GetSampleKernel(const Image* source, int filter)
+            {
+                if (filter != FilterMode::Bilinear) {
+                    return kernels::Table.sampleNearest;
+                }
+                if (source->isPremultiplied() || source->getAlphaClass() == AlphaClass::Opaque) {
+                    return kernels::Table.sampleBilinear;
+                }
+                return kernels::Table.sampleBilinearStraight;
+            }
+
+            //-----------------------------------------------------------------
+            kernels::BlitColFunc GetBlitColKernel(int blendMode, const Image* source)
+            {
+                switch (blendMode) {
+                case BlendMode::Set:      return kernels::Table.setCol;
+                case BlendMode::Mix:      return source->isPremultiplied() ? kernels::Table.mixPremulCol : kernels::Table.mixCol;
+                case BlendMode::Add:      return kernels::Table.addCol;
+                case BlendMode::Subtract: return kernels::Table.subCol;
+                case BlendMode::Multiply: return kernels::Table.mulCol;
+                default:
+                    return 0;
+                }
+            }
+
+            //-----------------------------------------------------------------
+            // band functors for parallel::ForEachBand, y1 and y2 are
+            // relative to the first row of the operation
+
+            struct ClearBand {
+                RGBA* pixels;
+                int   pitch;
+                int   width;
+                RGBA  color;
+
+                void operator()(int y1, int y2) {
+                    kernels::Table.clear(pixels + y1 * pitch, pitch, width, y2 - y1, color);
+                }
+            };
+
+            struct PixelBand {
+                kernels::PixelFunc func;
+                RGBA*              pixels;
+                int                pitch;
+                int                width;
+
+                void operator()(int y1, int y2) {
+                    func(pixels + y1 * pitch, pitch, width, y2 - y1);
+                }
+            };
+
+            struct PixelArgBand {
+                kernels::PixelArgFunc func;
+                RGBA*                 pixels;
+                int                   pitch;
+                int                   width;
+                int                   arg;
+
+                void operator()(int y1, int y2) {
+                    func(pixels + y1 * pitch, pitch, width, y2 - y1, arg);
+                }
+            };
+
+            // exchanges the rows of the upper half with the lower half
+            struct SwapRowsBand {
+                RGBA* pixels;
+                int   pitch;
+                int   width;
+                int   height;
+
+                void operator()(int y1, int y2) {
+                    for (int iy = y1; iy < y2; iy++) {
+                        kernels::Table.swap(pixels + iy * pitch, pixels + (height - 1 - iy) * pitch, width);
+                    }
+                }
+            };
+
+            // like SwapRowsBand, but mirrors the rows while exchanging them
+            struct SwapMirroredRowsBand {
+                RGBA* pixels;
+                int   pitch;
+                int   width;
+                int   height;
+
+                void operator()(int y1, int y2) {
+                    for (int iy = y1; iy < y2; iy++) {
+                        kernels::Table.swapMirrored(pixels + iy * pitch, pixels + (height - 1 - iy) * pitch, width);
+                    }
+                }
+            };
+
+            // writes the source rows to the destination columns
+            struct TransposeBand {
+                RGBA*       dst;
+                int         dstPitch;
+                const RGBA* src;
+                int         srcPitch;
+                int         width;
+
+                void operator()(int y1, int y2) {
+                    kernels::Table.transpose(dst + y1, dstPitch, src + y1 * srcPitch, srcPitch, width, y2 - y1);
+                }
+            };
+
+            struct PremultiplyBand {
+                RGBA* pixels;
+                int   pitch;
+                int   width;
+
+                void operator()(int y1, int y2) {
+                    for (int iy = y1; iy < y2; iy++) {
+                        RGBA* p = pixels + iy * pitch;
+                        int   i = width;
+                        while (i > 0) {
+                            *p = PremultiplyRGBA(*p);
+                            ++p;
+                            --i;
+                        }
+                    }
+                }
+            };
+
+            struct UnpremultiplyBand {
+                RGBA* pixels;
+                int   pitch;
+                int   width;
+
+                void operator()(int y1, int y2) {
+                    for (int iy = y1; iy < y2; iy++) {
+                        RGBA* p = pixels + iy * pitch;
+                        int   i = width;
+                        while (i > 0) {
+                            *p = UnpremultiplyRGBA(*p);
+                            ++p;
+                            --i;
+                        }
+                    }
+                }
+            };
+
+            struct MatrixBand {
+                kernels::MatrixFunc func;
+                RGBA*               pixels;
+                int                 pitch;
+                int                 width;
+                const int*          matrix;
+
+                void operator()(int y1, int y2) {
+                    func(pixels + y1 * pitch, pitch, width, y2 - y1, matrix);
+                }
+            };
+
+            // applies the matrix to straight colors of premultiplied pixels
+            struct StraightMatrixBand {
+                RGBA*      pixels;
+                int        pitch;
+                int        width;
+                const int* matrix;
+
+                void operator()(int y1, int y2) {
+                    for (int iy = y1; iy < y2; iy++) {
+                        RGBA* row = pixels + iy * pitch;
+                        for (int ix = 0; ix < width; ix++) {
+                            row[ix] = UnpremultiplyRGBA(row[ix]);
+                        }
+                        kernels::Table.colorMatrix(row, pitch, width, 1, matrix);
+                        for (int ix = 0; ix < width; ix++) {
+                            row[ix] = PremultiplyRGBA(row[ix]);
+                        }
+                    }
+                }
+            };
+
+            struct BlurRowsBand {
+                RGBA*       dst;
+                int         dstPitch;
+                const RGBA* src;
+                int         srcPitch;
+                int         width;
+                int         radius;
+
+                void operator()(int y1, int y2) {
+                    kernels::Table.blurRows(dst + y1 * dstPitch, dstPitch, src + y1 * srcPitch, srcPitch, width, y2 - y1, radius);
+                }
+            };
+
+            // split into vertical bands, x1 and x2 are columns
+            struct BlurColumnsBand {
+                RGBA*       dst;
+                int         dstPitch;
+                const RGBA* src;
+                int         srcPitch;
+                int         height;
+                int         radius;
+
+                void operator()(int x1, int x2) {
+                    kernels::Table.blurColumns(dst + x1, dstPitch, src + x1, srcPitch, x2 - x1, height, radius);
+                }
+            };
+
+            struct BlitBand {
+                kernels::BlitFunc func;
+                RGBA*             dst;
+                int               dstPitch;
+                const RGBA*       src;
+                int               srcPitch;
+                int               width;
+
+                void operator()(int y1, int y2) {
+                    func(dst + y1 * dstPitch, dstPitch, src + y1 * srcPitch, srcPitch, width, y2 - y1);
+                }
+            };
+
+            struct BlitColBand {
+                kernels::BlitColFunc func;
+                RGBA*                dst;
+                int                  dstPitch;
+                const RGBA*          src;
+                int                  srcPitch;
+                int                  width;
+                RGBA                 color;
+
+                void operator()(int y1, int y2) {
+                    func(dst + y1 * dstPitch, dstPitch, src + y1 * srcPitch, srcPitch, width, y2 - y1, color);
+                }
+            };
+
+        } // anonymous namespace
+
+        //-----------------------------------------------------------------
+        // pixel storage, shared by clones and views
+        class Image::Buffer : public RefCountedObject {
+        public:
+            explicit Buffer(int size)
+                : pixels((RGBA*)pixelpool::Allocate(size))
+            {
+            }
+
+            Buffer(RGBA* pixels, RefCountedObject* owner)
+                : pixels(pixels)
+                , owner(owner)
+            {
+            }
+
+            ~Buffer() {
+                if (!owner) {
+                    pixelpool::Free(pixels);
+                }
+            }
+
+            RGBA* pixels;
+            RefCountedObject::Ptr owner; // 0 if the pixels come from the pool
+        };
+
         //-----------------------------------------------------------------
         Image::Ptr
         Image::New(int width, int height)
         {
-            if (width * height <= 0) {
+            if (!IsValidSize(width, height)) {
                 return 0;
             }
-            return new Image(width, height);
+            Image::Ptr image = new Image(width, height);
+            if (!image->_pixels) {
+                return 0; // out of memory
+            }
+            return image;
         }
 
         //-----------------------------------------------------------------
         Image::Ptr
         Image::New(int width, int height, RGBA color)
         {
-            if (width * height <= 0) {
+            if (!IsValidSize(width, height)) {
+                return 0;
+            }
+            Image::Ptr image = new Image(width, height, color);
+            if (!image->_pixels) {
                 return 0;
             }
-            return new Image(width, height, color);
+            return image;
         }
 
         //-----------------------------------------------------------------
         Image::Ptr
         Image::New(int width, int height, const RGBA* pixels)
         {
-            if (width * height <= 0 || !pixels) {
+            if (!IsValidSize(width, height) || !pixels) {
+                return 0;
+            }
+            Image::Ptr image = new Image(width, height, pixels);
+            if (!image->_pixels) {
+                return 0;
+            }
+            return image;
+        }
+
+        //-----------------------------------------------------------------
+        Image::Ptr
+        Image::New(int width, int height, RGBA* pixels, RefCountedObject* owner)
+        {
+            if (!IsValidSize(width, height) || !pixels || !owner) {
+                return 0;
+            }
+            return new Image(width, height, new Buffer(pixels, owner));
+        }
+
+        //-----------------------------------------------------------------
+        Image::Ptr
+        Image::view(const core::Recti& rect)
+        {
+            if (rect.isEmpty() || !rect.isInside(0, 0, _width, _height)) {
                 return 0;
             }
-            return new Image(width, height, pixels);
+
+            // writes through the view must not show in our clones
+            if (!_parent) {
+                makeUnique();
+            }
+
+            return new Image(this, rect);
+        }
+
+        //-----------------------------------------------------------------
+        Image::Ptr
+        Image::clone() const
+        {
+            Image::Ptr image;
+
+            if (_parent || _viewCount > 0) {
+                image = New(_width, _height);
+                kernels::Table.set(image->_pixels, image->_pitch, _pixels, _pitch, _width, _height);
+            } else {
+                image = new Image(_width, _height, _buffer.get());
+                if (_alphaClassGeneration == _generation) {
+                    image->_alphaClass           = _alphaClass;
+                    image->_alphaClassGeneration = image->_generation;
+                }
+            }
+
+            image->_premultiplied = isPremultiplied();
+            return image;
         }
 
         //-----------------------------------------------------------------
         Image::Image(int width, int height)
             : _width(width)
             , _height(height)
+            , _pitch(width)
             , _pixels(0)
             , _clipRect(width, height)
+            , _premultiplied(false)
+            , _useSpanTable(false)
+            , _trackDirty(false)
+            , _viewCount(0)
+            , _generation(1)
+            , _spanTableGeneration(0)
+            , _alphaClassGeneration(0)
+            , _alphaClass(AlphaClass::Translucent)
         {
-            _pixels = allocatePixels(width, height);
+            _buffer = allocateBuffer(width, height);
+            _pixels = _buffer->pixels;
         }
 
         //-----------------------------------------------------------------
         Image::Image(int width, int height, RGBA color)
             : _width(width)
             , _height(height)
+            , _pitch(width)
             , _pixels(0)
             , _clipRect(width, height)
+            , _premultiplied(false)
+            , _useSpanTable(false)
+            , _trackDirty(false)
+            , _viewCount(0)
+            , _generation(1)
+            , _spanTableGeneration(0)
+            , _alphaClassGeneration(0)
+            , _alphaClass(AlphaClass::Translucent)
         {
-            _pixels = allocatePixels(width, height);
-            clear(color);
+            _buffer = allocateBuffer(width, height);
+            _pixels = _buffer->pixels;
+            if (_pixels) {
+                clear(color);
+            }
         }
 
         //-----------------------------------------------------------------
         Image::Image(int width, int height, const RGBA* pixels)
             : _width(width)
             , _height(height)
+            , _pitch(width)
             , _pixels(0)
             , _clipRect(width, height)
+            , _premultiplied(false)
+            , _useSpanTable(false)
+            , _trackDirty(false)
+            , _viewCount(0)
+            , _generation(1)
+            , _spanTableGeneration(0)
+            , _alphaClassGeneration(0)
+            , _alphaClass(AlphaClass::Translucent)
+        {
+            _buffer = allocateBuffer(width, height);
+            _pixels = _buffer->pixels;
+            if (_pixels) {
+                std::memcpy(_pixels, pixels, getSizeInBytes());
+            }
+        }
+
+        //-----------------------------------------------------------------
+        Image::Image(Image* parent, const core::Recti& rect)
+            : _width(rect.getWidth())
+            , _height(rect.getHeight())
+            , _pitch(parent->_pitch)
+            , _pixels(parent->_pixels + rect.getY() * parent->_pitch + rect.getX())
+            , _clipRect(rect.getWidth(), rect.getHeight())
+            , _premultiplied(parent->_premultiplied)
+            , _useSpanTable(false)
+            , _trackDirty(false)
+            , _buffer(parent->_buffer)
+            , _parent(parent->isView() ? parent->_parent.get() : parent)
+            , _offset(parent->_offset + rect.getPosition())
+            , _viewCount(0)
+            , _generation(1)
+            , _spanTableGeneration(0)
+            , _alphaClassGeneration(0)
+            , _alphaClass(AlphaClass::Translucent)
+        {
+            _parent->_viewCount++;
+        }
+
+        //-----------------------------------------------------------------
+        Image::Image(int width, int height, Buffer* buffer)
+            : _width(width)
+            , _height(height)
+            , _pitch(width)
+            , _pixels(buffer->pixels)
+            , _clipRect(width, height)
+            , _premultiplied(false)
+            , _useSpanTable(false)
+            , _trackDirty(false)
+            , _buffer(buffer)
+            , _viewCount(0)
+            , _generation(1)
+            , _spanTableGeneration(0)
+            , _alphaClassGeneration(0)
+            , _alphaClass(AlphaClass::Translucent)
         {
-            _pixels = allocatePixels(width, height);
-            std::memcpy(_pixels, pixels, getSizeInBytes());
         }
 
         //-----------------------------------------------------------------
         Image::~Image()
         {
-            deletePixels(_pixels);
+            if (_parent) {
+                _parent->_viewCount--;
+            }
         }
 
         //-----------------------------------------------------------------
-        RGBA*
-        Image::allocatePixels(int width, int height)
+        Image::Buffer*
+        Image::allocateBuffer(int width, int height)
         {
-            return (RGBA*)std::malloc(width * height * sizeof(RGBA));
+            return new Buffer(width * height * sizeof(RGBA));
         }
 
         //-----------------------------------------------------------------
         void
-        Image::deletePixels(RGBA* pixels)
+        Image::makeUnique()
         {
-            std::free(pixels);
+            // the buffer is also referenced by our views
+            if (_buffer->getRefCount() <= 1 + _viewCount) {
+                return;
+            }
+
+            Buffer* buffer = allocateBuffer(_width, _height);
+            kernels::Table.set(buffer->pixels, _width, _pixels, _pitch, _width, _height);
+
+            _buffer = buffer;
+            _pixels = buffer->pixels;
+            _pitch  = _width;
         }
 
         //-----------------------------------------------------------------
         void
-        Image::reset(int new_width, int new_height, RGBA* new_pixels)
+        Image::reset(int new_width, int new_height, Buffer* new_buffer)
         {
-            deletePixels(_pixels);
+            assert(_viewCount == 0);
+
+            if (_parent) {
+                // detach from the parent's pixels, which are in the parent's form
+                _premultiplied = _parent->_premultiplied;
+                _parent->_viewCount--;
+                _parent = 0;
+                _offset = core::Vec2i(0, 0);
+            }
+            _buffer   = new_buffer;
             _width    = new_width;
             _height   = new_height;
-            _pixels   = new_pixels;
+            _pitch    = new_width;
+            _pixels   = new_buffer->pixels;
             _clipRect = core::Recti(new_width, new_height);
+            _spanTableGeneration  = 0;
+            _alphaClassGeneration = 0;
+            invalidate();
         }
 
         //-----------------------------------------------------------------
@@ -142,1264 +629,836 @@ namespace rpgss {
         }
 
         //-----------------------------------------------------------------
-        Image::Ptr
-        Image::copyRect_generic(const core::Recti& rect, Image* destination)
+        void
+        Image::setUseSpanTable(bool useSpanTable)
         {
-            if (rect.isEmpty() || !rect.isInside(0, 0, _width, _height)) {
-                return 0;
-            }
-
-            int rw = rect.getWidth();
-            int rh = rect.getHeight();
-
-            Image::Ptr image;
-
-            if (destination) {
-                image = destination;
-                image->resize(rw, rh);
-            } else {
-                image = New(rw, rh);
+            _useSpanTable = useSpanTable;
+            if (!useSpanTable) {
+                _spanTable = SpanTable(); // release memory
             }
+            _spanTableGeneration = 0;
+        }
 
-            for (int iy = 0; iy < rh; ++iy) {
-                std::memcpy(
-                    image->getPixels() + iy * image->getWidth(),
-                    _pixels + (iy + rect.getY()) * _width + rect.getX(),
-                    image->getWidth() * sizeof(RGBA)
-                );
+        //-----------------------------------------------------------------
+        void
+        Image::setTrackDirty(bool trackDirty)
+        {
+            _trackDirty = trackDirty;
+            if (!trackDirty) {
+                std::vector<core::Recti>().swap(_dirtyRects); // release memory
             }
-
-            return image;
         }
 
         //-----------------------------------------------------------------
-        Image::Ptr
-        Image::copyRect_sse2(const core::Recti& rect, Image* destination)
+        void
+        Image::clearDirty()
         {
-            if (rect.isEmpty() || !rect.isInside(0, 0, _width, _height)) {
-                return 0;
-            }
+            _dirtyRects.clear();
+        }
 
-            Image::Ptr image;
+        //-----------------------------------------------------------------
+        void
+        Image::markModified(const core::Recti& rect)
+        {
+            Image* owner = (_parent ? _parent.get() : this);
 
-            if (destination) {
-                image = destination;
-                image->resize(rect.getWidth(), rect.getHeight());
-            } else {
-                image = New(rect.getWidth(), rect.getHeight());
+            // clones get their own pixels before the first write
+            if (!_parent) {
+                makeUnique();
             }
 
-            int   si = getWidth() - rect.getWidth();
-            RGBA* sp = getPixels() + rect.getY() * getWidth() + rect.getX();
-
-            RGBA* dp = image->getPixels();
-
-            int burst1 = rect.getWidth() / 4;
-            int burst2 = rect.getWidth() % 4;
-
-            for (int y = 0; y < rect.getHeight(); y++) {
-                for (int i = 0; i < burst1; i++) {
-                    __m128i ms = _mm_loadu_si128((__m128i*)sp);
-                    _mm_storeu_si128((__m128i*)dp, ms);
-                    dp += 4;
-                    sp += 4;
-                }
-
-                for (int i = 0; i < burst2; i++) {
-                    *dp = *sp;
-                    dp++;
-                    sp++;
-                }
-
-                sp += si;
+            // zero is reserved for caches that were never built
+            if (++owner->_generation == 0) {
+                owner->_generation = 1;
             }
 
-            return image;
-        }
-
-        //-------------------- ---------------------------------------------
-        Image::Ptr
-        Image::copyRect(const core::Recti& rect, Image* destination)
-        {
-            if (CpuSupportsSse2()) {
-                return copyRect_sse2(rect, destination);
-            } else {
-                return copyRect_generic(rect, destination);
+            if (_trackDirty) {
+                addDirtyRect(rect);
+            }
+            if (_parent && _parent->_trackDirty) {
+                _parent->addDirtyRect(core::Recti(rect).translate(_offset));
             }
         }
 
         //-----------------------------------------------------------------
         void
-        Image::resize(int new_width, int new_height)
+        Image::addDirtyRect(core::Recti rect)
         {
-            if ((new_width <= 0 || new_height <= 0) || (new_width == _width && new_height == _height)) {
+            rect = rect.getIntersection(core::Recti(_width, _height));
+            if (rect.isEmpty()) {
                 return;
             }
 
-            RGBA* new_pixels = allocatePixels(new_width, new_height);
+            // merge with every rect it overlaps or touches, the grown
+            // rect may reach others, so start over after each merge
+            for (int i = 0; i < (int)_dirtyRects.size(); ) {
+                const core::Recti& dirty = _dirtyRects[i];
+                if (dirty.contains(rect)) {
+                    return;
+                }
+                if (rect.ul.x <= dirty.lr.x + 1 && dirty.ul.x <= rect.lr.x + 1 &&
+                    rect.ul.y <= dirty.lr.y + 1 && dirty.ul.y <= rect.lr.y + 1)
+                {
+                    rect = BoundingRect(rect, dirty);
+                    _dirtyRects.erase(_dirtyRects.begin() + i);
+                    i = 0;
+                } else {
+                    i++;
+                }
+            }
+
+            if ((int)_dirtyRects.size() < MaxDirtyRects) {
+                _dirtyRects.push_back(rect);
+                return;
+            }
 
-            for (int i = 0; i < std::min(_height, new_height); ++i) {
-                std::memcpy(
-                    new_pixels + (i * new_width),
-                    _pixels + (i * _width),
-                    std::min(_width, new_width) * sizeof(RGBA)
-                );
+            // too many rects, grow the one that grows the least
+            int best      = 0;
+            int best_cost = 0;
+            for (int i = 0; i < (int)_dirtyRects.size(); i++) {
+                core::Recti merged = BoundingRect(rect, _dirtyRects[i]);
+                int cost = merged.getWidth() * merged.getHeight() - _dirtyRects[i].getWidth() * _dirtyRects[i].getHeight();
+                if (i == 0 || cost < best_cost) {
+                    best      = i;
+                    best_cost = cost;
+                }
             }
-            reset(new_width, new_height, new_pixels);
+
+            rect = BoundingRect(rect, _dirtyRects[best]);
+            _dirtyRects.erase(_dirtyRects.begin() + best);
+            addDirtyRect(rect);
         }
 
         //-----------------------------------------------------------------
-        void
-        Image::setAlpha(u8 alpha)
+        const SpanTable*
+        Image::getSpanTable() const
         {
-            RGBA* p = _pixels;
-            int   i = _width * _height;
-            while (i > 0) {
-                p->alpha = alpha;
-                ++p;
-                --i;
+            if (!_useSpanTable) {
+                return 0;
             }
+            u32 generation = (_parent ? _parent->_generation : _generation);
+            if (_spanTableGeneration != generation) {
+                _spanTable.build(_pixels, _pitch, _width, _height, isPremultiplied());
+                _spanTableGeneration = generation;
+            }
+            return &_spanTable;
         }
 
         //-----------------------------------------------------------------
-        void
-        Image::clear_generic(RGBA color)
+        int
+        Image::getAlphaClass() const
         {
-            u32* p = (u32*)_pixels;
-            u32  q = *((u32*)&color);
-            int  i = _width * _height;
-            while (i > 0) {
-                *p = q;
-                ++p;
-                --i;
+            u32 generation = (_parent ? _parent->_generation : _generation);
+            if (_alphaClassGeneration == generation) {
+                return _alphaClass;
+            }
+
+            _alphaClass = AlphaClass::Opaque;
+
+            for (int iy = 0; iy < _height && _alphaClass != AlphaClass::Translucent; iy++) {
+                const RGBA* p = _pixels + iy * _pitch;
+                int         i = _width;
+                while (i > 0) {
+                    if (p->alpha != 255) {
+                        // premultiplied pixels add their color even if fully transparent
+                        if (p->alpha != 0 || (isPremultiplied() && (p->red | p->green | p->blue) != 0)) {
+                            _alphaClass = AlphaClass::Translucent;
+                            break;
+                        }
+                        _alphaClass = AlphaClass::Binary;
+                    }
+                    ++p;
+                    --i;
+                }
             }
+
+            _alphaClassGeneration = generation;
+            return _alphaClass;
         }
 
         //-----------------------------------------------------------------
-        void
-        Image::clear_sse2(RGBA color)
+        int
+        Image::getSampledAlphaClass(const Image* source, int filter) const
         {
-            int num_pixels = _width * _height;
-
-            int burst1 = ((int)_pixels % 16) / 4;
-            int burst2 = (num_pixels - burst1) / 4;
-            int burst3 = num_pixels - (burst1 + burst2 * 4);
-
-            RGBA* dp = _pixels;
-
-            for (int i = 0; i < burst1; i++) {
-                *dp = color;
-                dp++;
+            // our own alpha class would describe the pixels before drawing
+            if (sharesPixels(source)) {
+                return AlphaClass::Translucent;
             }
 
-            __m128i mcolor  = _mm_set_epi8(
-                color.alpha, color.blue, color.green, color.red,
-                color.alpha, color.blue, color.green, color.red,
-                color.alpha, color.blue, color.green, color.red,
-                color.alpha, color.blue, color.green, color.red
-            );
+            int alphaClass = source->getAlphaClass();
 
-            for (int i = 0; i < burst2; i++) {
-                _mm_store_si128((__m128i*)dp, mcolor);
-                dp += 4;
+            // interpolation blends the edges of binary masks
+            if (alphaClass == AlphaClass::Binary && filter == FilterMode::Bilinear) {
+                return AlphaClass::Translucent;
             }
 
-            for (int i = 0; i < burst3; i++) {
-                *dp = color;
-                dp++;
-            }
+            return alphaClass;
         }
 
         //-----------------------------------------------------------------
-        void
-        Image::clear(RGBA color)
+        bool
+        Image::sharesPixels(const Image* image) const
         {
-            if (CpuSupportsSse2()) {
-                return clear_sse2(color);
-            } else {
-                return clear_generic(color);
-            }
+            const Image* a = (_parent ? _parent.get() : this);
+            const Image* b = (image->_parent ? image->_parent.get() : image);
+            return a == b;
         }
 
         //-----------------------------------------------------------------
         void
-        Image::grey()
+        Image::premultiply()
         {
-            RGBA* p = _pixels;
-            int   i = _width * _height;
-            while (i > 0) {
-                u8 q = (p->red + p->green + p->blue) / 3;
-                p->red   = q;
-                p->green = q;
-                p->blue  = q;
-                ++p;
-                --i;
+            // views share the pixels and the flag of their owner
+            if (_parent) {
+                _parent->premultiply();
+                return;
             }
-        }
 
-        //-----------------------------------------------------------------
-        void
-        Image::flipHorizontal()
-        {
-            u32* l = (u32*)_pixels;
-            u32* r = (u32*)_pixels + _width - 1;
-
-            int iy = _height;
-            while (iy > 0) {
-                u32* a = l;
-                u32* b = r;
-                int ix = _width / 2;
-                while (ix > 0) {
-                    u32 c = *a;
-                    *a = *b;
-                    *b = c;
-                    a++;
-                    b--;
-                    ix--;
-                }
-                l += _width;
-                r += _width;
-                iy--;
+            if (_premultiplied) {
+                return;
             }
-        }
 
-        //-----------------------------------------------------------------
-        void
-        Image::flipVertical()
-        {
-            u32* u = (u32*)_pixels;
-            u32* d = (u32*)_pixels + _width * (_height - 1);
-
-            int iy = _height / 2;
-            while (iy > 0) {
-                u32* a = u;
-                u32* b = d;
-                int ix = _width;
-                while (ix > 0) {
-                    u32 c = *a;
-                    *a = *b;
-                    *b = c;
-                    a++;
-                    b++;
-                    ix--;
-                }
-                u += _width;
-                d -= _width;
-                iy--;
-            }
-        }
+            invalidate();
 
-        //-----------------------------------------------------------------
-        void
-        Image::rotateClockwise()
-        {
-            RGBA* new_p = allocatePixels(_width, _height);
-            int   new_w = _height;
-            int   new_h = _width;
+            PremultiplyBand band = { _pixels, _pitch, _width };
+            parallel::ForEachBand(_width, _height, band);
 
-            for (int iy = 0; iy < _height; ++iy) {
-                for (int ix = 0; ix < _width; ++ix) {
-                    new_p[new_w * ix + (new_w - (iy + 1))] = _pixels[iy * _width + ix];
-                }
-            }
-            reset(new_w, new_h, new_p);
+            _premultiplied = true;
         }
 
         //-----------------------------------------------------------------
         void
-        Image::rotateCounterClockwise()
+        Image::unpremultiply()
         {
-            RGBA* new_p = allocatePixels(_width, _height);
-            int   new_w = _height;
-            int   new_h = _width;
+            if (_parent) {
+                _parent->unpremultiply();
+                return;
+            }
 
-            for (int iy = 0; iy < _height; ++iy) {
-                for (int ix = 0; ix < _width; ++ix) {
-                    new_p[new_w * (_width - ix - 1) + iy] = _pixels[iy * _width + ix];
-                }
+            if (!_premultiplied) {
+                return;
             }
-            reset(new_w, new_h, new_p);
+
+            invalidate();
+
+            UnpremultiplyBand band = { _pixels, _pitch, _width };
+            parallel::ForEachBand(_width, _height, band);
+
+            _premultiplied = false;
         }
 
         //-----------------------------------------------------------------
-        struct rgba_set {
-            void operator()(RGBA* dst, const RGBA* src) {
-                dst->red   = src->red;
-                dst->green = src->green;
-                dst->blue  = src->blue;
-                dst->alpha = src->alpha;
+        Image::Ptr
+        Image::copyRect(const core::Recti& rect, Image* destination)
+        {
+            if (rect.isEmpty() || !rect.isInside(0, 0, _width, _height)) {
+                return 0;
             }
 
-            void operator()(RGBA* dst, u8 red, u8 green, u8 blue, u8 alpha) {
-                dst->red   = red;
-                dst->green = green;
-                dst->blue  = blue;
-                dst->alpha = alpha;
+            // whole-image copies share the pixels until modified
+            if (!destination && core::Recti(_width, _height) == rect) {
+                return clone();
             }
-        };
 
-        struct rgba_mix {
-            void operator()(RGBA* dst, const RGBA* src) {
-                int sa = src->alpha  + 1;
-                int da = 256 - src->alpha;
-                dst->red   = (dst->red   * da + src->red   * sa) >> 8;
-                dst->green = (dst->green * da + src->green * sa) >> 8;
-                dst->blue  = (dst->blue  * da + src->blue  * sa) >> 8;
-            }
+            Image::Ptr image;
 
-            void operator()(RGBA* dst, u8 red, u8 green, u8 blue, u8 alpha) {
-                int sa = alpha  + 1;
-                int da = 256 - alpha;
-                dst->red   = (dst->red   * da + red   * sa) >> 8;
-                dst->green = (dst->green * da + green * sa) >> 8;
-                dst->blue  = (dst->blue  * da + blue  * sa) >> 8;
+            if (destination) {
+                image = destination;
+                if (!image->resize(rect.getWidth(), rect.getHeight())) {
+                    return 0;
+                }
+                image->invalidate();
+            } else {
+                image = New(rect.getWidth(), rect.getHeight());
             }
-        };
 
-        struct rgba_add {
-            void operator()(RGBA* dst, const RGBA* src) {
-                dst->red   = std::min(dst->red   + src->red,   255);
-                dst->green = std::min(dst->green + src->green, 255);
-                dst->blue  = std::min(dst->blue  + src->blue,  255);
-                dst->alpha = std::min(dst->alpha + src->alpha, 255);
-            }
+            kernels::Table.set(
+                image->getPixels(),
+                image->getPitch(),
+                _pixels + rect.getY() * _pitch + rect.getX(),
+                _pitch,
+                rect.getWidth(),
+                rect.getHeight()
+            );
 
-            void operator()(RGBA* dst, u8 red, u8 green, u8 blue, u8 alpha) {
-                dst->red   = std::min(dst->red   + red,   255);
-                dst->green = std::min(dst->green + green, 255);
-                dst->blue  = std::min(dst->blue  + blue,  255);
-                dst->alpha = std::min(dst->alpha + alpha, 255);
+            if (image->isPremultiplied() != isPremultiplied()) {
+                if (image->_parent || image->_viewCount > 0) {
+                    // the other pixels of a shared destination stay in its form,
+                    // so the copied ones are converted to it
+                    if (image->isPremultiplied()) {
+                        PremultiplyBand band = { image->_pixels, image->_pitch, image->_width };
+                        parallel::ForEachBand(image->_width, image->_height, band);
+                    } else {
+                        UnpremultiplyBand band = { image->_pixels, image->_pitch, image->_width };
+                        parallel::ForEachBand(image->_width, image->_height, band);
+                    }
+                } else {
+                    image->_premultiplied = isPremultiplied();
+                }
             }
-        };
 
-        struct rgba_sub {
-            void operator()(RGBA* dst, const RGBA* src) {
-                dst->red   = std::max(dst->red   - src->red,   0);
-                dst->green = std::max(dst->green - src->green, 0);
-                dst->blue  = std::max(dst->blue  - src->blue,  0);
-                dst->alpha = std::max(dst->alpha - src->alpha, 0);
-            }
+            return image;
+        }
 
-            void operator()(RGBA* dst, u8 red, u8 green, u8 blue, u8 alpha) {
-                dst->red   = std::max(dst->red   - red,   0);
-                dst->green = std::max(dst->green - green, 0);
-                dst->blue  = std::max(dst->blue  - blue,  0);
-                dst->alpha = std::max(dst->alpha - alpha, 0);
+        //-----------------------------------------------------------------
+        bool
+        Image::resize(int new_width, int new_height)
+        {
+            if (new_width <= 0 || new_height <= 0) {
+                return false;
             }
-        };
 
-        struct rgba_mul {
-            void operator()(RGBA* dst, const RGBA* src) {
-                dst->red   = dst->red   * (src->red   + 1) >> 8;
-                dst->green = dst->green * (src->green + 1) >> 8;
-                dst->blue  = dst->blue  * (src->blue  + 1) >> 8;
-                dst->alpha = dst->alpha * (src->alpha + 1) >> 8;
+            if (new_width == _width && new_height == _height) {
+                return true;
             }
 
-            void operator()(RGBA* dst, u8 red, u8 green, u8 blue, u8 alpha) {
-                dst->red   = dst->red   * (red   + 1) >> 8;
-                dst->green = dst->green * (green + 1) >> 8;
-                dst->blue  = dst->blue  * (blue  + 1) >> 8;
-                dst->alpha = dst->alpha * (alpha + 1) >> 8;
+            if (_viewCount > 0) {
+                return false;
             }
-        };
 
-        //-----------------------------------------------------------------
-        void
-        Image::drawPoint(const core::Vec2i& pos, RGBA color, int blendMode)
-        {
-            switch (blendMode) {
-            case BlendMode::Set:      primitives::Point(_pixels, _width, _clipRect, pos, color, rgba_set()); break;
-            case BlendMode::Mix:      primitives::Point(_pixels, _width, _clipRect, pos, color, rgba_mix()); break;
-            case BlendMode::Add:      primitives::Point(_pixels, _width, _clipRect, pos, color, rgba_add()); break;
-            case BlendMode::Subtract: primitives::Point(_pixels, _width, _clipRect, pos, color, rgba_sub()); break;
-            case BlendMode::Multiply: primitives::Point(_pixels, _width, _clipRect, pos, color, rgba_mul()); break;
-            }
-        }
+            Buffer* new_buffer = allocateBuffer(new_width, new_height);
 
-        //-----------------------------------------------------------------
-        void
-        Image::drawLine(const core::Vec2i& startPos, const core::Vec2i& endPos, RGBA color, int blendMode)
-        {
-            switch (blendMode) {
-            case BlendMode::Set:      primitives::Line(_pixels, _width, _clipRect, startPos, endPos, color, rgba_set()); break;
-            case BlendMode::Mix:      primitives::Line(_pixels, _width, _clipRect, startPos, endPos, color, rgba_mix()); break;
-            case BlendMode::Add:      primitives::Line(_pixels, _width, _clipRect, startPos, endPos, color, rgba_add()); break;
-            case BlendMode::Subtract: primitives::Line(_pixels, _width, _clipRect, startPos, endPos, color, rgba_sub()); break;
-            case BlendMode::Multiply: primitives::Line(_pixels, _width, _clipRect, startPos, endPos, color, rgba_mul()); break;
+            for (int i = 0; i < std::min(_height, new_height); ++i) {
+                std::memcpy(
+                    new_buffer->pixels + (i * new_width),
+                    _pixels + (i * _pitch),
+                    std::min(_width, new_width) * sizeof(RGBA)
+                );
             }
+            reset(new_width, new_height, new_buffer);
+            return true;
         }
 
         //-----------------------------------------------------------------
         void
-        Image::drawLine(const core::Vec2i& startPos, const core::Vec2i& endPos, RGBA startColor, RGBA endColor, int blendMode)
+        Image::setAlpha(u8 alpha)
         {
-            switch (blendMode) {
-            case BlendMode::Set:      primitives::Line(_pixels, _width, _clipRect, startPos, endPos, startColor, endColor, rgba_set()); break;
-            case BlendMode::Mix:      primitives::Line(_pixels, _width, _clipRect, startPos, endPos, startColor, endColor, rgba_mix()); break;
-            case BlendMode::Add:      primitives::Line(_pixels, _width, _clipRect, startPos, endPos, startColor, endColor, rgba_add()); break;
-            case BlendMode::Subtract: primitives::Line(_pixels, _width, _clipRect, startPos, endPos, startColor, endColor, rgba_sub()); break;
-            case BlendMode::Multiply: primitives::Line(_pixels, _width, _clipRect, startPos, endPos, startColor, endColor, rgba_mul()); break;
-            }
+            invalidate();
+            PixelArgBand band = { kernels::Table.setAlpha, _pixels, _pitch, _width, alpha };
+            parallel::ForEachBand(_width, _height, band);
         }
 
         //-----------------------------------------------------------------
         void
-        Image::drawRectangle(bool fill, const core::Recti& rect, RGBA color, int blendMode)
+        Image::clear(RGBA color)
         {
-            switch (blendMode) {
-            case BlendMode::Set:      primitives::Rectangle(_pixels, _width, _clipRect, fill, rect, color, rgba_set()); break;
-            case BlendMode::Mix:      primitives::Rectangle(_pixels, _width, _clipRect, fill, rect, color, rgba_mix()); break;
-            case BlendMode::Add:      primitives::Rectangle(_pixels, _width, _clipRect, fill, rect, color, rgba_add()); break;
-            case BlendMode::Subtract: primitives::Rectangle(_pixels, _width, _clipRect, fill, rect, color, rgba_sub()); break;
-            case BlendMode::Multiply: primitives::Rectangle(_pixels, _width, _clipRect, fill, rect, color, rgba_mul()); break;
-            }
+            invalidate();
+            ClearBand band = { _pixels, _pitch, _width, color };
+            parallel::ForEachBand(_width, _height, band);
         }
 
         //-----------------------------------------------------------------
         void
-        Image::drawRectangle(bool fill, const core::Recti& rect, RGBA ulColor, RGBA urColor, RGBA lrColor, RGBA llColor, int blendMode)
+        Image::grey()
         {
-            switch (blendMode) {
-            case BlendMode::Set:      primitives::Rectangle(_pixels, _width, _clipRect, fill, rect, ulColor, urColor, lrColor, llColor, rgba_set()); break;
-            case BlendMode::Mix:      primitives::Rectangle(_pixels, _width, _clipRect, fill, rect, ulColor, urColor, lrColor, llColor, rgba_mix()); break;
-            case BlendMode::Add:      primitives::Rectangle(_pixels, _width, _clipRect, fill, rect, ulColor, urColor, lrColor, llColor, rgba_add()); break;
-            case BlendMode::Subtract: primitives::Rectangle(_pixels, _width, _clipRect, fill, rect, ulColor, urColor, lrColor, llColor, rgba_sub()); break;
-            case BlendMode::Multiply: primitives::Rectangle(_pixels, _width, _clipRect, fill, rect, ulColor, urColor, lrColor, llColor, rgba_mul()); break;
-            }
+            invalidate();
+            PixelBand band = { kernels::Table.grey, _pixels, _pitch, _width };
+            parallel::ForEachBand(_width, _height, band);
         }
 
         //-----------------------------------------------------------------
         void
-        Image::drawCircle(bool fill, const core::Vec2i& center, int radius, RGBA color, int blendMode)
+        Image::invert()
         {
-            switch (blendMode) {
-            case BlendMode::Set:      primitives::Circle(_pixels, _width, _clipRect, fill, center, radius, color, rgba_set()); break;
-            case BlendMode::Mix:      primitives::Circle(_pixels, _width, _clipRect, fill, center, radius, color, rgba_mix()); break;
-            case BlendMode::Add:      primitives::Circle(_pixels, _width, _clipRect, fill, center, radius, color, rgba_add()); break;
-            case BlendMode::Subtract: primitives::Circle(_pixels, _width, _clipRect, fill, center, radius, color, rgba_sub()); break;
-            case BlendMode::Multiply: primitives::Circle(_pixels, _width, _clipRect, fill, center, radius, color, rgba_mul()); break;
-            }
+            invalidate();
+            PixelBand band = { isPremultiplied() ? kernels::Table.invertPremul : kernels::Table.invert, _pixels, _pitch, _width };
+            parallel::ForEachBand(_width, _height, band);
         }
 
         //-----------------------------------------------------------------
         void
-        Image::drawCircle(bool fill, const core::Vec2i& center, int radius, RGBA innerColor, RGBA outerColor, int blendMode)
+        Image::swapChannels(int red, int green, int blue, int alpha)
         {
-            switch (blendMode) {
-            case BlendMode::Set:      primitives::Circle(_pixels, _width, _clipRect, fill, center, radius, innerColor, outerColor, rgba_set()); break;
-            case BlendMode::Mix:      primitives::Circle(_pixels, _width, _clipRect, fill, center, radius, innerColor, outerColor, rgba_mix()); break;
-            case BlendMode::Add:      primitives::Circle(_pixels, _width, _clipRect, fill, center, radius, innerColor, outerColor, rgba_add()); break;
-            case BlendMode::Subtract: primitives::Circle(_pixels, _width, _clipRect, fill, center, radius, innerColor, outerColor, rgba_sub()); break;
-            case BlendMode::Multiply: primitives::Circle(_pixels, _width, _clipRect, fill, center, radius, innerColor, outerColor, rgba_mul()); break;
-            }
+            invalidate();
+            PixelArgBand band = { kernels::Table.swizzle, _pixels, _pitch, _width, kernels::SwizzleOrder(red, green, blue, alpha) };
+            parallel::ForEachBand(_width, _height, band);
         }
 
         //-----------------------------------------------------------------
         void
-        Image::drawTriangle(bool fill, const core::Vec2i& p1, const core::Vec2i& p2, const core::Vec2i& p3, RGBA color, int blendMode)
+        Image::multiplyAlpha(u8 alpha)
         {
-            // TODO
-        }
+            invalidate();
 
-        //-----------------------------------------------------------------
-        void
-        Image::drawTriangle(bool fill, const core::Vec2i& p1, const core::Vec2i& p2, const core::Vec2i& p3, RGBA c1, RGBA c2, RGBA c3, int blendMode)
-        {
-            // TODO
+            // premultiplied colors are scaled along with their alpha
+            RGBA color = (isPremultiplied() ? RGBA(alpha, alpha, alpha, alpha) : RGBA(255, 255, 255, alpha));
+
+            BlitColBand band = { kernels::Table.setCol, _pixels, _pitch, _pixels, _pitch, _width, color };
+            parallel::ForEachBand(_width, _height, band);
         }
 
         //-----------------------------------------------------------------
-        struct rgba_set_col
+        void
+        Image::applyColorMatrix(const ColorMatrix& matrix)
         {
-            RGBA c;
-
-            explicit rgba_set_col(RGBA color)
-                : c(color)
-            {
+            if (_clipRect.isEmpty() || matrix.isIdentity()) {
+                return;
             }
 
-            void operator()(RGBA* dst, const RGBA* src) {
-                dst->red   = src->red   * (c.red   + 1) >> 8;
-                dst->green = src->green * (c.green + 1) >> 8;
-                dst->blue  = src->blue  * (c.blue  + 1) >> 8;
-                dst->alpha = src->alpha * (c.alpha + 1) >> 8;
-            }
-        };
+            invalidate(_clipRect);
 
-        //-----------------------------------------------------------------
-        struct rgba_mix_col
-        {
-            RGBA c;
+            RGBA* pixels = _pixels + _clipRect.ul.y * _pitch + _clipRect.ul.x;
+            int   width  = _clipRect.getWidth();
+            int   height = _clipRect.getHeight();
 
-            explicit rgba_mix_col(RGBA color)
-                : c(color)
-            {
-            }
+            int fixed[20];
+            matrix.toFixed(fixed);
 
-            void operator()(RGBA* dst, const RGBA* src) {
-                int sa = (src->alpha * (c.alpha + 1) >> 8) + 1;
-                int da = 256 - (sa - 1);
-                dst->red   = (dst->red   * da + (src->red   * (c.red   + 1) >> 8) * sa) >> 8;
-                dst->green = (dst->green * da + (src->green * (c.green + 1) >> 8) * sa) >> 8;
-                dst->blue  = (dst->blue  * da + (src->blue  * (c.blue  + 1) >> 8) * sa) >> 8;
+            if (!isPremultiplied()) {
+                MatrixBand band = { kernels::Table.colorMatrix, pixels, _pitch, width, fixed };
+                parallel::ForEachBand(width, height, band);
+            } else if (matrix.keepsAlpha()) {
+                // offsets scale with alpha, which makes them alpha coefficients
+                for (int i = 0; i < 3; i++) {
+                    int offset = fixed[i * 5 + 4];
+                    fixed[i * 5 + 3] = (offset >= 0 ? offset + 127 : offset - 127) / 255;
+                    fixed[i * 5 + 4] = 0;
+                }
+                MatrixBand band = { kernels::Table.colorMatrixPremul, pixels, _pitch, width, fixed };
+                parallel::ForEachBand(width, height, band);
+            } else {
+                StraightMatrixBand band = { pixels, _pitch, width, fixed };
+                parallel::ForEachBand(width, height, band);
             }
-        };
+        }
 
         //-----------------------------------------------------------------
-        struct rgba_add_col
+        void
+        Image::blur(int radius, int passes)
         {
-            RGBA c;
-
-            explicit rgba_add_col(RGBA color)
-                : c(color)
-            {
+            radius = std::min(radius, kernels::MaxBoxBlurRadius);
+            if (radius < 1 || passes < 1 || _clipRect.isEmpty()) {
+                return;
             }
 
-            void operator()(RGBA* dst, const RGBA* src) {
-                dst->red   = std::min(dst->red   + (src->red   * (c.red   + 1) >> 8), 255);
-                dst->green = std::min(dst->green + (src->green * (c.green + 1) >> 8), 255);
-                dst->blue  = std::min(dst->blue  + (src->blue  * (c.blue  + 1) >> 8), 255);
-                dst->alpha = std::min(dst->alpha + (src->alpha * (c.alpha + 1) >> 8), 255);
-            }
-        };
+            // straight colors would let invisible pixels bleed into the visible ones
+            bool premultiply = (!isPremultiplied() && getAlphaClass() != AlphaClass::Opaque);
 
-        //-----------------------------------------------------------------
-        struct rgba_sub_col
-        {
-            RGBA c;
+            invalidate(_clipRect);
 
-            explicit rgba_sub_col(RGBA color)
-                : c(color)
-            {
-            }
+            RGBA* pixels = _pixels + _clipRect.ul.y * _pitch + _clipRect.ul.x;
+            int   width  = _clipRect.getWidth();
+            int   height = _clipRect.getHeight();
 
-            void operator()(RGBA* dst, const RGBA* src) {
-                dst->red   = std::max(dst->red   - (src->red   * (c.red   + 1) >> 8), 0);
-                dst->green = std::max(dst->green - (src->green * (c.green + 1) >> 8), 0);
-                dst->blue  = std::max(dst->blue  - (src->blue  * (c.blue  + 1) >> 8), 0);
-                dst->alpha = std::max(dst->alpha - (src->alpha * (c.alpha + 1) >> 8), 0);
+            if (premultiply) {
+                PremultiplyBand band = { pixels, _pitch, width };
+                parallel::ForEachBand(width, height, band);
             }
-        };
 
-        //-----------------------------------------------------------------
-        struct rgba_mul_col
-        {
-            RGBA c;
+            // the rows go into the temporary pixels and the columns come back
+            RefCountedObjectPtr<Buffer> temp = allocateBuffer(width, height);
 
-            explicit rgba_mul_col(RGBA color)
-                : c(color)
-            {
+            for (int i = 0; i < passes; i++) {
+                BlurRowsBand rows = { temp->pixels, width, pixels, _pitch, width, radius };
+                parallel::ForEachBand(width, height, rows);
+
+                BlurColumnsBand columns = { pixels, _pitch, temp->pixels, width, height, radius };
+                parallel::ForEachBand(height, width, columns);
             }
 
-            void operator()(RGBA* dst, const RGBA* src) {
-                dst->red   = dst->red   * ((src->red   * (c.red   + 1) >> 8) + 1) >> 8;
-                dst->green = dst->green * ((src->green * (c.green + 1) >> 8) + 1) >> 8;
-                dst->blue  = dst->blue  * ((src->blue  * (c.blue  + 1) >> 8) + 1) >> 8;
-                dst->alpha = dst->alpha * ((src->alpha * (c.alpha + 1) >> 8) + 1) >> 8;
+            if (premultiply) {
+                UnpremultiplyBand band = { pixels, _pitch, width };
+                parallel::ForEachBand(width, height, band);
             }
-        };
+        }
 
         //-----------------------------------------------------------------
         void
-        Image::draw_sse2_set(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos)
+        Image::glow(int radius, RGBA color, int passes)
         {
-            if (_clipRect.isEmpty() || image_rect.isEmpty()) {
+            if (_clipRect.isEmpty()) {
                 return;
             }
 
-            core::Recti dst_rect = core::Recti(pos, image_rect.getDimensions()).getIntersection(_clipRect);
+            // the light of each pixel is its color weighted by its coverage
+            Image::Ptr halo = copyRect(_clipRect);
+            halo->premultiply();
+            halo->blur(radius, passes);
 
-            if (dst_rect.isEmpty()) {
-                return;
-            }
-
-            core::Recti src_rect = core::Recti(image_rect.getPosition() + (dst_rect.getPosition() - pos), dst_rect.getDimensions());
-
-            rgba_set fallback_renderer;
-
-            int di = _width - dst_rect.getWidth();
-            RGBA* dp = _pixels + dst_rect.getY() * _width + dst_rect.getX();
-
-            int si = image->getWidth() - src_rect.getWidth();
-            const RGBA* sp = image->getPixels() + src_rect.getY() * image->getWidth() + src_rect.getX();
-
-            int num_blocks    = dst_rect.getWidth() / 4;
-            int num_remaining = dst_rect.getWidth() % 4;
-
-            int iy = dst_rect.getHeight();
-            while (iy > 0) {
-
-                int ix = num_blocks;
-                while (ix > 0) {
-                    __m128i ms;
-
-                    // load
-                    ms = _mm_loadu_si128((__m128i*)sp);
-
-                    // store
-                    _mm_storeu_si128((__m128i*)dp, ms);
-
-                    dp += 4;
-                    sp += 4;
-                    ix--;
-                }
-
-                ix = num_remaining;
-                while (ix > 0) {
-                    fallback_renderer(dp, sp);
-                    dp++;
-                    sp++;
-                    ix--;
-                }
-
-                dp += di;
-                sp += si;
-                iy--;
-            }
+            draw(halo.get(), _clipRect.getPosition(), 0.0, 1.0, color, BlendMode::Add);
         }
 
         //-----------------------------------------------------------------
         void
-        Image::draw_sse2_add(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos)
+        Image::flipHorizontal()
         {
-            if (_clipRect.isEmpty() || image_rect.isEmpty()) {
-                return;
-            }
-
-            core::Recti dst_rect = core::Recti(pos, image_rect.getDimensions()).getIntersection(_clipRect);
-
-            if (dst_rect.isEmpty()) {
-                return;
-            }
-
-            core::Recti src_rect = core::Recti(image_rect.getPosition() + (dst_rect.getPosition() - pos), dst_rect.getDimensions());
-
-            rgba_add fallback_renderer;
-
-            int di = _width - dst_rect.getWidth();
-            RGBA* dp = _pixels + dst_rect.getY() * _width + dst_rect.getX();
-
-            int si = image->getWidth() - src_rect.getWidth();
-            const RGBA* sp = image->getPixels() + src_rect.getY() * image->getWidth() + src_rect.getX();
-
-            int num_blocks    = dst_rect.getWidth() / 4;
-            int num_remaining = dst_rect.getWidth() % 4;
-
-            int iy = dst_rect.getHeight();
-            while (iy > 0) {
-
-                int ix = num_blocks;
-                while (ix > 0) {
-
-                    // load
-                    __m128i md = _mm_loadu_si128((__m128i*)dp);
-                    __m128i ms = _mm_loadu_si128((__m128i*)sp);
-
-                    // add
-                    md = _mm_adds_epu8(md, ms);
-
-                    // store
-                    _mm_storeu_si128((__m128i*)dp, md);
-
-                    dp += 4;
-                    sp += 4;
-                    ix--;
-                }
-
-                ix = num_remaining;
-                while (ix > 0) {
-                    fallback_renderer(dp, sp);
-                    dp++;
-                    sp++;
-                    ix--;
-                }
-
-                dp += di;
-                sp += si;
-                iy--;
-            }
+            invalidate();
+            PixelBand band = { kernels::Table.mirror, _pixels, _pitch, _width };
+            parallel::ForEachBand(_width, _height, band);
         }
 
         //-----------------------------------------------------------------
         void
-        Image::draw_sse2_sub(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos)
+        Image::flipVertical()
         {
-            if (_clipRect.isEmpty() || image_rect.isEmpty()) {
-                return;
-            }
-
-            core::Recti dst_rect = core::Recti(pos, image_rect.getDimensions()).getIntersection(_clipRect);
+            invalidate();
+            SwapRowsBand band = { _pixels, _pitch, _width, _height };
+            parallel::ForEachBand(_width, _height / 2, band);
+        }
 
-            if (dst_rect.isEmpty()) {
-                return;
+        //-----------------------------------------------------------------
+        bool
+        Image::rotateClockwise()
+        {
+            if (_viewCount > 0) {
+                return false;
             }
 
-            core::Recti src_rect = core::Recti(image_rect.getPosition() + (dst_rect.getPosition() - pos), dst_rect.getDimensions());
-
-            rgba_sub fallback_renderer;
+            Buffer* new_b = allocateBuffer(_width, _height);
+            int     new_w = _height;
+            int     new_h = _width;
 
-            int di = _width - dst_rect.getWidth();
-            RGBA* dp = _pixels + dst_rect.getY() * _width + dst_rect.getX();
+            // transposing the rows bottom up turns the image clockwise
+            TransposeBand band = { new_b->pixels, new_w, _pixels + (_height - 1) * _pitch, -_pitch, _width };
+            parallel::ForEachBand(_width, _height, band);
 
-            int si = image->getWidth() - src_rect.getWidth();
-            const RGBA* sp = image->getPixels() + src_rect.getY() * image->getWidth() + src_rect.getX();
-
-            int num_blocks    = dst_rect.getWidth() / 4;
-            int num_remaining = dst_rect.getWidth() % 4;
-
-            int iy = dst_rect.getHeight();
-            while (iy > 0) {
-
-                int ix = num_blocks;
-                while (ix > 0) {
-
-                    // load
-                    __m128i md = _mm_loadu_si128((__m128i*)dp);
-                    __m128i ms = _mm_loadu_si128((__m128i*)sp);
-
-                    // add
-                    md = _mm_subs_epu8(md, ms);
-
-                    // store
-                    _mm_storeu_si128((__m128i*)dp, md);
-
-                    dp += 4;
-                    sp += 4;
-                    ix--;
-                }
-
-                ix = num_remaining;
-                while (ix > 0) {
-                    fallback_renderer(dp, sp);
-                    dp++;
-                    sp++;
-                    ix--;
-                }
-
-                dp += di;
-                sp += si;
-                iy--;
-            }
+            reset(new_w, new_h, new_b);
+            return true;
         }
 
         //-----------------------------------------------------------------
-        void
-        Image::draw_sse2_mul(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos)
+        bool
+        Image::rotateCounterClockwise()
         {
-            if (_clipRect.isEmpty() || image_rect.isEmpty()) {
-                return;
-            }
-
-            core::Recti dst_rect = core::Recti(pos, image_rect.getDimensions()).getIntersection(_clipRect);
-
-            if (dst_rect.isEmpty()) {
-                return;
+            if (_viewCount > 0) {
+                return false;
             }
 
-            core::Recti src_rect = core::Recti(image_rect.getPosition() + (dst_rect.getPosition() - pos), dst_rect.getDimensions());
-
-            rgba_mul fallback_renderer;
-
-            int di = _width - dst_rect.getWidth();
-            RGBA* dp = _pixels + dst_rect.getY() * _width + dst_rect.getX();
-
-            int si = image->getWidth() - src_rect.getWidth();
-            const RGBA* sp = image->getPixels() + src_rect.getY() * image->getWidth() + src_rect.getX();
-
-            int num_blocks    = dst_rect.getWidth() / 4;
-            int num_remaining = dst_rect.getWidth() % 4;
-
-            __m128i mnull = _mm_setzero_si128();
-            __m128i mone  = _mm_set1_epi16(1);
+            Buffer* new_b = allocateBuffer(_width, _height);
+            int     new_w = _height;
+            int     new_h = _width;
 
-            int iy = dst_rect.getHeight();
-            while (iy > 0) {
+            // transposing into the rows bottom up turns the image counterclockwise
+            TransposeBand band = { new_b->pixels + (new_h - 1) * new_w, -new_w, _pixels, _pitch, _width };
+            parallel::ForEachBand(_width, _height, band);
 
-                int ix = num_blocks;
-                while (ix > 0) {
-
-                    // load
-                    __m128i md = _mm_loadu_si128((__m128i*)dp);
-                    __m128i ms = _mm_loadu_si128((__m128i*)sp);
-
-                    // multiply first two
-                    __m128i t1 = _mm_unpacklo_epi8(ms, mnull);
-                    __m128i t2 = _mm_unpacklo_epi8(md, mnull);
-                    t1 = _mm_adds_epu16(t1, mone);
-                    t1 = _mm_mullo_epi16(t1, t2);
-                    t1 = _mm_srli_epi16(t1, 8);
-
-                    // multiply next two
-                    __m128i u1 = _mm_unpackhi_epi8(ms, mnull);
-                    __m128i u2 = _mm_unpackhi_epi8(md, mnull);
-                    u1 = _mm_adds_epu16(u1, mone);
-                    u1 = _mm_mullo_epi16(u1, u2);
-                    u1 = _mm_srli_epi16(u1, 8);
-
-                    // combine
-                    ms = _mm_packus_epi16(t1, u1);
-
-                    // store
-                    _mm_storeu_si128((__m128i*)dp, ms);
+            reset(new_w, new_h, new_b);
+            return true;
+        }
 
-                    dp += 4;
-                    sp += 4;
-                    ix--;
-                }
+        //-----------------------------------------------------------------
+        void
+        Image::rotate180()
+        {
+            invalidate();
 
-                ix = num_remaining;
-                while (ix > 0) {
-                    fallback_renderer(dp, sp);
-                    dp++;
-                    sp++;
-                    ix--;
-                }
+            // one pass instead of flipping twice
+            SwapMirroredRowsBand band = { _pixels, _pitch, _width, _height };
+            parallel::ForEachBand(_width, _height / 2, band);
 
-                dp += di;
-                sp += si;
-                iy--;
+            if (_height % 2 != 0) {
+                kernels::Table.mirror(_pixels + (_height / 2) * _pitch, _pitch, _width, 1);
             }
         }
 
         //-----------------------------------------------------------------
         void
-        Image::draw_sse2_set(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, RGBA color)
+        Image::drawPoint(const core::Vec2i& pos, RGBA color, int blendMode)
         {
-            if (_clipRect.isEmpty() || image_rect.isEmpty()) {
-                return;
+            invalidate(core::Recti(pos.x, pos.y, 1, 1));
+            switch (blendMode) {
+            case BlendMode::Set:      primitives::Point(_pixels, _pitch, _clipRect, pos, color, rgba_set()); break;
+            case BlendMode::Mix:      primitives::Point(_pixels, _pitch, _clipRect, pos, color, rgba_mix()); break;
+            case BlendMode::Add:      primitives::Point(_pixels, _pitch, _clipRect, pos, color, rgba_add()); break;
+            case BlendMode::Subtract: primitives::Point(_pixels, _pitch, _clipRect, pos, color, rgba_sub()); break;
+            case BlendMode::Multiply: primitives::Point(_pixels, _pitch, _clipRect, pos, color, rgba_mul()); break;
             }
+        }
 
-            core::Recti dst_rect = core::Recti(pos, image_rect.getDimensions()).getIntersection(_clipRect);
-
-            if (dst_rect.isEmpty()) {
-                return;
+        //-----------------------------------------------------------------
+        void
+        Image::drawLine(const core::Vec2i& startPos, const core::Vec2i& endPos, RGBA color, int blendMode)
+        {
+            core::Vec2i points[2] = { startPos, endPos };
+            invalidate(BoundingRect(points, 2));
+            switch (blendMode) {
+            case BlendMode::Set:      primitives::Line(_pixels, _pitch, _clipRect, startPos, endPos, color, rgba_set()); break;
+            case BlendMode::Mix:      primitives::Line(_pixels, _pitch, _clipRect, startPos, endPos, color, rgba_mix()); break;
+            case BlendMode::Add:      primitives::Line(_pixels, _pitch, _clipRect, startPos, endPos, color, rgba_add()); break;
+            case BlendMode::Subtract: primitives::Line(_pixels, _pitch, _clipRect, startPos, endPos, color, rgba_sub()); break;
+            case BlendMode::Multiply: primitives::Line(_pixels, _pitch, _clipRect, startPos, endPos, color, rgba_mul()); break;
             }
+        }
 
-            core::Recti src_rect = core::Recti(image_rect.getPosition() + (dst_rect.getPosition() - pos), dst_rect.getDimensions());
-
-            rgba_set_col fallback_renderer(color);
-
-            int di = _width - dst_rect.getWidth();
-            RGBA* dp = _pixels + dst_rect.getY() * _width + dst_rect.getX();
-
-            int si = image->getWidth() - src_rect.getWidth();
-            const RGBA* sp = image->getPixels() + src_rect.getY() * image->getWidth() + src_rect.getX();
-
-            int num_blocks    = dst_rect.getWidth() / 4;
-            int num_remaining = dst_rect.getWidth() % 4;
-
-            __m128i mcol  = _mm_set_epi16(color.alpha + 1, color.blue + 1, color.green + 1, color.red + 1, color.alpha + 1, color.blue + 1, color.green + 1, color.red + 1);
-            __m128i mnull = _mm_setzero_si128();
-
-            int iy = dst_rect.getHeight();
-            while (iy > 0) {
-
-                int ix = num_blocks;
-                while (ix > 0) {
-                    __m128i ms, t1, t2;
-
-                    // load
-                    ms = _mm_loadu_si128((__m128i*)sp);
-
-                    // process
-                    t1 = _mm_unpacklo_epi8(ms, mnull);
-                    t2 = _mm_unpackhi_epi8(ms, mnull);
-                    t1 = _mm_mullo_epi16(t1, mcol);
-                    t2 = _mm_mullo_epi16(t2, mcol);
-                    t1 = _mm_srli_epi16(t1, 8);
-                    t2 = _mm_srli_epi16(t2, 8);
-                    t1 = _mm_packus_epi16(t1, t2);
-
-                    // store
-                    _mm_storeu_si128((__m128i*)dp, t1);
-
-                    dp += 4;
-                    sp += 4;
-                    ix--;
-                }
-
-                ix = num_remaining;
-                while (ix > 0) {
-                    fallback_renderer(dp, sp);
-                    dp++;
-                    sp++;
-                    ix--;
-                }
-
-                dp += di;
-                sp += si;
-                iy--;
+        //-----------------------------------------------------------------
+        void
+        Image::drawLine(const core::Vec2i& startPos, const core::Vec2i& endPos, RGBA startColor, RGBA endColor, int blendMode)
+        {
+            core::Vec2i points[2] = { startPos, endPos };
+            invalidate(BoundingRect(points, 2));
+            switch (blendMode) {
+            case BlendMode::Set:      primitives::Line(_pixels, _pitch, _clipRect, startPos, endPos, startColor, endColor, rgba_set()); break;
+            case BlendMode::Mix:      primitives::Line(_pixels, _pitch, _clipRect, startPos, endPos, startColor, endColor, rgba_mix()); break;
+            case BlendMode::Add:      primitives::Line(_pixels, _pitch, _clipRect, startPos, endPos, startColor, endColor, rgba_add()); break;
+            case BlendMode::Subtract: primitives::Line(_pixels, _pitch, _clipRect, startPos, endPos, startColor, endColor, rgba_sub()); break;
+            case BlendMode::Multiply: primitives::Line(_pixels, _pitch, _clipRect, startPos, endPos, startColor, endColor, rgba_mul()); break;
             }
         }
 
         //-----------------------------------------------------------------
         void
-        Image::draw_sse2_add(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, RGBA color)
+        Image::drawRectangle(bool fill, const core::Recti& rect, RGBA color, int blendMode)
         {
-            if (_clipRect.isEmpty() || image_rect.isEmpty()) {
-                return;
+            invalidate(rect);
+            switch (blendMode) {
+            case BlendMode::Set:      primitives::Rectangle(_pixels, _pitch, _clipRect, fill, rect, color, rgba_set()); break;
+            case BlendMode::Mix:      primitives::Rectangle(_pixels, _pitch, _clipRect, fill, rect, color, rgba_mix()); break;
+            case BlendMode::Add:      primitives::Rectangle(_pixels, _pitch, _clipRect, fill, rect, color, rgba_add()); break;
+            case BlendMode::Subtract: primitives::Rectangle(_pixels, _pitch, _clipRect, fill, rect, color, rgba_sub()); break;
+            case BlendMode::Multiply: primitives::Rectangle(_pixels, _pitch, _clipRect, fill, rect, color, rgba_mul()); break;
             }
+        }
 
-            core::Recti dst_rect = core::Recti(pos, image_rect.getDimensions()).getIntersection(_clipRect);
-
-            if (dst_rect.isEmpty()) {
-                return;
+        //-----------------------------------------------------------------
+        void
+        Image::drawRectangle(bool fill, const core::Recti& rect, RGBA ulColor, RGBA urColor, RGBA lrColor, RGBA llColor, int blendMode)
+        {
+            invalidate(rect);
+            switch (blendMode) {
+            case BlendMode::Set:      primitives::Rectangle(_pixels, _pitch, _clipRect, fill, rect, ulColor, urColor, lrColor, llColor, rgba_set()); break;
+            case BlendMode::Mix:      primitives::Rectangle(_pixels, _pitch, _clipRect, fill, rect, ulColor, urColor, lrColor, llColor, rgba_mix()); break;
+            case BlendMode::Add:      primitives::Rectangle(_pixels, _pitch, _clipRect, fill, rect, ulColor, urColor, lrColor, llColor, rgba_add()); break;
+            case BlendMode::Subtract: primitives::Rectangle(_pixels, _pitch, _clipRect, fill, rect, ulColor, urColor, lrColor, llColor, rgba_sub()); break;
+            case BlendMode::Multiply: primitives::Rectangle(_pixels, _pitch, _clipRect, fill, rect, ulColor, urColor, lrColor, llColor, rgba_mul()); break;
             }
+        }
 
-            core::Recti src_rect = core::Recti(image_rect.getPosition() + (dst_rect.getPosition() - pos), dst_rect.getDimensions());
-
-            rgba_add_col fallback_renderer(color);
-
-            int di = _width - dst_rect.getWidth();
-            RGBA* dp = _pixels + dst_rect.getY() * _width + dst_rect.getX();
-
-            int si = image->getWidth() - src_rect.getWidth();
-            const RGBA* sp = image->getPixels() + src_rect.getY() * image->getWidth() + src_rect.getX();
-
-            int num_blocks    = dst_rect.getWidth() / 4;
-            int num_remaining = dst_rect.getWidth() % 4;
-
-            __m128i mcol  = _mm_set_epi16(color.alpha + 1, color.blue + 1, color.green + 1, color.red + 1, color.alpha + 1, color.blue + 1, color.green + 1, color.red + 1);
-            __m128i mnull = _mm_setzero_si128();
-
-            int iy = dst_rect.getHeight();
-            while (iy > 0) {
-
-                int ix = num_blocks;
-                while (ix > 0) {
-                    __m128i md, ms, t1, t2;
-
-                    // load
-                    md = _mm_loadu_si128((__m128i*)dp);
-                    ms = _mm_loadu_si128((__m128i*)sp);
-
-                    // multiply
-                    t1 = _mm_unpacklo_epi8(ms, mnull);
-                    t2 = _mm_unpackhi_epi8(ms, mnull);
-                    t1 = _mm_mullo_epi16(t1, mcol);
-                    t2 = _mm_mullo_epi16(t2, mcol);
-                    t1 = _mm_srli_epi16(t1, 8);
-                    t2 = _mm_srli_epi16(t2, 8);
-                    t1 = _mm_packus_epi16(t1, t2);
-
-                    // add
-                    t1 = _mm_adds_epu8(md, t1);
-
-                    // store
-                    _mm_storeu_si128((__m128i*)dp, t1);
-
-                    dp += 4;
-                    sp += 4;
-                    ix--;
-                }
-
-                ix = num_remaining;
-                while (ix > 0) {
-                    fallback_renderer(dp, sp);
-                    dp++;
-                    sp++;
-                    ix--;
-                }
-
-                dp += di;
-                sp += si;
-                iy--;
+        //-----------------------------------------------------------------
+        void
+        Image::drawCircle(bool fill, const core::Vec2i& center, int radius, RGBA color, int blendMode)
+        {
+            invalidate(core::Recti(center.x - radius, center.y - radius, radius * 2, radius * 2));
+            switch (blendMode) {
+            case BlendMode::Set:      primitives::Circle(_pixels, _pitch, _clipRect, fill, center, radius, color, rgba_set()); break;
+            case BlendMode::Mix:      primitives::Circle(_pixels, _pitch, _clipRect, fill, center, radius, color, rgba_mix()); break;
+            case BlendMode::Add:      primitives::Circle(_pixels, _pitch, _clipRect, fill, center, radius, color, rgba_add()); break;
+            case BlendMode::Subtract: primitives::Circle(_pixels, _pitch, _clipRect, fill, center, radius, color, rgba_sub()); break;
+            case BlendMode::Multiply: primitives::Circle(_pixels, _pitch, _clipRect, fill, center, radius, color, rgba_mul()); break;
             }
         }
 
         //-----------------------------------------------------------------
         void
-        Image::draw_sse2_sub(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, RGBA color)
+        Image::drawCircle(bool fill, const core::Vec2i& center, int radius, RGBA innerColor, RGBA outerColor, int blendMode)
         {
-            if (_clipRect.isEmpty() || image_rect.isEmpty()) {
-                return;
+            invalidate(core::Recti(center.x - radius, center.y - radius, radius * 2, radius * 2));
+            switch (blendMode) {
+            case BlendMode::Set:      primitives::Circle(_pixels, _pitch, _clipRect, fill, center, radius, innerColor, outerColor, rgba_set()); break;
+            case BlendMode::Mix:      primitives::Circle(_pixels, _pitch, _clipRect, fill, center, radius, innerColor, outerColor, rgba_mix()); break;
+            case BlendMode::Add:      primitives::Circle(_pixels, _pitch, _clipRect, fill, center, radius, innerColor, outerColor, rgba_add()); break;
+            case BlendMode::Subtract: primitives::Circle(_pixels, _pitch, _clipRect, fill, center, radius, innerColor, outerColor, rgba_sub()); break;
+            case BlendMode::Multiply: primitives::Circle(_pixels, _pitch, _clipRect, fill, center, radius, innerColor, outerColor, rgba_mul()); break;
             }
+        }
 
-            core::Recti dst_rect = core::Recti(pos, image_rect.getDimensions()).getIntersection(_clipRect);
-
-            if (dst_rect.isEmpty()) {
+        //-----------------------------------------------------------------
+        void
+        Image::drawTriangle(bool fill, const core::Vec2i& p1, const core::Vec2i& p2, const core::Vec2i& p3, RGBA color, int blendMode)
+        {
+            if (!fill) {
+                drawLine(p1, p2, color, blendMode);
+                drawLine(p2, p3, color, blendMode);
+                drawLine(p3, p1, color, blendMode);
                 return;
             }
 
-            core::Recti src_rect = core::Recti(image_rect.getPosition() + (dst_rect.getPosition() - pos), dst_rect.getDimensions());
-
-            rgba_sub_col fallback_renderer(color);
-
-            int di = _width - dst_rect.getWidth();
-            RGBA* dp = _pixels + dst_rect.getY() * _width + dst_rect.getX();
-
-            int si = image->getWidth() - src_rect.getWidth();
-            const RGBA* sp = image->getPixels() + src_rect.getY() * image->getWidth() + src_rect.getX();
-
-            int num_blocks    = dst_rect.getWidth() / 4;
-            int num_remaining = dst_rect.getWidth() % 4;
-
-            __m128i mcol  = _mm_set_epi16(color.alpha + 1, color.blue + 1, color.green + 1, color.red + 1, color.alpha + 1, color.blue + 1, color.green + 1, color.red + 1);
-            __m128i mnull = _mm_setzero_si128();
-
-            int iy = dst_rect.getHeight();
-            while (iy > 0) {
-
-                int ix = num_blocks;
-                while (ix > 0) {
-                    __m128i md, ms, t1, t2;
-
-                    // load
-                    md = _mm_loadu_si128((__m128i*)dp);
-                    ms = _mm_loadu_si128((__m128i*)sp);
-
-                    // multiply
-                    t1 = _mm_unpacklo_epi8(ms, mnull);
-                    t2 = _mm_unpackhi_epi8(ms, mnull);
-                    t1 = _mm_mullo_epi16(t1, mcol);
-                    t2 = _mm_mullo_epi16(t2, mcol);
-                    t1 = _mm_srli_epi16(t1, 8);
-                    t2 = _mm_srli_epi16(t2, 8);
-                    t1 = _mm_packus_epi16(t1, t2);
-
-                    // add
-                    t1 = _mm_subs_epu8(md, t1);
-
-                    // store
-                    _mm_storeu_si128((__m128i*)dp, t1);
-
-                    dp += 4;
-                    sp += 4;
-                    ix--;
-                }
-
-                ix = num_remaining;
-                while (ix > 0) {
-                    fallback_renderer(dp, sp);
-                    dp++;
-                    sp++;
-                    ix--;
-                }
-
-                dp += di;
-                sp += si;
-                iy--;
+            core::Vec2i vertices[3] = { p1, p2, p3 };
+            invalidate(BoundingRect(vertices, 3));
+            switch (blendMode) {
+            case BlendMode::Set:      primitives::Triangle(_pixels, _pitch, _clipRect, vertices, color, kernels::BlitRun(kernels::Table.set)); break;
+            case BlendMode::Mix:      primitives::Triangle(_pixels, _pitch, _clipRect, vertices, color, kernels::BlitRun(kernels::Table.mix)); break;
+            case BlendMode::Add:      primitives::Triangle(_pixels, _pitch, _clipRect, vertices, color, kernels::BlitRun(kernels::Table.add)); break;
+            case BlendMode::Subtract: primitives::Triangle(_pixels, _pitch, _clipRect, vertices, color, kernels::BlitRun(kernels::Table.sub)); break;
+            case BlendMode::Multiply: primitives::Triangle(_pixels, _pitch, _clipRect, vertices, color, kernels::BlitRun(kernels::Table.mul)); break;
             }
         }
 
         //-----------------------------------------------------------------
         void
-        Image::draw_sse2_mul(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, RGBA color)
+        Image::drawTriangle(bool fill, const core::Vec2i& p1, const core::Vec2i& p2, const core::Vec2i& p3, RGBA c1, RGBA c2, RGBA c3, int blendMode)
         {
-            if (_clipRect.isEmpty() || image_rect.isEmpty()) {
-                return;
-            }
-
-            core::Recti dst_rect = core::Recti(pos, image_rect.getDimensions()).getIntersection(_clipRect);
-
-            if (dst_rect.isEmpty()) {
+            if (!fill) {
+                drawLine(p1, p2, c1, c2, blendMode);
+                drawLine(p2, p3, c2, c3, blendMode);
+                drawLine(p3, p1, c3, c1, blendMode);
                 return;
             }
 
-            core::Recti src_rect = core::Recti(image_rect.getPosition() + (dst_rect.getPosition() - pos), dst_rect.getDimensions());
-
-            rgba_mul_col fallback_renderer(color);
-
-            int di = _width - dst_rect.getWidth();
-            RGBA* dp = _pixels + dst_rect.getY() * _width + dst_rect.getX();
-
-            int si = image->getWidth() - src_rect.getWidth();
-            const RGBA* sp = image->getPixels() + src_rect.getY() * image->getWidth() + src_rect.getX();
-
-            int num_blocks    = dst_rect.getWidth() / 4;
-            int num_remaining = dst_rect.getWidth() % 4;
-
-            __m128i mcol  = _mm_set_epi16(color.alpha + 1, color.blue + 1, color.green + 1, color.red + 1, color.alpha + 1, color.blue + 1, color.green + 1, color.red + 1);
-            __m128i mnull = _mm_setzero_si128();
-            __m128i mone  = _mm_set1_epi16(1);
-
-            int iy = dst_rect.getHeight();
-            while (iy > 0) {
-
-                int ix = num_blocks;
-                while (ix > 0) {
-                    __m128i md, ms, t1, t2, t3;
-
-                    // load
-                    md = _mm_loadu_si128((__m128i*)dp);
-                    ms = _mm_loadu_si128((__m128i*)sp);
-
-                    // multiply first two
-                    t1 = _mm_unpacklo_epi8(ms, mnull);
-                    t2 = _mm_unpacklo_epi8(md, mnull);
-
-                    t1 = _mm_mullo_epi16(t1, mcol);
-                    t1 = _mm_srli_epi16(t1, 8);
-
-                    t1 = _mm_adds_epu16(t1, mone);
-                    t1 = _mm_mullo_epi16(t1, t2);
-                    t1 = _mm_srli_epi16(t1, 8);
-
-                    // multiply next two
-                    t2 = _mm_unpackhi_epi8(ms, mnull);
-                    t3 = _mm_unpackhi_epi8(md, mnull);
-
-                    t2 = _mm_mullo_epi16(t2, mcol);
-                    t2 = _mm_srli_epi16(t2, 8);
-
-                    t2 = _mm_adds_epu16(t2, mone);
-                    t2 = _mm_mullo_epi16(t2, t3);
-                    t2 = _mm_srli_epi16(t2, 8);
-
-                    // combine
-                    t1 = _mm_packus_epi16(t1, t2);
-
-                    // store
-                    _mm_storeu_si128((__m128i*)dp, t1);
-
-                    dp += 4;
-                    sp += 4;
-                    ix--;
-                }
-
-                ix = num_remaining;
-                while (ix > 0) {
-                    fallback_renderer(dp, sp);
-                    dp++;
-                    sp++;
-                    ix--;
-                }
-
-                dp += di;
-                sp += si;
-                iy--;
+            core::Vec2i vertices[3] = { p1, p2, p3 };
+            invalidate(BoundingRect(vertices, 3));
+            RGBA        colors[3]   = { c1, c2, c3 };
+            switch (blendMode) {
+            case BlendMode::Set:      primitives::Triangle(_pixels, _pitch, _clipRect, vertices, colors, kernels::BlitRun(kernels::Table.set)); break;
+            case BlendMode::Mix:      primitives::Triangle(_pixels, _pitch, _clipRect, vertices, colors, kernels::BlitRun(kernels::Table.mix)); break;
+            case BlendMode::Add:      primitives::Triangle(_pixels, _pitch, _clipRect, vertices, colors, kernels::BlitRun(kernels::Table.add)); break;
+            case BlendMode::Subtract: primitives::Triangle(_pixels, _pitch, _clipRect, vertices, colors, kernels::BlitRun(kernels::Table.sub)); break;
+            case BlendMode::Multiply: primitives::Triangle(_pixels, _pitch, _clipRect, vertices, colors, kernels::BlitRun(kernels::Table.mul)); break;
             }
         }
 
         //-----------------------------------------------------------------
         void
-        Image::draw(const Image* image, const core::Vec2i& pos, float angle, float scale, RGBA color, int blendMode)
+        Image::draw(const Image* image, const core::Vec2i& pos, float angle, float scale, RGBA color, int blendMode, int filter)
         {
             core::Recti image_rect = core::Recti(image->getDimensions());
-            draw(image, image_rect, pos, angle, scale, color, blendMode);
+            draw(image, image_rect, pos, angle, scale, color, blendMode, filter);
         }
 
         //-----------------------------------------------------------------
         void
-        Image::draw(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, float angle, float scale, RGBA color, int blendMode)
+        Image::draw(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, float angle, float scale, RGBA color, int blendMode, int filter)
         {
-            if (CpuSupportsSse2() && (angle == 0.0 && scale == 1.0))
+            core::Recti rect = core::Recti(pos, image_rect.getDimensions()).scale(scale);
+            invalidate(angle == 0.0 ? rect : primitives::GetTransformedBounds(rect, angle));
+
+            if (angle == 0.0 && scale == 1.0)
             {
+                if (_clipRect.isEmpty() || image_rect.isEmpty()) {
+                    return;
+                }
+
+                core::Recti dst_rect = core::Recti(pos, image_rect.getDimensions()).getIntersection(_clipRect);
+
+                if (dst_rect.isEmpty()) {
+                    return;
+                }
+
+                core::Recti src_rect = core::Recti(image_rect.getPosition() + (dst_rect.getPosition() - pos), dst_rect.getDimensions());
+
+                RGBA* dp = _pixels + dst_rect.getY() * _pitch + dst_rect.getX();
+                const RGBA* sp = image->getPixels() + src_rect.getY() * image->getPitch() + src_rect.getX();
+
+                int w = dst_rect.getWidth();
+                int h = dst_rect.getHeight();
+
+                // drawing an image onto itself or a view of it may read rows
+                // another band has already written, so that stays on the
+                // calling thread
+                int band_width = (!sharesPixels(image) ? w : 0);
+
                 if (color == RGBA(255, 255, 255, 255))
                 {
-                    switch (blendMode) {
-                    case BlendMode::Set:
-                        draw_sse2_set(image, image_rect, pos);
-                        break;
-                    case BlendMode::Mix:
-                        // difficult to implement with SSE2 intrinsics
-                        primitives::TexturedRectangle(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_mix());
-                        break;
-                    case BlendMode::Add:
-                        draw_sse2_add(image, image_rect, pos);
-                        break;
-                    case BlendMode::Subtract:
-                        draw_sse2_sub(image, image_rect, pos);
-                        break;
-                    case BlendMode::Multiply:
-                        draw_sse2_mul(image, image_rect, pos);
-                        break;
+                    // our own caches would describe the pixels before drawing
+                    int alpha_class = getSampledAlphaClass(image, FilterMode::Nearest);
+
+                    const SpanTable* spans = 0;
+                    if (blendMode == BlendMode::Mix && alpha_class != AlphaClass::Opaque && !sharesPixels(image)) {
+                        spans = image->getSpanTable();
+                    }
+
+                    if (spans) {
+                        primitives::SpannedRectangle(
+                            _pixels,
+                            _pitch,
+                            _clipRect,
+                            pos,
+                            image->getPixels(),
+                            image->getPitch(),
+                            image_rect,
+                            *spans,
+                            kernels::BlitRun(kernels::Table.setRgb),
+                            kernels::BlitRun(image->isPremultiplied() ? kernels::Table.mixPremul : kernels::Table.mix)
+                        );
+                    } else if (kernels::BlitFunc func = GetBlitKernel(blendMode, image, alpha_class)) {
+                        BlitBand band = { func, dp, _pitch, sp, image->getPitch(), w };
+                        parallel::ForEachBand(band_width, h, band);
                     }
                 }
                 else
                 {
-                    switch (blendMode) {
-                    case BlendMode::Set:
-                        draw_sse2_set(image, image_rect, pos, color);
-                        break;
-                    case BlendMode::Mix:
-                        // difficult to implement with SSE2 intrinsics
-                        primitives::TexturedRectangle(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_mix_col(color));
-                        break;
-                    case BlendMode::Add:
-                        draw_sse2_add(image, image_rect, pos, color);
-                        break;
-                    case BlendMode::Subtract:
-                        draw_sse2_sub(image, image_rect, pos, color);
-                        break;
-                    case BlendMode::Multiply:
-                        draw_sse2_mul(image, image_rect, pos, color);
-                        break;
+                    if (kernels::BlitColFunc func = GetBlitColKernel(blendMode, image)) {
+                        BlitColBand band = { func, dp, _pitch, sp, image->getPitch(), w, color };
+                        parallel::ForEachBand(band_width, h, band);
                     }
                 }
             }
-            else if (angle == 0.0)
+            else if (angle == 0.0 && filter == FilterMode::Nearest)
             {
-                core::Recti rect = core::Recti(pos, image->getDimensions()).scale(scale);
-
                 if (color == RGBA(255, 255, 255, 255))
                 {
                     switch (blendMode) {
-                    case BlendMode::Set:      primitives::TexturedRectangle(_pixels, _width, _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgba_set()); break;
-                    case BlendMode::Mix:      primitives::TexturedRectangle(_pixels, _width, _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgba_mix()); break;
-                    case BlendMode::Add:      primitives::TexturedRectangle(_pixels, _width, _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgba_add()); break;
-                    case BlendMode::Subtract: primitives::TexturedRectangle(_pixels, _width, _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgba_sub()); break;
-                    case BlendMode::Multiply: primitives::TexturedRectangle(_pixels, _width, _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgba_mul()); break;
+                    case BlendMode::Set:      primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_set()); break;
+                    case BlendMode::Mix:
+                        if (!sharesPixels(image) && image->getAlphaClass() == AlphaClass::Opaque) {
+                            primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_set_rgb());
+                        } else if (!sharesPixels(image) && image->getAlphaClass() == AlphaClass::Binary) {
+                            primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_set_rgb_masked());
+                        } else if (image->isPremultiplied()) {
+                            primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_mix_pm());
+                        } else {
+                            primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_mix());
+                        }
+                        break;
+                    case BlendMode::Add:      primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_add()); break;
+                    case BlendMode::Subtract: primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_sub()); break;
+                    case BlendMode::Multiply: primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_mul()); break;
                     }
                 }
                 else
                 {
                     switch (blendMode) {
-                    case BlendMode::Set:      primitives::TexturedRectangle(_pixels, _width, _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgba_set_col(color)); break;
-                    case BlendMode::Mix:      primitives::TexturedRectangle(_pixels, _width, _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgba_mix_col(color)); break;
-                    case BlendMode::Add:      primitives::TexturedRectangle(_pixels, _width, _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgba_add_col(color)); break;
-                    case BlendMode::Subtract: primitives::TexturedRectangle(_pixels, _width, _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgba_sub_col(color)); break;
-                    case BlendMode::Multiply: primitives::TexturedRectangle(_pixels, _width, _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgba_mul_col(color)); break;
+                    case BlendMode::Set:      primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_set_col(color)); break;
+                    case BlendMode::Mix:
+                        if (image->isPremultiplied()) {
+                            primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_mix_pm_col(color));
+                        } else {
+                            primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_mix_col(color));
+                        }
+                        break;
+                    case BlendMode::Add:      primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_add_col(color)); break;
+                    case BlendMode::Subtract: primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_sub_col(color)); break;
+                    case BlendMode::Multiply: primitives::TexturedRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgba_mul_col(color)); break;
                     }
                 }
             }
             else
             {
-                core::Recti rect = core::Recti(pos, image->getDimensions()).scale(scale);
-                core::Vec2i center_of_rotation = rect.getCenter();
-
-                core::Vec2i ul = rect.getUpperLeft().rotateBy(angle, center_of_rotation);
-                core::Vec2i ur = rect.getUpperRight().rotateBy(angle, center_of_rotation);
-                core::Vec2i lr = rect.getLowerRight().rotateBy(angle, center_of_rotation);
-                core::Vec2i ll = rect.getLowerLeft().rotateBy(angle, center_of_rotation);
-
-                drawq(image, image_rect, ul, ur, lr, ll, color, blendMode);
+                kernels::SampleFunc sampler = GetSampleKernel(image, filter);
+
+                if (color == RGBA(255, 255, 255, 255)) {
+                    if (kernels::BlitFunc func = GetBlitKernel(blendMode, image, getSampledAlphaClass(image, filter))) {
+                        if (angle == 0.0) {
+                            primitives::FilteredRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, sampler, kernels::BlitRun(func));
+                        } else {
+                            primitives::TransformedRectangle(_pixels, _pitch, _clipRect, rect, angle, image->getPixels(), image->getPitch(), image_rect, sampler, kernels::BlitRun(func));
+                        }
+                    }
+                } else {
+                    if (kernels::BlitColFunc func = GetBlitColKernel(blendMode, image)) {
+                        if (angle == 0.0) {
+                            primitives::FilteredRectangle(_pixels, _pitch, _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, sampler, kernels::BlitColRun(func, color));
+                        } else {
+                            primitives::TransformedRectangle(_pixels, _pitch, _clipRect, rect, angle, image->getPixels(), image->getPitch(), image_rect, sampler, kernels::BlitColRun(func, color));
+                        }
+                    }
+                }
             }
         }
 
         //-----------------------------------------------------------------
         void
-        Image::drawq(const Image* image, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, RGBA color, int blendMode)
+        Image::drawq(const Image* image, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, RGBA color, int blendMode, int filter)
         {
             core::Recti image_rect = core::Recti(image->getDimensions());
-            drawq(image, image_rect, ul, ur, lr, ll, color, blendMode);
+            drawq(image, image_rect, ul, ur, lr, ll, color, blendMode, filter);
         }
 
         //-----------------------------------------------------------------
         void
-        Image::drawq(const Image* image, const core::Recti& image_rect, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, RGBA color, int blendMode)
+        Image::drawq(const Image* image, const core::Recti& image_rect, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, RGBA color, int blendMode, int filter)
         {
             core::Vec2i pos[4] = { ul, ur, lr, ll };
+            invalidate(BoundingRect(pos, 4));
 
-            if (color == RGBA(255, 255, 255, 255))
-            {
-                switch (blendMode) {
-                case BlendMode::Set:      primitives::TexturedQuad(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_set()); break;
-                case BlendMode::Mix:      primitives::TexturedQuad(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_mix()); break;
-                case BlendMode::Add:      primitives::TexturedQuad(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_add()); break;
-                case BlendMode::Subtract: primitives::TexturedQuad(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_sub()); break;
-                case BlendMode::Multiply: primitives::TexturedQuad(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_mul()); break;
+            kernels::SampleFunc sampler = GetSampleKernel(image, filter);
+
+            if (color == RGBA(255, 255, 255, 255)) {
+                if (kernels::BlitFunc func = GetBlitKernel(blendMode, image, getSampledAlphaClass(image, filter))) {
+                    primitives::FilteredQuad(_pixels, _pitch, _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, sampler, kernels::BlitRun(func));
                 }
-            }
-            else
-            {
-                switch (blendMode) {
-                case BlendMode::Set:      primitives::TexturedQuad(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_set_col(color)); break;
-                case BlendMode::Mix:      primitives::TexturedQuad(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_mix_col(color)); break;
-                case BlendMode::Add:      primitives::TexturedQuad(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_add_col(color)); break;
-                case BlendMode::Subtract: primitives::TexturedQuad(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_sub_col(color)); break;
-                case BlendMode::Multiply: primitives::TexturedQuad(_pixels, _width, _clipRect, pos, image->getPixels(), image->getWidth(), image_rect, rgba_mul_col(color)); break;
+            } else {
+                if (kernels::BlitColFunc func = GetBlitColKernel(blendMode, image)) {
+                    primitives::FilteredQuad(_pixels, _pitch, _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, sampler, kernels::BlitColRun(func, color));
                 }
             }
         }
@@ -1408,79 +1467,68 @@ namespace rpgss {
         void
         Image::drawText(const Font* font, core::Vec2i pos, const char* text, int len, float scale, RGBA color)
         {
-            if (len < 0) {
-                len = std::strlen(text);
+            std::vector<Font::Glyph> glyphs;
+
+            const textcache::Run* run = textcache::Get(font, text, len, scale, color);
+            if (run)
+            {
+                // copy the pre-rendered glyph rects
+                glyphs = run->glyphs;
+                for (int i = 0; i < (int)glyphs.size(); i++) {
+                    glyphs[i].dstRect.translate(pos);
+                }
+                invalidate(BoundingRect(glyphs));
+                primitives::GlyphRun(_pixels, _pitch, _clipRect, run->image->getPixels(), run->image->getPitch(), &glyphs[0], (int)glyphs.size(), kernels::BlitRun(kernels::Table.set));
+                return;
+            }
+
+            font->layoutText(pos, text, len, scale, glyphs);
+
+            if (glyphs.empty()) {
+                return;
             }
 
-            int cur_x = pos.x;
-            int cur_y = pos.y;
+            invalidate(BoundingRect(glyphs));
+
+            const Image* glyph_image = font->getGlyphImage();
 
-            for (int i = 0; i < len; i++)
+            if (scale == 1.0)
             {
-                switch (text[i])
-                {
-                    case ' ':
-                    {
-                        const Image* space_char_image = font->getCharImage(' ');
-                        int space_w = (int)(space_char_image ? space_char_image->getWidth() * scale : 0);
-                        cur_x += space_w;
-                        break;
-                    }
-                    case '\t':
-                    {
-                        const Image* space_char_image = font->getCharImage(' ');
-                        int tab_w = (int)(space_char_image ? space_char_image->getWidth() * font->getTabWidth() * scale : 0);
-                        if (tab_w > 0) {
-                            tab_w = tab_w - ((cur_x - pos.x) % tab_w);
-                        }
-                        cur_x += tab_w;
-                        break;
-                    }
-                    case '\n':
-                    {
-                        cur_x = pos.x;
-                        cur_y += (int)(font->getMaxCharHeight() * scale);
-                        break;
-                    }
-                    default:
-                    {
-                        const Image* char_image = font->getCharImage(text[i]);
-                        if (char_image)
-                        {
-                            if (color == RGBA(255, 255, 255, 255))
-                            {
-                                primitives::TexturedRectangle(
-                                    _pixels,
-                                    _width,
-                                    _clipRect,
-                                    core::Recti(cur_x, cur_y, char_image->getWidth(), char_image->getHeight()).scale(scale),
-                                    char_image->getPixels(),
-                                    char_image->getWidth(),
-                                    core::Recti(char_image->getDimensions()),
-                                    rgba_set()
-                                );
-                            }
-                            else
-                            {
-                                primitives::TexturedRectangle(
-                                    _pixels,
-                                    _width,
-                                    _clipRect,
-                                    core::Recti(cur_x, cur_y, char_image->getWidth(), char_image->getHeight()).scale(scale),
-                                    char_image->getPixels(),
-                                    char_image->getWidth(),
-                                    core::Recti(char_image->getDimensions()),
-                                    rgba_set_col(color)
-                                );
-                            }
-                            cur_x += (int)(char_image->getWidth() * scale);
-                        }
-                        break;
+                // the whole string in one pass
+                if (color == RGBA(255, 255, 255, 255)) {
+                    primitives::GlyphRun(_pixels, _pitch, _clipRect, glyph_image->getPixels(), glyph_image->getPitch(), &glyphs[0], (int)glyphs.size(), kernels::BlitRun(kernels::Table.set));
+                } else {
+                    primitives::GlyphRun(_pixels, _pitch, _clipRect, glyph_image->getPixels(), glyph_image->getPitch(), &glyphs[0], (int)glyphs.size(), kernels::BlitColRun(kernels::Table.setCol, color));
+                }
+            }
+            else
+            {
+                for (int i = 0; i < (int)glyphs.size(); i++) {
+                    if (color == RGBA(255, 255, 255, 255)) {
+                        primitives::TexturedRectangle(_pixels, _pitch, _clipRect, glyphs[i].dstRect, glyph_image->getPixels(), glyph_image->getPitch(), glyphs[i].srcRect, rgba_set());
+                    } else {
+                        primitives::TexturedRectangle(_pixels, _pitch, _clipRect, glyphs[i].dstRect, glyph_image->getPixels(), glyph_image->getPitch(), glyphs[i].srcRect, rgba_set_col(color));
                     }
                 }
             }
         }
 
+        //-----------------------------------------------------------------
+        void
+        Image::drawBatch(const Image* image, const DrawBatchItem* items, int count, int blendMode, int filter)
+        {
+            for (int i = 0; i < count; i++) {
+                const DrawBatchItem& item = items[i];
+
+                // skip sprites that are not entirely inside the source image
+                if (item.srcRect.isEmpty() || !item.srcRect.isInside(0, 0, image->getWidth(), image->getHeight())) {
+                    continue;
+                }
+
+                draw(image, item.srcRect, item.pos, item.angle, item.scale, item.color, blendMode, filter);
+            }
+        }
+
         //-----------------------------------------------------------------
         void
         Image::drawWindow(const WindowSkin* windowSkin, core::Recti windowRect)
@@ -1490,6 +1538,30 @@ namespace rpgss {
                 return;
             }
 
+            // the borders are drawn around the window rect
+            {
+                const Image* t  = windowSkin->getBorderImage(WindowSkin::TopBorder);
+                const Image* r  = windowSkin->getBorderImage(WindowSkin::RightBorder);
+                const Image* b  = windowSkin->getBorderImage(WindowSkin::BottomBorder);
+                const Image* l  = windowSkin->getBorderImage(WindowSkin::LeftBorder);
+                const Image* tl = windowSkin->getBorderImage(WindowSkin::TopLeftBorder);
+                const Image* tr = windowSkin->getBorderImage(WindowSkin::TopRightBorder);
+                const Image* br = windowSkin->getBorderImage(WindowSkin::BottomRightBorder);
+                const Image* bl = windowSkin->getBorderImage(WindowSkin::BottomLeftBorder);
+
+                int left   = std::max(std::max(tl->getWidth(),  l->getWidth()),  bl->getWidth());
+                int right  = std::max(std::max(tr->getWidth(),  r->getWidth()),  br->getWidth());
+                int top    = std::max(std::max(tl->getHeight(), t->getHeight()), tr->getHeight());
+                int bottom = std::max(std::max(bl->getHeight(), b->getHeight()), br->getHeight());
+
+                invalidate(core::Recti(
+                    windowRect.getX() - left,
+                    windowRect.getY() - top,
+                    windowRect.getWidth()  + left + right,
+                    windowRect.getHeight() + top  + bottom
+                ));
+            }
+
             // for brevity
             int x1 = windowRect.ul.x;
             int y1 = windowRect.ul.y;
@@ -1511,7 +1583,7 @@ namespace rpgss {
 
                 primitives::Rectangle(
                     _pixels,
-                    _width,
+                    _pitch,
                     _clipRect,
                     true,
                     windowRect,
@@ -1526,11 +1598,11 @@ namespace rpgss {
             // draw top left edge
             primitives::TexturedRectangle(
                 _pixels,
-                _width,
+                _pitch,
                 _clipRect,
                 core::Vec2i(x1 - tlBorder->getWidth(), y1 - tlBorder->getHeight()),
                 tlBorder->getPixels(),
-                tlBorder->getWidth(),
+                tlBorder->getPitch(),
                 core::Recti(tlBorder->getDimensions()),
                 rgba_mix()
             );
@@ -1538,11 +1610,11 @@ namespace rpgss {
             // draw top right edge
             primitives::TexturedRectangle(
                 _pixels,
-                _width,
+                _pitch,
                 _clipRect,
                 core::Vec2i(x2 + 1, y1 - trBorder->getHeight()),
                 trBorder->getPixels(),
-                trBorder->getWidth(),
+                trBorder->getPitch(),
                 core::Recti(trBorder->getDimensions()),
                 rgba_mix()
             );
@@ -1550,11 +1622,11 @@ namespace rpgss {
             // draw bottom right edge
             primitives::TexturedRectangle(
                 _pixels,
-                _width,
+                _pitch,
                 _clipRect,
                 core::Vec2i(x2 + 1, y2 + 1 ),
                 brBorder->getPixels(),
-                brBorder->getWidth(),
+                brBorder->getPitch(),
                 core::Recti(brBorder->getDimensions()),
                 rgba_mix()
             );
@@ -1562,11 +1634,11 @@ namespace rpgss {
             // draw bottom left edge
             primitives::TexturedRectangle(
                 _pixels,
-                _width,
+                _pitch,
                 _clipRect,
                 core::Vec2i(x1 - blBorder->getWidth(), y2 + 1 ),
                 blBorder->getPixels(),
-                blBorder->getWidth(),
+                blBorder->getPitch(),
                 core::Recti(blBorder->getDimensions()),
                 rgba_mix()
             );
@@ -1584,11 +1656,11 @@ namespace rpgss {
                 while ((x2 - i) + 1 >= tBorder->getWidth()) {
                     primitives::TexturedRectangle(
                         _pixels,
-                        _width,
+                        _pitch,
                         _clipRect,
                         core::Vec2i(i, y1 - tBorder->getHeight()),
                         tBorder->getPixels(),
-                        tBorder->getWidth(),
+                        tBorder->getPitch(),
                         core::Recti(tBorder->getDimensions()),
                         rgba_mix()
                     );
@@ -1597,11 +1669,11 @@ namespace rpgss {
                 if ((x2 - i) + 1 > 0) {
                     primitives::TexturedRectangle(
                         _pixels,
-                        _width,
+                        _pitch,
                         _clipRect,
                         core::Vec2i(i, y1 - tBorder->getHeight()),
                         tBorder->getPixels(),
-                        tBorder->getWidth(),
+                        tBorder->getPitch(),
                         core::Recti(0, 0, (x2 - i) + 1, tBorder->getHeight()),
                         rgba_mix()
                     );
@@ -1612,11 +1684,11 @@ namespace rpgss {
                 while ((x2 - i) + 1 >= bBorder->getWidth()) {
                     primitives::TexturedRectangle(
                         _pixels,
-                        _width,
+                        _pitch,
                         _clipRect,
                         core::Vec2i(i, y2 + 1),
                         bBorder->getPixels(),
-                        bBorder->getWidth(),
+                        bBorder->getPitch(),
                         core::Recti(bBorder->getDimensions()),
                         rgba_mix()
                     );
@@ -1625,11 +1697,11 @@ namespace rpgss {
                 if ((x2 - i) + 1 > 0) {
                     primitives::TexturedRectangle(
                         _pixels,
-                        _width,
+                        _pitch,
                         _clipRect,
                         core::Vec2i(i, y2 + 1),
                         bBorder->getPixels(),
-                        bBorder->getWidth(),
+                        bBorder->getPitch(),
                         core::Recti(0, 0, (x2 - i) + 1, bBorder->getHeight()),
                         rgba_mix()
                     );
@@ -1649,11 +1721,11 @@ namespace rpgss {
                 while ((y2 - i) + 1 >= lBorder->getHeight()) {
                     primitives::TexturedRectangle(
                         _pixels,
-                        _width,
+                        _pitch,
                         _clipRect,
                         core::Vec2i(x1 - lBorder->getWidth(), i),
                         lBorder->getPixels(),
-                        lBorder->getWidth(),
+                        lBorder->getPitch(),
                         core::Recti(lBorder->getDimensions()),
                         rgba_mix()
                     );
@@ -1662,11 +1734,11 @@ namespace rpgss {
                 if ((y2 - i) + 1 > 0) {
                     primitives::TexturedRectangle(
                         _pixels,
-                        _width,
+                        _pitch,
                         _clipRect,
                         core::Vec2i(x1 - lBorder->getWidth(), i),
                         lBorder->getPixels(),
-                        lBorder->getWidth(),
+                        lBorder->getPitch(),
                         core::Recti(0, 0, lBorder->getWidth(), (y2 - i) + 1),
                         rgba_mix()
                     );
@@ -1677,11 +1749,11 @@ namespace rpgss {
                 while ((y2 - i) + 1 >= rBorder->getHeight()) {
                     primitives::TexturedRectangle(
                         _pixels,
-                        _width,
+                        _pitch,
                         _clipRect,
                         core::Vec2i(x2 + 1, i),
                         rBorder->getPixels(),
-                        rBorder->getWidth(),
+                        rBorder->getPitch(),
                         core::Recti(rBorder->getDimensions()),
                         rgba_mix()
                     );
@@ -1690,11 +1762,11 @@ namespace rpgss {
                 if ((y2 - i) + 1 > 0) {
                     primitives::TexturedRectangle(
                         _pixels,
-                        _width,
+                        _pitch,
                         _clipRect,
                         core::Vec2i(x2 + 1, i),
                         rBorder->getPixels(),
-                        rBorder->getWidth(),
+                        rBorder->getPitch(),
                         core::Recti(0, 0, rBorder->getWidth(), (y2 - i) + 1),
                         rgba_mix()
                     );
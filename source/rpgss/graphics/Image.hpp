@@ -26,6 +26,7 @@
 #define RPGSS_GRAPHICS_IMAGE_HPP_INCLUDED
 
 #include <string>
+#include <vector>
 
 #include "../common/RefCountedObject.hpp"
 #include "../common/RefCountedObjectPtr.hpp"
@@ -33,6 +34,7 @@
 #include "../core/Vec2.hpp"
 #include "../core/Rect.hpp"
 #include "RGBA.hpp"
+#include "SpanTable.hpp"
 
 
 namespace rpgss {
@@ -41,6 +43,7 @@ namespace rpgss {
         // forward declarations
         class Font;
         class WindowSkin;
+        struct ColorMatrix;
 
         struct BlendMode {
             enum {
@@ -52,21 +55,64 @@ namespace rpgss {
             };
         };
 
+        struct FilterMode {
+            enum {
+                Nearest,
+                Bilinear,
+            };
+        };
+
+        struct AlphaClass {
+            enum {
+                Opaque,      // all pixels have an alpha of 255
+                Binary,      // all pixels have an alpha of either 0 or 255
+                Translucent,
+            };
+        };
+
+        // one sprite of Image::drawBatch
+        struct DrawBatchItem {
+            core::Recti srcRect;
+            core::Vec2i pos;
+            RGBA        color;
+            float       angle;
+            float       scale;
+        };
+
         class Image : public RefCountedObject {
         public:
             typedef RefCountedObjectPtr<Image> Ptr;
 
         public:
+            // all return 0 for invalid sizes or when out of memory
             static Image::Ptr New(int width, int height);
             static Image::Ptr New(int width, int height, RGBA color);
             static Image::Ptr New(int width, int height, const RGBA* pixels);
 
+            // uses the pixels in place rather than copying them, they stay
+            // valid as long as owner lives, which the image keeps alive
+            static Image::Ptr New(int width, int height, RGBA* pixels, RefCountedObject* owner);
+
         public:
+            // a view shares the pixels of the given rect with this image
+            // and keeps it alive, drawing into either shows in both,
+            // resizing or rotating a view gives it its own pixels
+            Image::Ptr view(const core::Recti& rect);
+            bool isView() const;
+
+            // resizing or rotating an image with live views is refused,
+            // the views would be left pointing into the old pixels
+            bool hasViews() const;
+
+            // a clone shares the pixels with this image until either of
+            // them is modified, views and images with views are copied
+            Image::Ptr clone() const;
+
             int getWidth() const;
             int getHeight() const;
             core::Dim2i getDimensions() const;
 
-            int getPitch() const;
+            int getPitch() const; // in pixels
             int getSizeInBytes() const;
             int getSizeInPixels() const;
 
@@ -79,17 +125,63 @@ namespace rpgss {
             const core::Recti& getClipRect() const;
             void  setClipRect(const core::Recti& clipRect);
 
+            // premultiplied images are blended as such by the mix blend mode,
+            // all other blend modes and pixel accessors use the stored values,
+            // views share the flag of their owner and converting a view or
+            // its owner converts all of the owner's pixels
+            bool isPremultiplied() const;
+            void premultiply();
+            void unpremultiply();
+
+            // for loaders that fill in the pixels themselves, marks them
+            // as premultiplied or straight without converting them
+            void setPremultiplied(bool premultiplied);
+
+            // the span table lets mix blits skip transparent and copy opaque runs,
+            // it is built on demand and rebuilt after the image has been modified
+            bool getUseSpanTable() const;
+            void setUseSpanTable(bool useSpanTable);
+            const SpanTable* getSpanTable() const;
+
+            // lets the mix blend mode copy opaque images and mask binary-alpha
+            // images instead of blending them, cached until the image is modified
+            int getAlphaClass() const;
+
+            // when enabled, every modification records the area it touched,
+            // overlapping and adjacent areas are merged into one rect
+            bool getTrackDirty() const;
+            void setTrackDirty(bool trackDirty);
+            const std::vector<core::Recti>& getDirtyRects() const;
+            void clearDirty();
+
             Image::Ptr copyRect(const core::Recti& rect, Image* destination = 0);
-            void resize(int new_width, int new_height);
+            bool resize(int new_width, int new_height);
             void setAlpha(u8 alpha);
             void clear(RGBA color = RGBA(0, 0, 0));
             void grey();
+            void invert();
+            void multiplyAlpha(u8 alpha);
+
+            // each argument names the channel its channel is taken
+            // from, 0 to 3 for red, green, blue and alpha
+            void swapChannels(int red, int green, int blue, int alpha);
+
+            // only the pixels inside the clip rect are changed
+            void applyColorMatrix(const ColorMatrix& matrix);
+
+            // box blurs repeated passes times, three come close to a gaussian,
+            // only the pixels inside the clip rect are blurred, radius up to 127
+            void blur(int radius, int passes = 3);
+
+            // adds a blurred copy of the pixels inside the clip rect, modulated by color
+            void glow(int radius, RGBA color = RGBA(255, 255, 255, 255), int passes = 3);
 
             void flipHorizontal();
             void flipVertical();
 
-            void rotateClockwise();
-            void rotateCounterClockwise();
+            bool rotateClockwise();
+            bool rotateCounterClockwise();
+            void rotate180();
 
             void drawPoint(const core::Vec2i& pos, RGBA color, int blendMode = BlendMode::Mix);
 
@@ -105,11 +197,14 @@ namespace rpgss {
             void drawTriangle(bool fill, const core::Vec2i& p1, const core::Vec2i& p2, const core::Vec2i& p3, RGBA color, int blendMode = BlendMode::Mix);
             void drawTriangle(bool fill, const core::Vec2i& p1, const core::Vec2i& p2, const core::Vec2i& p3, RGBA c1, RGBA c2, RGBA c3, int blendMode = BlendMode::Mix);
 
-            void draw(const Image* image, const core::Vec2i& pos, float angle = 0.0, float scale = 1.0, RGBA color = RGBA(255, 255, 255, 255), int blendMode = BlendMode::Mix);
-            void draw(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, float angle = 0.0, float scale = 1.0, RGBA color = RGBA(255, 255, 255, 255), int blendMode = BlendMode::Mix);
+            // the filter only applies to scaled or rotated drawing
+            void draw(const Image* image, const core::Vec2i& pos, float angle = 0.0, float scale = 1.0, RGBA color = RGBA(255, 255, 255, 255), int blendMode = BlendMode::Mix, int filter = FilterMode::Nearest);
+            void draw(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, float angle = 0.0, float scale = 1.0, RGBA color = RGBA(255, 255, 255, 255), int blendMode = BlendMode::Mix, int filter = FilterMode::Nearest);
+
+            void drawq(const Image* image, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, RGBA color = RGBA(255, 255, 255, 255), int blendMode = BlendMode::Mix, int filter = FilterMode::Nearest);
+            void drawq(const Image* image, const core::Recti& image_rect, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, RGBA color = RGBA(255, 255, 255, 255), int blendMode = BlendMode::Mix, int filter = FilterMode::Nearest);
 
-            void drawq(const Image* image, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, RGBA color = RGBA(255, 255, 255, 255), int blendMode = BlendMode::Mix);
-            void drawq(const Image* image, const core::Recti& image_rect, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, RGBA color = RGBA(255, 255, 255, 255), int blendMode = BlendMode::Mix);
+            void drawBatch(const Image* image, const DrawBatchItem* items, int count, int blendMode = BlendMode::Mix, int filter = FilterMode::Nearest);
 
             void drawWindow(const WindowSkin* windowSkin, core::Recti windowRect);
 
@@ -120,35 +215,65 @@ namespace rpgss {
             Image(int width, int height);
             Image(int width, int height, RGBA color);
             Image(int width, int height, const RGBA* pixels);
-            ~Image();
-
-            RGBA* allocatePixels(int width, int height);
-            void  deletePixels(RGBA* pixels);
-            void  reset(int new_width, int new_height, RGBA* new_pixels);
-
-            Image::Ptr copyRect_generic(const core::Recti& rect, Image* destination = 0);
-            Image::Ptr copyRect_sse2(const core::Recti& rect, Image* destination = 0);
+            class Buffer;
 
-            void clear_generic(RGBA color);
-            void clear_sse2(RGBA color);
-
-            void draw_sse2_set(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos);
-            void draw_sse2_add(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos);
-            void draw_sse2_sub(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos);
-            void draw_sse2_mul(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos);
+            Image(int width, int height, Buffer* buffer);
+            Image(Image* parent, const core::Recti& rect);
+            ~Image();
 
-            void draw_sse2_set(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, RGBA color);
-            void draw_sse2_add(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, RGBA color);
-            void draw_sse2_sub(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, RGBA color);
-            void draw_sse2_mul(const Image* image, const core::Recti& image_rect, const core::Vec2i& pos, RGBA color);
+            Buffer* allocateBuffer(int width, int height);
+            void  makeUnique();
+            void  reset(int new_width, int new_height, Buffer* new_buffer);
+            void  invalidate();
+            void  invalidate(const core::Recti& rect); // clipped to the clip rect
+            void  markModified(const core::Recti& rect);
+            void  addDirtyRect(core::Recti rect);
+            int   getSampledAlphaClass(const Image* source, int filter) const;
+            bool  sharesPixels(const Image* image) const;
 
         private:
             int   _width;
             int   _height;
+            int   _pitch;
             RGBA* _pixels;
             core::Recti _clipRect;
+            bool  _premultiplied;
+            bool  _useSpanTable;
+            bool  _trackDirty;
+
+            std::vector<core::Recti> _dirtyRects;
+
+            // shared by clones until one of them is modified
+            RefCountedObjectPtr<Buffer> _buffer;
+
+            // views keep the image that owns their pixels alive, the owner's
+            // generation changes whenever it or any of its views is modified
+            Image::Ptr  _parent;
+            core::Vec2i _offset;
+            int         _viewCount;
+            u32         _generation;
+
+            mutable u32       _spanTableGeneration;
+            mutable SpanTable _spanTable;
+
+            mutable u32 _alphaClassGeneration;
+            mutable int _alphaClass;
         };
 
+        //-----------------------------------------------------------------
+        inline bool
+        Image::isView() const
+        {
+            return _parent;
+        }
+
+        //-----------------------------------------------------------------
+        inline bool
+        Image::hasViews() const
+        {
+            return _viewCount > 0;
+        }
+
         //-----------------------------------------------------------------
         inline int
         Image::getWidth() const
@@ -174,7 +299,7 @@ namespace rpgss {
         inline int
         Image::getPitch() const
         {
-            return _width * sizeof(RGBA);
+            return _pitch;
         }
 
         //-----------------------------------------------------------------
@@ -202,6 +327,7 @@ namespace rpgss {
         inline RGBA*
         Image::getPixels()
         {
+            invalidate();
             return _pixels;
         }
 
@@ -212,18 +338,73 @@ namespace rpgss {
             return _clipRect;
         }
 
+        //-----------------------------------------------------------------
+        inline bool
+        Image::isPremultiplied() const
+        {
+            return (_parent ? _parent->_premultiplied : _premultiplied);
+        }
+
+        //-----------------------------------------------------------------
+        inline void
+        Image::setPremultiplied(bool premultiplied)
+        {
+            if (_parent) {
+                _parent->_premultiplied = premultiplied;
+            } else {
+                _premultiplied = premultiplied;
+            }
+        }
+
+        //-----------------------------------------------------------------
+        inline bool
+        Image::getUseSpanTable() const
+        {
+            return _useSpanTable;
+        }
+
+        //-----------------------------------------------------------------
+        inline bool
+        Image::getTrackDirty() const
+        {
+            return _trackDirty;
+        }
+
+        //-----------------------------------------------------------------
+        inline const std::vector<core::Recti>&
+        Image::getDirtyRects() const
+        {
+            return _dirtyRects;
+        }
+
         //-----------------------------------------------------------------
         inline RGBA
         Image::getPixel(int x, int y) const
         {
-            return _pixels[_width * y + x];
+            return _pixels[_pitch * y + x];
         }
 
         //-----------------------------------------------------------------
         inline void
         Image::setPixel(int x, int y, RGBA color)
         {
-            _pixels[_width * y + x] = color;
+            // unlike drawPoint this ignores the clip rect
+            markModified(core::Recti(x, y, 1, 1));
+            _pixels[_pitch * y + x] = color;
+        }
+
+        //-----------------------------------------------------------------
+        inline void
+        Image::invalidate()
+        {
+            markModified(core::Recti(_width, _height));
+        }
+
+        //-----------------------------------------------------------------
+        inline void
+        Image::invalidate(const core::Recti& rect)
+        {
+            markModified(rect.getIntersection(_clipRect));
         }
 
     } // namespace graphics
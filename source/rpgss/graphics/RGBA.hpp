@@ -148,6 +148,34 @@ namespace rpgss {
             );
         }
 
+        inline RGBA PremultiplyRGBA(RGBA c)
+        {
+            int a = c.alpha + 1;
+            return RGBA(
+                c.red   * a >> 8,
+                c.green * a >> 8,
+                c.blue  * a >> 8,
+                c.alpha
+            );
+        }
+
+        inline RGBA UnpremultiplyRGBA(RGBA c)
+        {
+            int a = c.alpha;
+            if (a == 0) {
+                return RGBA(0, 0, 0, 0);
+            }
+            int r = (c.red   * 255 + a / 2) / a;
+            int g = (c.green * 255 + a / 2) / a;
+            int b = (c.blue  * 255 + a / 2) / a;
+            return RGBA(
+                r > 255 ? 255 : r,
+                g > 255 ? 255 : g,
+                b > 255 ? 255 : b,
+                a
+            );
+        }
+
     } // namespace graphics
 } // namespace rpgss
 
@@ -0,0 +1,110 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "SpanTable.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+
+        namespace {
+
+            enum {
+                Skip = -1,
+            };
+
+            //-----------------------------------------------------------------
+            inline int
+            ClassifyPixel(RGBA pixel, bool premultiplied)
+            {
+                switch (pixel.alpha) {
+                case 255:
+                    return SpanTable::Span::Opaque;
+                case 0:
+                    // premultiplied pixels add their color even if fully transparent
+                    if (!premultiplied || (pixel.red | pixel.green | pixel.blue) == 0) {
+                        return Skip;
+                    }
+                    // fall through
+                default:
+                    return SpanTable::Span::Blend;
+                }
+            }
+
+        } // anonymous namespace
+
+        //-----------------------------------------------------------------
+        SpanTable::SpanTable()
+        {
+        }
+
+        //-----------------------------------------------------------------
+        void
+        SpanTable::build(const RGBA* pixels, int pitch, int width, int height, bool premultiplied)
+        {
+            clear();
+
+            _rows.reserve(height + 1);
+
+            for (int iy = 0; iy < height; iy++) {
+                _rows.push_back(_spans.size());
+
+                const RGBA* p = pixels + iy * pitch;
+
+                int ix = 0;
+                while (ix < width) {
+                    int type = ClassifyPixel(p[ix], premultiplied);
+                    int x    = ix;
+
+                    ix++;
+                    while (ix < width && ClassifyPixel(p[ix], premultiplied) == type) {
+                        ix++;
+                    }
+
+                    if (type != Skip) {
+                        Span span = { x, ix - x, type };
+                        _spans.push_back(span);
+                    }
+                }
+            }
+
+            _rows.push_back(_spans.size());
+
+            // getRowBegin() and getRowEnd() need an element to point into
+            if (_spans.empty()) {
+                Span span = { 0, 0, Span::Blend };
+                _spans.push_back(span);
+            }
+        }
+
+        //-----------------------------------------------------------------
+        void
+        SpanTable::clear()
+        {
+            _spans.clear();
+            _rows.clear();
+        }
+
+    } // namespace graphics
+} // namespace rpgss
@@ -0,0 +1,92 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_GRAPHICS_SPANTABLE_HPP_INCLUDED
+#define RPGSS_GRAPHICS_SPANTABLE_HPP_INCLUDED
+
+#include <vector>
+
+#include "RGBA.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+
+        // per-row runs of opaque and translucent pixels,
+        // transparent runs are not stored
+        class SpanTable {
+        public:
+            struct Span {
+                enum {
+                    Opaque,
+                    Blend,
+                };
+
+                int x;
+                int length;
+                int type;
+            };
+
+        public:
+            SpanTable();
+
+            bool isEmpty() const;
+
+            void build(const RGBA* pixels, int pitch, int width, int height, bool premultiplied);
+            void clear();
+
+            const Span* getRowBegin(int y) const;
+            const Span* getRowEnd(int y) const;
+
+        private:
+            std::vector<Span> _spans;
+            std::vector<int>  _rows;
+        };
+
+        //-----------------------------------------------------------------
+        inline bool
+        SpanTable::isEmpty() const
+        {
+            return _rows.empty();
+        }
+
+        //-----------------------------------------------------------------
+        inline const SpanTable::Span*
+        SpanTable::getRowBegin(int y) const
+        {
+            return &_spans[0] + _rows[y];
+        }
+
+        //-----------------------------------------------------------------
+        inline const SpanTable::Span*
+        SpanTable::getRowEnd(int y) const
+        {
+            return &_spans[0] + _rows[y + 1];
+        }
+
+    } // namespace graphics
+} // namespace rpgss
+
+
+#endif // RPGSS_GRAPHICS_SPANTABLE_HPP_INCLUDED
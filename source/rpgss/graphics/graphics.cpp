@@ -31,6 +31,12 @@
 #include "../debug/debug.hpp"
 #include "../io/io.hpp"
 #include "../common/cpuinfo.hpp"
+#include "imagecache.hpp"
+#include "kernels.hpp"
+#include "loader.hpp"
+#include "parallel.hpp"
+#include "pixelpool.hpp"
+#include "textcache.hpp"
 #include "graphics.hpp"
 
 
@@ -91,6 +97,17 @@ namespace rpgss {
             io::File::Ptr _file;
         };
 
+        //-----------------------------------------------------------------
+        // keeps a decoded image alive while an Image uses its pixels
+        class AzuraPixels : public RefCountedObject {
+        public:
+            explicit AzuraPixels(azura::Image::Ptr image) : _image(image) {
+            }
+
+        private:
+            azura::Image::Ptr _image;
+        };
+
         //-----------------------------------------------------------------
         bool InitGraphicsSubsystem()
         {
@@ -102,6 +119,11 @@ namespace rpgss {
             debug::Log() << "CPU supports SSE:  " << (CpuSupportsSse()  ? "yes" : "no");
             debug::Log() << "CPU supports SSE2: " << (CpuSupportsSse2() ? "yes" : "no");
             debug::Log() << "CPU supports SSE3: " << (CpuSupportsSse3() ? "yes" : "no");
+            debug::Log() << "CPU supports AVX:  " << (CpuSupportsAvx()  ? "yes" : "no");
+            debug::Log() << "CPU supports AVX2: " << (CpuSupportsAvx2() ? "yes" : "no");
+
+            kernels::InitKernels();
+            debug::Log() << "Using " << kernels::Table.name << " pixel kernels";
 
             debug::Log() << "Linked Azura version is " << azura::GetVersionString();
 
@@ -112,10 +134,15 @@ namespace rpgss {
         void DeinitGraphicsSubsystem()
         {
             RPGSS_DEBUG_GUARD("rpgss::graphics::DeinitGraphicsSubsystem()")
+
+            loader::Shutdown();
+            parallel::SetWorkerCount(0);
+            textcache::Clear();
+            pixelpool::Clear();
         }
 
         //-----------------------------------------------------------------
-        Image::Ptr ReadImage(const std::string& filename)
+        Image::Ptr ReadImage(const std::string& filename, bool premultiply)
         {
             io::File::Ptr file = io::OpenFile(filename);
 
@@ -123,12 +150,36 @@ namespace rpgss {
                 return 0;
             }
 
-            return ReadImage(file);
+            // native images are as fast to read as cache entries
+            if (IsNativeImage(file)) {
+                return ReadNativeImage(file, premultiply);
+            }
+
+            Image::Ptr image = imagecache::Read(filename, premultiply);
+
+            if (!image) {
+                // the cache keeps the straight pixels, a premultiplied entry
+                // could not be turned back into them without losing colors
+                image = ReadImage(file, false);
+                if (image) {
+                    imagecache::Write(filename, image);
+                    if (premultiply) {
+                        image->premultiply();
+                        image->getAlphaClass();
+                    }
+                }
+            }
+
+            return image;
         }
 
         //-----------------------------------------------------------------
-        Image::Ptr ReadImage(io::File* file)
+        Image::Ptr ReadImage(io::File* file, bool premultiply)
         {
+            if (IsNativeImage(file)) {
+                return ReadNativeImage(file, premultiply);
+            }
+
             azura::File::Ptr file_adapter = new AzuraFileAdapter(file);
             azura::Image::Ptr image = azura::ReadImage(file_adapter, azura::FileFormat::AutoDetect, azura::PixelFormat::RGBA);
 
@@ -136,7 +187,20 @@ namespace rpgss {
                 return 0;
             }
 
-            return Image::New(image->getWidth(), image->getHeight(), (const RGBA*)image->getPixels());
+            // the image takes over the decoded pixels
+            RefCountedObject::Ptr owner = new AzuraPixels(image);
+            Image::Ptr result = Image::New(image->getWidth(), image->getHeight(), (RGBA*)image->getPixels(), owner);
+
+            if (result && premultiply) {
+                result->premultiply();
+            }
+
+            // classify once at load time rather than on the first draw
+            if (result) {
+                result->getAlphaClass();
+            }
+
+            return result;
         }
 
         //-----------------------------------------------------------------
@@ -161,7 +225,20 @@ namespace rpgss {
                 return false;
             }
 
-            std::memcpy(azura_image->getPixels(), image->getPixels(), image->getSizeInBytes());
+            // views are not stored contiguously, and image files always
+            // store straight alpha, so premultiplied rows are converted
+            // while they are copied rather than in a second pass
+            for (int y = 0; y < image->getHeight(); y++) {
+                RGBA*       dst = (RGBA*)azura_image->getPixels() + y * image->getWidth();
+                const RGBA* src = image->getPixels() + y * image->getPitch();
+                if (image->isPremultiplied()) {
+                    for (int x = 0; x < image->getWidth(); x++) {
+                        dst[x] = UnpremultiplyRGBA(src[x]);
+                    }
+                } else {
+                    std::memcpy(dst, src, image->getWidth() * sizeof(RGBA));
+                }
+            }
 
             if (palletize) {
                 azura_image = azura_image->convert(azura::PixelFormat::RGB_P8);
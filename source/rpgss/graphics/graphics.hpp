@@ -37,12 +37,21 @@ namespace rpgss {
         bool InitGraphicsSubsystem();
         void DeinitGraphicsSubsystem();
 
-        Image::Ptr ReadImage(const std::string& filename);
-        Image::Ptr ReadImage(io::File* file);
+        Image::Ptr ReadImage(const std::string& filename, bool premultiply = false);
+        Image::Ptr ReadImage(io::File* file, bool premultiply = false);
 
         bool WriteImage(const Image* image, const std::string& filename, bool palletize = false, i32 mask = -1);
         bool WriteImage(const Image* image, io::File* file, bool palletize = false, i32 mask = -1);
 
+        // the native format stores the rgba rows raw or lz compressed and
+        // keeps premultiplied pixels as they are, so reading it is little
+        // more than a read, ReadImage detects it by its magic
+        bool IsNativeImage(io::File* file);
+        Image::Ptr ReadNativeImage(io::File* file, bool premultiply = false);
+
+        bool WriteNativeImage(const Image* image, const std::string& filename, bool compress = true);
+        bool WriteNativeImage(const Image* image, io::File* file, bool compress = true);
+
     } // namespace graphics
 } // namespace rpgss
 
@@ -0,0 +1,184 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "../common/byteorder.hpp"
+#include "../common/SpinLock.hpp"
+#include "../io/io.hpp"
+#include "graphics.hpp"
+#include "imagecache.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace imagecache {
+
+            namespace {
+
+                // an entry is the source path and modification time
+                // followed by the image in the native format
+                const char EntryMagic[8] = { 'R', 'P', 'G', 'S', 'S', 'C', 'H', 'E' };
+                const char EntryExtension[] = ".cache";
+
+                std::string   Directory;
+                SpinLock      Lock;
+
+                //-----------------------------------------------------------------
+                // fnv-1a, collisions are caught by the path stored in the entry
+                std::string GetEntryName(const std::string& dirname, const std::string& filename)
+                {
+                    u32 hash = 2166136261U;
+                    for (size_t i = 0; i < filename.size(); i++) {
+                        hash = (hash ^ (u8)filename[i]) * 16777619U;
+                    }
+
+                    char name[16];
+                    std::sprintf(name, "%08x", (unsigned int)hash);
+
+                    return dirname + "/" + name + EntryExtension;
+                }
+
+            } // anonymous namespace
+
+            //-----------------------------------------------------------------
+            void SetDirectory(const std::string& dirname)
+            {
+                if (!dirname.empty()) {
+                    io::MakeDirectory(dirname);
+                }
+
+                ScopedLock lock(Lock);
+                Directory = dirname;
+            }
+
+            //-----------------------------------------------------------------
+            std::string GetDirectory()
+            {
+                ScopedLock lock(Lock);
+                return Directory;
+            }
+
+            //-----------------------------------------------------------------
+            Image::Ptr Read(const std::string& filename, bool premultiply)
+            {
+                std::string dirname = GetDirectory();
+                if (dirname.empty()) {
+                    return 0;
+                }
+
+                int time = io::LastWriteTime(filename);
+                if (time == -1) {
+                    return 0;
+                }
+
+                io::File::Ptr file = io::OpenFile(GetEntryName(dirname, filename));
+                if (!file) {
+                    return 0;
+                }
+
+                u8 header[sizeof(EntryMagic) + 8];
+                if (file->read(header, sizeof(header)) != sizeof(header) ||
+                    std::memcmp(header, EntryMagic, sizeof(EntryMagic)) != 0 ||
+                    Get32(header + sizeof(EntryMagic)) != (u32)time ||
+                    Get32(header + sizeof(EntryMagic) + 4) != filename.size())
+                {
+                    return 0;
+                }
+
+                std::vector<char> path(filename.size() + 1);
+                if (file->read((u8*)&path[0], filename.size()) != (int)filename.size() ||
+                    filename.compare(0, filename.size(), &path[0], filename.size()) != 0)
+                {
+                    return 0;
+                }
+
+                return ReadNativeImage(file, premultiply);
+            }
+
+            //-----------------------------------------------------------------
+            bool Write(const std::string& filename, const Image* image)
+            {
+                std::string dirname = GetDirectory();
+                if (dirname.empty()) {
+                    return false;
+                }
+
+                int time = io::LastWriteTime(filename);
+                if (time == -1) {
+                    return false;
+                }
+
+                std::string entry_name = GetEntryName(dirname, filename);
+
+                io::File::Ptr file = io::OpenFile(entry_name, io::File::Out);
+                if (!file) {
+                    return false;
+                }
+
+                u8 header[sizeof(EntryMagic) + 8];
+                std::memcpy(header, EntryMagic, sizeof(EntryMagic));
+                Put32(header + sizeof(EntryMagic), time);
+                Put32(header + sizeof(EntryMagic) + 4, filename.size());
+
+                if (file->write(header, sizeof(header)) != sizeof(header) ||
+                    file->write((const u8*)filename.data(), filename.size()) != (int)filename.size() ||
+                    !WriteNativeImage(image, file))
+                {
+                    // a partial entry would only be rejected later
+                    file->close();
+                    io::Remove(entry_name);
+                    return false;
+                }
+
+                return true;
+            }
+
+            //-----------------------------------------------------------------
+            void Clear()
+            {
+                std::string dirname = GetDirectory();
+                if (dirname.empty()) {
+                    return;
+                }
+
+                std::vector<std::string> filelist;
+                io::Enumerate(dirname, filelist);
+
+                size_t extension_len = sizeof(EntryExtension) - 1;
+                for (size_t i = 0; i < filelist.size(); i++) {
+                    const std::string& name = filelist[i];
+                    if (name.size() > extension_len &&
+                        name.compare(name.size() - extension_len, extension_len, EntryExtension) == 0)
+                    {
+                        io::Remove(dirname + "/" + name);
+                    }
+                }
+            }
+
+        } // namespace imagecache
+    } // namespace graphics
+} // namespace rpgss
@@ -0,0 +1,58 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_GRAPHICS_IMAGECACHE_HPP_INCLUDED
+#define RPGSS_GRAPHICS_IMAGECACHE_HPP_INCLUDED
+
+#include <string>
+
+#include "Image.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace imagecache {
+
+            // decoded images are kept in this directory as native images,
+            // keyed by the source path and its modification time, an empty
+            // name disables the cache (the default), may be called from any thread
+            void SetDirectory(const std::string& dirname);
+            std::string GetDirectory();
+
+            // returns 0 if the cache is disabled or has no entry for the
+            // current version of the file
+            Image::Ptr Read(const std::string& filename, bool premultiply);
+
+            // stores the image decoded from filename
+            bool Write(const std::string& filename, const Image* image);
+
+            // removes all entries from the cache directory
+            void Clear();
+
+        } // namespace imagecache
+    } // namespace graphics
+} // namespace rpgss
+
+
+#endif // RPGSS_GRAPHICS_IMAGECACHE_HPP_INCLUDED
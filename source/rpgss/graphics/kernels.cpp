@@ -0,0 +1,575 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include "../common/cpuinfo.hpp"
+#include "renderers.hpp"
+#include "kernels.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace kernels {
+
+            namespace {
+
+                //-----------------------------------------------------------------
+                template<typename Renderer>
+                void blit(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, Renderer renderer)
+                {
+                    int di = dstPitch - width;
+                    int si = srcPitch - width;
+
+                    int iy = height;
+                    while (iy > 0) {
+                        int ix = width;
+                        while (ix > 0) {
+                            renderer(dst, src);
+                            dst++;
+                            src++;
+                            ix--;
+                        }
+                        dst += di;
+                        src += si;
+                        iy--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void clear_generic(RGBA* dst, int dstPitch, int width, int height, RGBA color)
+                {
+                    if (dstPitch == width) {
+                        width *= height;
+                        height = 1;
+                    }
+
+                    u32 q = *((u32*)&color);
+
+                    for (int iy = 0; iy < height; iy++) {
+                        u32* p = (u32*)(dst + iy * dstPitch);
+                        int  i = width;
+                        while (i > 0) {
+                            *p = q;
+                            ++p;
+                            --i;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void set_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    for (int iy = 0; iy < height; iy++) {
+                        std::memcpy(dst + iy * dstPitch, src + iy * srcPitch, width * sizeof(RGBA));
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void mix_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_mix());
+                }
+
+                //-----------------------------------------------------------------
+                void add_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_add());
+                }
+
+                //-----------------------------------------------------------------
+                void sub_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_sub());
+                }
+
+                //-----------------------------------------------------------------
+                void mul_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_mul());
+                }
+
+                //-----------------------------------------------------------------
+                void mix_pm_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_mix_pm());
+                }
+
+                //-----------------------------------------------------------------
+                void set_rgb_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_set_rgb());
+                }
+
+                //-----------------------------------------------------------------
+                void set_rgb_masked_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_set_rgb_masked());
+                }
+
+                //-----------------------------------------------------------------
+                void set_col_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_set_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void mix_col_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_mix_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void add_col_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_add_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void sub_col_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_sub_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void mul_col_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_mul_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void mix_pm_col_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, rgba_mix_pm_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void sample_nearest_generic(RGBA* dst, const RGBA* src, int srcPitch, int width, int height, int u, int v, int du, int dv, int count)
+                {
+                    // round to the nearest texel
+                    u += 0x8000;
+                    v += 0x8000;
+
+                    while (count > 0) {
+                        int x = std::min(std::max(u >> 16, 0), width  - 1);
+                        int y = std::min(std::max(v >> 16, 0), height - 1);
+
+                        *dst = src[y * srcPitch + x];
+
+                        u += du;
+                        v += dv;
+                        dst++;
+                        count--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void sample_bilinear_generic(RGBA* dst, const RGBA* src, int srcPitch, int width, int height, int u, int v, int du, int dv, int count)
+                {
+                    const int umax = (width  - 1) << 16;
+                    const int vmax = (height - 1) << 16;
+
+                    while (count > 0) {
+                        int cu = std::min(std::max(u, 0), umax);
+                        int cv = std::min(std::max(v, 0), vmax);
+
+                        int x0 = cu >> 16;
+                        int y0 = cv >> 16;
+                        int x1 = std::min(x0 + 1, width  - 1);
+                        int y1 = std::min(y0 + 1, height - 1);
+                        int fx = (cu >> 8) & 0xFF;
+                        int fy = (cv >> 8) & 0xFF;
+
+                        const u8* p00 = (const u8*)(src + y0 * srcPitch + x0);
+                        const u8* p01 = (const u8*)(src + y0 * srcPitch + x1);
+                        const u8* p10 = (const u8*)(src + y1 * srcPitch + x0);
+                        const u8* p11 = (const u8*)(src + y1 * srcPitch + x1);
+                        u8*       d   = (u8*)dst;
+
+                        // vertical first, same rounding as the SIMD versions
+                        for (int c = 0; c < 4; c++) {
+                            int l = (p00[c] * (256 - fy) + p10[c] * fy) >> 8;
+                            int r = (p01[c] * (256 - fy) + p11[c] * fy) >> 8;
+                            d[c] = (l * (256 - fx) + r * fx) >> 8;
+                        }
+
+                        u += du;
+                        v += dv;
+                        dst++;
+                        count--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void sample_bilinear_straight_generic(RGBA* dst, const RGBA* src, int srcPitch, int width, int height, int u, int v, int du, int dv, int count)
+                {
+                    const int umax = (width  - 1) << 16;
+                    const int vmax = (height - 1) << 16;
+
+                    while (count > 0) {
+                        int cu = std::min(std::max(u, 0), umax);
+                        int cv = std::min(std::max(v, 0), vmax);
+
+                        int x0 = cu >> 16;
+                        int y0 = cv >> 16;
+                        int x1 = std::min(x0 + 1, width  - 1);
+                        int y1 = std::min(y0 + 1, height - 1);
+                        int fx = (cu >> 8) & 0xFF;
+                        int fy = (cv >> 8) & 0xFF;
+
+                        // weight the colors by their alpha so that invisible texels add nothing
+                        RGBA t00 = PremultiplyRGBA(src[y0 * srcPitch + x0]);
+                        RGBA t01 = PremultiplyRGBA(src[y0 * srcPitch + x1]);
+                        RGBA t10 = PremultiplyRGBA(src[y1 * srcPitch + x0]);
+                        RGBA t11 = PremultiplyRGBA(src[y1 * srcPitch + x1]);
+
+                        const u8* p00 = (const u8*)&t00;
+                        const u8* p01 = (const u8*)&t01;
+                        const u8* p10 = (const u8*)&t10;
+                        const u8* p11 = (const u8*)&t11;
+                        u8*       d   = (u8*)dst;
+
+                        for (int c = 0; c < 4; c++) {
+                            int l = (p00[c] * (256 - fy) + p10[c] * fy) >> 8;
+                            int r = (p01[c] * (256 - fy) + p11[c] * fy) >> 8;
+                            d[c] = (l * (256 - fx) + r * fx) >> 8;
+                        }
+
+                        if (dst->alpha != 255) {
+                            *dst = UnpremultiplyRGBA(*dst);
+                        }
+
+                        u += du;
+                        v += dv;
+                        dst++;
+                        count--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void grey_generic(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* p = dst + iy * dstPitch;
+                        int   i = width;
+                        while (i > 0) {
+                            u8 q = (p->red + p->green + p->blue) / 3;
+                            p->red   = q;
+                            p->green = q;
+                            p->blue  = q;
+                            ++p;
+                            --i;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void invert_generic(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* p = dst + iy * dstPitch;
+                        int   i = width;
+                        while (i > 0) {
+                            p->red   = 255 - p->red;
+                            p->green = 255 - p->green;
+                            p->blue  = 255 - p->blue;
+                            ++p;
+                            --i;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void invert_pm_generic(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* p = dst + iy * dstPitch;
+                        int   i = width;
+                        while (i > 0) {
+                            p->red   = std::max(p->alpha - p->red,   0);
+                            p->green = std::max(p->alpha - p->green, 0);
+                            p->blue  = std::max(p->alpha - p->blue,  0);
+                            ++p;
+                            --i;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void mirror_generic(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    for (int iy = 0; iy < height; iy++) {
+                        u32* a = (u32*)(dst + iy * dstPitch);
+                        u32* b = a + width - 1;
+                        while (a < b) {
+                            u32 c = *a;
+                            *a = *b;
+                            *b = c;
+                            a++;
+                            b--;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void set_alpha_generic(RGBA* dst, int dstPitch, int width, int height, int alpha)
+                {
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* p = dst + iy * dstPitch;
+                        int   i = width;
+                        while (i > 0) {
+                            p->alpha = alpha;
+                            ++p;
+                            --i;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void swizzle_generic(RGBA* dst, int dstPitch, int width, int height, int order)
+                {
+                    int r = (order >> 0) & 3;
+                    int g = (order >> 2) & 3;
+                    int b = (order >> 4) & 3;
+                    int a = (order >> 6) & 3;
+
+                    for (int iy = 0; iy < height; iy++) {
+                        u8* p = (u8*)(dst + iy * dstPitch);
+                        int i = width;
+                        while (i > 0) {
+                            u8 c[4] = { p[r], p[g], p[b], p[a] };
+                            p[0] = c[0];
+                            p[1] = c[1];
+                            p[2] = c[2];
+                            p[3] = c[3];
+                            p += 4;
+                            --i;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void swap_generic(RGBA* a, RGBA* b, int count)
+                {
+                    u32* p = (u32*)a;
+                    u32* q = (u32*)b;
+                    while (count > 0) {
+                        u32 c = *p;
+                        *p = *q;
+                        *q = c;
+                        p++;
+                        q++;
+                        count--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void swap_mirrored_generic(RGBA* a, RGBA* b, int count)
+                {
+                    u32* p = (u32*)a;
+                    u32* q = (u32*)b + count - 1;
+                    while (count > 0) {
+                        u32 c = *p;
+                        *p = *q;
+                        *q = c;
+                        p++;
+                        q--;
+                        count--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void transpose_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    // tile by tile, so both sides stay in the cache
+                    for (int ty = 0; ty < height; ty += TransposeTileSize) {
+                        for (int tx = 0; tx < width; tx += TransposeTileSize) {
+                            int th = std::min(TransposeTileSize, height - ty);
+                            int tw = std::min(TransposeTileSize, width  - tx);
+
+                            for (int y = ty; y < ty + th; y++) {
+                                const u32* sp = (const u32*)(src + y * srcPitch + tx);
+                                u32*       dp = (u32*)(dst + tx * dstPitch + y);
+                                for (int x = 0; x < tw; x++) {
+                                    *dp = sp[x];
+                                    dp += dstPitch;
+                                }
+                            }
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void blur_rows_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, int radius)
+                {
+                    unsigned int factor = BoxBlurFactor(radius);
+
+                    for (int iy = 0; iy < height; iy++) {
+                        const u8* sp = (const u8*)(src + iy * srcPitch);
+                        u8*       dp = (u8*)(dst + iy * dstPitch);
+
+                        // the window of the first pixel
+                        unsigned int sum[4];
+                        for (int c = 0; c < 4; c++) {
+                            sum[c] = (radius + 1) * sp[c];
+                            for (int k = 1; k <= radius; k++) {
+                                sum[c] += sp[std::min(k, width - 1) * 4 + c];
+                            }
+                        }
+
+                        for (int ix = 0; ix < width; ix++) {
+                            const u8* in  = sp + std::min(ix + radius + 1, width - 1) * 4;
+                            const u8* out = sp + std::max(ix - radius, 0) * 4;
+                            for (int c = 0; c < 4; c++) {
+                                dp[c]   = (sum[c] * factor) >> 16;
+                                sum[c] += in[c] - out[c];
+                            }
+                            dp += 4;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void blur_columns_generic(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, int radius)
+                {
+                    unsigned int factor = BoxBlurFactor(radius);
+
+                    // the windows of all columns move down together
+                    std::vector<unsigned int> sums(width * 4);
+                    const u8* first = (const u8*)src;
+                    for (int i = 0; i < width * 4; i++) {
+                        sums[i] = (radius + 1) * first[i];
+                    }
+                    for (int k = 1; k <= radius; k++) {
+                        const u8* sp = (const u8*)(src + std::min(k, height - 1) * srcPitch);
+                        for (int i = 0; i < width * 4; i++) {
+                            sums[i] += sp[i];
+                        }
+                    }
+
+                    for (int iy = 0; iy < height; iy++) {
+                        const u8* in  = (const u8*)(src + std::min(iy + radius + 1, height - 1) * srcPitch);
+                        const u8* out = (const u8*)(src + std::max(iy - radius, 0) * srcPitch);
+                        u8*       dp  = (u8*)(dst + iy * dstPitch);
+                        for (int i = 0; i < width * 4; i++) {
+                            dp[i]    = (sums[i] * factor) >> 16;
+                            sums[i] += in[i] - out[i];
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                inline int clamp_channel(int v)
+                {
+                    return (v < 0 ? 0 : (v > 255 ? 255 : v));
+                }
+
+                //-----------------------------------------------------------------
+                template<bool premultiplied>
+                void color_matrix_generic(RGBA* dst, int dstPitch, int width, int height, const int* m)
+                {
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* p = dst + iy * dstPitch;
+                        int   i = width;
+                        while (i > 0) {
+                            int r = p->red;
+                            int g = p->green;
+                            int b = p->blue;
+                            int a = p->alpha;
+
+                            int nr = clamp_channel((m[ 0] * r + m[ 1] * g + m[ 2] * b + m[ 3] * a + m[ 4] + 128) >> 8);
+                            int ng = clamp_channel((m[ 5] * r + m[ 6] * g + m[ 7] * b + m[ 8] * a + m[ 9] + 128) >> 8);
+                            int nb = clamp_channel((m[10] * r + m[11] * g + m[12] * b + m[13] * a + m[14] + 128) >> 8);
+                            int na = clamp_channel((m[15] * r + m[16] * g + m[17] * b + m[18] * a + m[19] + 128) >> 8);
+
+                            if (premultiplied) {
+                                nr = std::min(nr, na);
+                                ng = std::min(ng, na);
+                                nb = std::min(nb, na);
+                            }
+
+                            p->red   = nr;
+                            p->green = ng;
+                            p->blue  = nb;
+                            p->alpha = na;
+                            ++p;
+                            --i;
+                        }
+                    }
+                }
+
+            } // anonymous namespace
+
+            //-----------------------------------------------------------------
+            KernelTable Table = {
+                "generic",
+                clear_generic,
+                set_generic,
+                mix_generic,
+                add_generic,
+                sub_generic,
+                mul_generic,
+                mix_pm_generic,
+                set_rgb_generic,
+                set_rgb_masked_generic,
+                set_col_generic,
+                mix_col_generic,
+                add_col_generic,
+                sub_col_generic,
+                mul_col_generic,
+                mix_pm_col_generic,
+                sample_nearest_generic,
+                sample_bilinear_generic,
+                sample_bilinear_straight_generic,
+                grey_generic,
+                invert_generic,
+                invert_pm_generic,
+                mirror_generic,
+                set_alpha_generic,
+                swizzle_generic,
+                swap_generic,
+                swap_mirrored_generic,
+                transpose_generic,
+                blur_rows_generic,
+                blur_columns_generic,
+                color_matrix_generic<false>,
+                color_matrix_generic<true>,
+            };
+
+            //-----------------------------------------------------------------
+            void InitKernels()
+            {
+                if (CpuSupportsSse2()) {
+                    InitSse2Kernels(Table);
+                }
+                if (CpuSupportsAvx2()) {
+                    InitAvx2Kernels(Table);
+                }
+            }
+
+        } // namespace kernels
+    } // namespace graphics
+} // namespace rpgss
@@ -0,0 +1,196 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_GRAPHICS_KERNELS_HPP_INCLUDED
+#define RPGSS_GRAPHICS_KERNELS_HPP_INCLUDED
+
+#include "RGBA.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace kernels {
+
+            // pitches are given in pixels
+            typedef void (*ClearFunc)(RGBA* dst, int dstPitch, int width, int height, RGBA color);
+            typedef void (*BlitFunc)(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height);
+            typedef void (*BlitColFunc)(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color);
+
+            // samples count pixels at (u, v), (u + du, v + dv), ... given in 16.16 fixed point
+            // texel coordinates relative to src, where (0, 0) is the center of the first texel,
+            // coordinates are clamped to width and height
+            typedef void (*SampleFunc)(RGBA* dst, const RGBA* src, int srcPitch, int width, int height, int u, int v, int du, int dv, int count);
+
+            // in-place transforms of every pixel in the rectangle
+            typedef void (*PixelFunc)(RGBA* dst, int dstPitch, int width, int height);
+            typedef void (*PixelArgFunc)(RGBA* dst, int dstPitch, int width, int height, int arg);
+
+            // exchanges count pixels between a and b
+            typedef void (*SwapFunc)(RGBA* a, RGBA* b, int count);
+
+            // applies a 4x5 color matrix in 8.8 fixed point given row by row,
+            // the coefficients must fit in 16 bits (see ColorMatrix::toFixed)
+            typedef void (*MatrixFunc)(RGBA* dst, int dstPitch, int width, int height, const int* matrix);
+
+            // box filters of 2 * radius + 1 pixels along the rows or the
+            // columns, pixels beyond the edges repeat the edge pixels
+            typedef void (*BoxBlurFunc)(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, int radius);
+
+            // keeps the window sums of the box filters within 16 bits
+            const int MaxBoxBlurRadius = 127;
+
+            // box filters divide by multiplying with this and shifting right by 16,
+            // which never exceeds 255 for sums of up to 255 * 255
+            inline unsigned int BoxBlurFactor(int radius)
+            {
+                unsigned int n = 2 * radius + 1;
+                return (65536 + n - 1) / n;
+            }
+
+            // writes src row y to dst column y, pitches may be negative
+            typedef void (*TransposeFunc)(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height);
+
+            // packs the source channel (0 to 3 for red to alpha) of each
+            // destination channel into the argument of KernelTable::swizzle
+            inline int SwizzleOrder(int red, int green, int blue, int alpha)
+            {
+                return (red & 3) | ((green & 3) << 2) | ((blue & 3) << 4) | ((alpha & 3) << 6);
+            }
+
+            struct KernelTable {
+                const char* name;
+
+                ClearFunc clear;
+
+                BlitFunc set;
+                BlitFunc mix;
+                BlitFunc add;
+                BlitFunc sub;
+                BlitFunc mul;
+
+                // mix with a premultiplied source
+                BlitFunc mixPremul;
+
+                // copy color, keep destination alpha
+                BlitFunc setRgb;
+
+                // like setRgb, but skip fully transparent source pixels
+                BlitFunc setRgbMasked;
+
+                BlitColFunc setCol;
+                BlitColFunc mixCol;
+                BlitColFunc addCol;
+                BlitColFunc subCol;
+                BlitColFunc mulCol;
+
+                BlitColFunc mixPremulCol;
+
+                SampleFunc sampleNearest;
+                // sampleBilinear interpolates the stored values, which is right for
+                // premultiplied and opaque images, sampleBilinearStraight weights the
+                // colors of straight images by their alpha and returns straight colors
+                SampleFunc sampleBilinear;
+                SampleFunc sampleBilinearStraight;
+
+                // average of the color channels, alpha is kept
+                PixelFunc grey;
+
+                // 255 - c for straight and alpha - c for premultiplied colors
+                PixelFunc invert;
+                PixelFunc invertPremul;
+
+                // reverses the order of the pixels in each row
+                PixelFunc mirror;
+
+                // the argument is the new alpha
+                PixelArgFunc setAlpha;
+
+                // the argument comes from SwizzleOrder()
+                PixelArgFunc swizzle;
+
+                SwapFunc swap;
+
+                // like swap, but a[i] goes to b[count - 1 - i] and back
+                SwapFunc swapMirrored;
+
+                TransposeFunc transpose;
+
+                // radius from 1 to MaxBoxBlurRadius, src and dst must not overlap
+                BoxBlurFunc blurRows;
+                BoxBlurFunc blurColumns;
+
+                MatrixFunc colorMatrix;
+
+                // like colorMatrix, but clamps the colors to alpha
+                MatrixFunc colorMatrixPremul;
+            };
+
+            // adapts a blit kernel to the run interface of primitives::SpannedRectangle
+            struct BlitRun {
+                BlitFunc func;
+
+                explicit BlitRun(BlitFunc f)
+                    : func(f)
+                {
+                }
+
+                void operator()(RGBA* dst, const RGBA* src, int len) {
+                    func(dst, len, src, len, len, 1);
+                }
+            };
+
+            // same for color modulating kernels
+            struct BlitColRun {
+                BlitColFunc func;
+                RGBA        color;
+
+                BlitColRun(BlitColFunc f, RGBA c)
+                    : func(f)
+                    , color(c)
+                {
+                }
+
+                void operator()(RGBA* dst, const RGBA* src, int len) {
+                    func(dst, len, src, len, len, 1, color);
+                }
+            };
+
+            // rows and columns of the blocks the transpose kernels work through
+            const int TransposeTileSize = 16;
+
+            // selected by InitKernels(), generic until then
+            extern KernelTable Table;
+
+            void InitKernels();
+
+            // used by InitKernels()
+            void InitSse2Kernels(KernelTable& table);
+            void InitAvx2Kernels(KernelTable& table);
+
+        } // namespace kernels
+    } // namespace graphics
+} // namespace rpgss
+
+
+#endif // RPGSS_GRAPHICS_KERNELS_HPP_INCLUDED
@@ -0,0 +1,947 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "kernels.hpp"
+
+// everything below is compiled for AVX2 and only reached
+// through the kernel table if the CPU supports it
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace kernels {
+
+            namespace {
+
+                //-----------------------------------------------------------------
+                template<typename Operation>
+                void blit(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, Operation operation)
+                {
+                    int di = dstPitch - width;
+                    int si = srcPitch - width;
+
+                    int num_blocks    = width / 8;
+                    int num_remaining = width % 8;
+
+                    // masked loads and stores take care of the remaining pixels
+                    __m256i mtail = _mm256_cmpgt_epi32(_mm256_set1_epi32(num_remaining), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+
+                    int iy = height;
+                    while (iy > 0) {
+
+                        int ix = num_blocks;
+                        while (ix > 0) {
+                            __m256i ms = _mm256_loadu_si256((const __m256i*)src);
+                            if (!operation.skip(ms)) {
+                                __m256i md = _mm256_loadu_si256((const __m256i*)dst);
+                                _mm256_storeu_si256((__m256i*)dst, operation(md, ms));
+                            }
+                            dst += 8;
+                            src += 8;
+                            ix--;
+                        }
+
+                        if (num_remaining > 0) {
+                            __m256i ms = _mm256_maskload_epi32((const int*)src, mtail);
+                            if (!operation.skip(ms)) {
+                                __m256i md = _mm256_maskload_epi32((const int*)dst, mtail);
+                                _mm256_maskstore_epi32((int*)dst, mtail, operation(md, ms));
+                            }
+                            dst += num_remaining;
+                            src += num_remaining;
+                        }
+
+                        dst += di;
+                        src += si;
+                        iy--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                template<typename Operation>
+                void transform(RGBA* dst, int dstPitch, int width, int height, Operation operation)
+                {
+                    int num_blocks    = width / 8;
+                    int num_remaining = width % 8;
+
+                    __m256i mtail = _mm256_cmpgt_epi32(_mm256_set1_epi32(num_remaining), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* dp = dst + iy * dstPitch;
+
+                        int ix = num_blocks;
+                        while (ix > 0) {
+                            _mm256_storeu_si256((__m256i*)dp, operation(_mm256_loadu_si256((const __m256i*)dp)));
+                            dp += 8;
+                            ix--;
+                        }
+
+                        if (num_remaining > 0) {
+                            _mm256_maskstore_epi32((int*)dp, mtail, operation(_mm256_maskload_epi32((const int*)dp, mtail)));
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                inline __m256i modulate(__m256i ms, __m256i mcol)
+                {
+                    __m256i mnull = _mm256_setzero_si256();
+                    __m256i t1 = _mm256_unpacklo_epi8(ms, mnull);
+                    __m256i t2 = _mm256_unpackhi_epi8(ms, mnull);
+                    t1 = _mm256_mullo_epi16(t1, mcol);
+                    t2 = _mm256_mullo_epi16(t2, mcol);
+                    t1 = _mm256_srli_epi16(t1, 8);
+                    t2 = _mm256_srli_epi16(t2, 8);
+                    return _mm256_packus_epi16(t1, t2);
+                }
+
+                //-----------------------------------------------------------------
+                inline __m256i mix(__m256i md, __m256i ms)
+                {
+                    __m256i mnull  = _mm256_setzero_si256();
+                    __m256i mone   = _mm256_set1_epi16(1);
+                    __m256i m256   = _mm256_set1_epi16(256);
+                    __m256i malpha = _mm256_set1_epi32(0xFF000000);
+                    __m256i t1, t2, t3, a1, a2;
+
+                    // fully opaque, copy color and keep destination alpha
+                    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(ms, malpha), malpha)) == -1) {
+                        return _mm256_or_si256(_mm256_andnot_si256(malpha, ms), _mm256_and_si256(md, malpha));
+                    }
+
+                    // mix lower halves
+                    t1 = _mm256_unpacklo_epi8(ms, mnull);
+                    t2 = _mm256_unpacklo_epi8(md, mnull);
+                    a1 = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(t1, 0xFF), 0xFF);
+                    a2 = _mm256_sub_epi16(m256, a1);
+                    a1 = _mm256_add_epi16(a1, mone);
+                    t1 = _mm256_add_epi16(_mm256_mullo_epi16(t1, a1), _mm256_mullo_epi16(t2, a2));
+                    t1 = _mm256_srli_epi16(t1, 8);
+
+                    // mix upper halves
+                    t2 = _mm256_unpackhi_epi8(ms, mnull);
+                    t3 = _mm256_unpackhi_epi8(md, mnull);
+                    a1 = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(t2, 0xFF), 0xFF);
+                    a2 = _mm256_sub_epi16(m256, a1);
+                    a1 = _mm256_add_epi16(a1, mone);
+                    t2 = _mm256_add_epi16(_mm256_mullo_epi16(t2, a1), _mm256_mullo_epi16(t3, a2));
+                    t2 = _mm256_srli_epi16(t2, 8);
+
+                    // combine and keep destination alpha
+                    t1 = _mm256_packus_epi16(t1, t2);
+                    return _mm256_or_si256(_mm256_andnot_si256(malpha, t1), _mm256_and_si256(md, malpha));
+                }
+
+                //-----------------------------------------------------------------
+                inline __m256i mix_pm(__m256i md, __m256i ms)
+                {
+                    __m256i mnull  = _mm256_setzero_si256();
+                    __m256i m256   = _mm256_set1_epi16(256);
+                    __m256i malpha = _mm256_set1_epi32(0xFF000000);
+                    __m256i t1, t2, t3, a1;
+
+                    t1 = _mm256_unpacklo_epi8(ms, mnull);
+                    t2 = _mm256_unpacklo_epi8(md, mnull);
+                    a1 = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(t1, 0xFF), 0xFF);
+                    a1 = _mm256_sub_epi16(m256, a1);
+                    t2 = _mm256_srli_epi16(_mm256_mullo_epi16(t2, a1), 8);
+                    t1 = _mm256_add_epi16(t1, t2);
+
+                    t2 = _mm256_unpackhi_epi8(ms, mnull);
+                    t3 = _mm256_unpackhi_epi8(md, mnull);
+                    a1 = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(t2, 0xFF), 0xFF);
+                    a1 = _mm256_sub_epi16(m256, a1);
+                    t3 = _mm256_srli_epi16(_mm256_mullo_epi16(t3, a1), 8);
+                    t2 = _mm256_add_epi16(t2, t3);
+
+                    // combine and keep destination alpha
+                    t1 = _mm256_packus_epi16(t1, t2);
+                    return _mm256_or_si256(_mm256_andnot_si256(malpha, t1), _mm256_and_si256(md, malpha));
+                }
+
+                //-----------------------------------------------------------------
+                inline __m256i mul(__m256i md, __m256i ms)
+                {
+                    __m256i mnull = _mm256_setzero_si256();
+                    __m256i mone  = _mm256_set1_epi16(1);
+
+                    __m256i t1 = _mm256_unpacklo_epi8(ms, mnull);
+                    __m256i t2 = _mm256_unpacklo_epi8(md, mnull);
+                    t1 = _mm256_adds_epu16(t1, mone);
+                    t1 = _mm256_mullo_epi16(t1, t2);
+                    t1 = _mm256_srli_epi16(t1, 8);
+
+                    __m256i u1 = _mm256_unpackhi_epi8(ms, mnull);
+                    __m256i u2 = _mm256_unpackhi_epi8(md, mnull);
+                    u1 = _mm256_adds_epu16(u1, mone);
+                    u1 = _mm256_mullo_epi16(u1, u2);
+                    u1 = _mm256_srli_epi16(u1, 8);
+
+                    return _mm256_packus_epi16(t1, u1);
+                }
+
+                //-----------------------------------------------------------------
+                inline bool all_transparent(__m256i ms)
+                {
+                    __m256i ma = _mm256_and_si256(ms, _mm256_set1_epi32(0xFF000000));
+                    return _mm256_movemask_epi8(_mm256_cmpeq_epi32(ma, _mm256_setzero_si256())) == -1;
+                }
+
+                //-----------------------------------------------------------------
+                inline bool all_zero(__m256i ms)
+                {
+                    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(ms, _mm256_setzero_si256())) == -1;
+                }
+
+                //-----------------------------------------------------------------
+                struct avx2_op {
+                    bool skip(__m256i ms) {
+                        return false;
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_col_op : avx2_op {
+                    __m256i mcol;
+
+                    explicit avx2_col_op(RGBA c)
+                        : mcol(_mm256_set_epi16(
+                            c.alpha + 1, c.blue + 1, c.green + 1, c.red + 1, c.alpha + 1, c.blue + 1, c.green + 1, c.red + 1,
+                            c.alpha + 1, c.blue + 1, c.green + 1, c.red + 1, c.alpha + 1, c.blue + 1, c.green + 1, c.red + 1))
+                    {
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_set : avx2_op {
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return ms;
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_set_rgb : avx2_op {
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        __m256i malpha = _mm256_set1_epi32(0xFF000000);
+                        return _mm256_or_si256(_mm256_andnot_si256(malpha, ms), _mm256_and_si256(md, malpha));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_set_rgb_masked {
+                    bool skip(__m256i ms) {
+                        return all_transparent(ms);
+                    }
+
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        __m256i malpha = _mm256_set1_epi32(0xFF000000);
+                        __m256i mskip  = _mm256_cmpeq_epi32(_mm256_and_si256(ms, malpha), _mm256_setzero_si256());
+                        __m256i mres   = _mm256_or_si256(_mm256_andnot_si256(malpha, ms), _mm256_and_si256(md, malpha));
+                        return _mm256_blendv_epi8(mres, md, mskip);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_mix {
+                    bool skip(__m256i ms) {
+                        return all_transparent(ms);
+                    }
+
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return mix(md, ms);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_add : avx2_op {
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return _mm256_adds_epu8(md, ms);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_sub : avx2_op {
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return _mm256_subs_epu8(md, ms);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_mul : avx2_op {
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return mul(md, ms);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_mix_pm {
+                    bool skip(__m256i ms) {
+                        return all_zero(ms);
+                    }
+
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return mix_pm(md, ms);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_set_col : avx2_col_op {
+                    explicit avx2_set_col(RGBA c) : avx2_col_op(c) { }
+
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return modulate(ms, mcol);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_mix_col : avx2_col_op {
+                    explicit avx2_mix_col(RGBA c) : avx2_col_op(c) { }
+
+                    bool skip(__m256i ms) {
+                        return all_transparent(ms);
+                    }
+
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return mix(md, modulate(ms, mcol));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_add_col : avx2_col_op {
+                    explicit avx2_add_col(RGBA c) : avx2_col_op(c) { }
+
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return _mm256_adds_epu8(md, modulate(ms, mcol));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_sub_col : avx2_col_op {
+                    explicit avx2_sub_col(RGBA c) : avx2_col_op(c) { }
+
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return _mm256_subs_epu8(md, modulate(ms, mcol));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_mul_col : avx2_col_op {
+                    explicit avx2_mul_col(RGBA c) : avx2_col_op(c) { }
+
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return mul(md, modulate(ms, mcol));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_mix_pm_col {
+                    __m256i mcol;
+
+                    // the color's alpha scales the premultiplied color channels too
+                    explicit avx2_mix_pm_col(RGBA c)
+                    {
+                        int ca = c.alpha + 1;
+                        int cr = (c.red   + 1) * ca >> 8;
+                        int cg = (c.green + 1) * ca >> 8;
+                        int cb = (c.blue  + 1) * ca >> 8;
+                        mcol = _mm256_set_epi16(ca, cb, cg, cr, ca, cb, cg, cr, ca, cb, cg, cr, ca, cb, cg, cr);
+                    }
+
+                    bool skip(__m256i ms) {
+                        return all_zero(ms);
+                    }
+
+                    __m256i operator()(__m256i md, __m256i ms) {
+                        return mix_pm(md, modulate(ms, mcol));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_grey {
+                    __m256i operator()(__m256i mp) {
+                        __m256i m255 = _mm256_set1_epi32(0xFF);
+                        __m256i msum = _mm256_add_epi32(_mm256_and_si256(mp, m255), _mm256_and_si256(_mm256_srli_epi32(mp, 8), m255));
+                        msum = _mm256_add_epi32(msum, _mm256_and_si256(_mm256_srli_epi32(mp, 16), m255));
+
+                        // (sum * 21846) >> 16 equals sum / 3 for every sum up to 765
+                        __m256i mq = _mm256_mulhi_epu16(msum, _mm256_set1_epi32(21846));
+                        mq = _mm256_or_si256(mq, _mm256_slli_epi32(mq, 8));
+                        mq = _mm256_or_si256(mq, _mm256_slli_epi32(mq, 8));
+
+                        return _mm256_or_si256(mq, _mm256_and_si256(mp, _mm256_set1_epi32(0xFF000000)));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_invert {
+                    __m256i operator()(__m256i mp) {
+                        return _mm256_xor_si256(mp, _mm256_set1_epi32(0x00FFFFFF));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_invert_pm {
+                    __m256i operator()(__m256i mp) {
+                        __m256i malpha = _mm256_set1_epi32(0xFF000000);
+
+                        // alpha in every channel
+                        __m256i ma = _mm256_shuffle_epi8(mp, _mm256_setr_epi32(
+                            0x03030303, 0x07070707, 0x0B0B0B0B, 0x0F0F0F0F,
+                            0x03030303, 0x07070707, 0x0B0B0B0B, 0x0F0F0F0F));
+
+                        return _mm256_blendv_epi8(_mm256_subs_epu8(ma, mp), mp, malpha);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_set_alpha {
+                    __m256i malpha;
+
+                    explicit avx2_set_alpha(int alpha)
+                        : malpha(_mm256_set1_epi32((alpha & 0xFF) << 24))
+                    {
+                    }
+
+                    __m256i operator()(__m256i mp) {
+                        return _mm256_blendv_epi8(mp, malpha, _mm256_set1_epi32(0xFF000000));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct avx2_swizzle {
+                    __m256i mshuffle;
+
+                    // byte indices of the source channels, per 128-bit lane
+                    explicit avx2_swizzle(int order)
+                    {
+                        int m = ((order >> 0) & 3) | (((order >> 2) & 3) << 8) | (((order >> 4) & 3) << 16) | (((order >> 6) & 3) << 24);
+                        mshuffle = _mm256_setr_epi32(
+                            m, m + 0x04040404, m + 0x08080808, m + 0x0C0C0C0C,
+                            m, m + 0x04040404, m + 0x08080808, m + 0x0C0C0C0C);
+                    }
+
+                    __m256i operator()(__m256i mp) {
+                        return _mm256_shuffle_epi8(mp, mshuffle);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                template<bool premultiplied>
+                struct avx2_color_matrix {
+                    // coefficient pairs for the (red, blue) and (green, alpha) words
+                    __m256i mrb[4];
+                    __m256i mga[4];
+                    __m256i moffset[4];
+
+                    explicit avx2_color_matrix(const int* m)
+                    {
+                        for (int i = 0; i < 4; i++) {
+                            const int* row = m + i * 5;
+                            mrb[i]     = _mm256_unpacklo_epi16(_mm256_set1_epi16(row[0]), _mm256_set1_epi16(row[2]));
+                            mga[i]     = _mm256_unpacklo_epi16(_mm256_set1_epi16(row[1]), _mm256_set1_epi16(row[3]));
+                            moffset[i] = _mm256_set1_epi32(row[4] + 128);
+                        }
+                    }
+
+                    __m256i channel(__m256i rb, __m256i ga, int i) {
+                        __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(rb, mrb[i]), _mm256_madd_epi16(ga, mga[i]));
+                        return _mm256_srai_epi32(_mm256_add_epi32(sum, moffset[i]), 8);
+                    }
+
+                    // each 128-bit lane works on its own four pixels
+                    __m256i operator()(__m256i mp) {
+                        __m256i mmask = _mm256_set1_epi32(0x00FF00FF);
+                        __m256i rb = _mm256_and_si256(mp, mmask);
+                        __m256i ga = _mm256_and_si256(_mm256_srli_epi32(mp, 8), mmask);
+
+                        // (r0..r3, g0..g3) and (b0..b3, a0..a3) per lane, clamped to 0..255
+                        __m256i mnull = _mm256_setzero_si256();
+                        __m256i m255  = _mm256_set1_epi16(255);
+                        __m256i rg = _mm256_packs_epi32(channel(rb, ga, 0), channel(rb, ga, 1));
+                        __m256i ba = _mm256_packs_epi32(channel(rb, ga, 2), channel(rb, ga, 3));
+                        rg = _mm256_min_epi16(_mm256_max_epi16(rg, mnull), m255);
+                        ba = _mm256_min_epi16(_mm256_max_epi16(ba, mnull), m255);
+
+                        if (premultiplied) {
+                            __m256i aa = _mm256_unpackhi_epi64(ba, ba);
+                            rg = _mm256_min_epi16(rg, aa);
+                            ba = _mm256_min_epi16(ba, aa);
+                        }
+
+                        __m256i lo = _mm256_or_si256(rg, _mm256_slli_epi16(_mm256_srli_si256(rg, 8), 8));
+                        __m256i hi = _mm256_or_si256(ba, _mm256_slli_epi16(_mm256_srli_si256(ba, 8), 8));
+                        return _mm256_unpacklo_epi16(lo, hi);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                void clear_avx2(RGBA* dst, int dstPitch, int width, int height, RGBA color)
+                {
+                    if (dstPitch == width) {
+                        width *= height;
+                        height = 1;
+                    }
+
+                    __m256i mcolor = _mm256_set1_epi32(*((int*)&color));
+
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* dp = dst + iy * dstPitch;
+                        int   n  = width;
+
+                        while (n > 0 && ((uintptr_t)dp & 31)) {
+                            *dp = color;
+                            dp++;
+                            n--;
+                        }
+
+                        while (n >= 8) {
+                            _mm256_store_si256((__m256i*)dp, mcolor);
+                            dp += 8;
+                            n  -= 8;
+                        }
+
+                        while (n > 0) {
+                            *dp = color;
+                            dp++;
+                            n--;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void set_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_set());
+                }
+
+                //-----------------------------------------------------------------
+                void set_rgb_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_set_rgb());
+                }
+
+                //-----------------------------------------------------------------
+                void set_rgb_masked_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_set_rgb_masked());
+                }
+
+                //-----------------------------------------------------------------
+                void mix_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_mix());
+                }
+
+                //-----------------------------------------------------------------
+                void add_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_add());
+                }
+
+                //-----------------------------------------------------------------
+                void sub_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_sub());
+                }
+
+                //-----------------------------------------------------------------
+                void mul_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_mul());
+                }
+
+                //-----------------------------------------------------------------
+                void mix_pm_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_mix_pm());
+                }
+
+                //-----------------------------------------------------------------
+                void set_col_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_set_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void mix_col_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_mix_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void add_col_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_add_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void sub_col_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_sub_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void mul_col_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_mul_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void mix_pm_col_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, avx2_mix_pm_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void sample_nearest_avx2(RGBA* dst, const RGBA* src, int srcPitch, int width, int height, int u, int v, int du, int dv, int count)
+                {
+                    // round to the nearest texel
+                    u += 0x8000;
+                    v += 0x8000;
+
+                    __m256i mstep  = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+                    __m256i mu     = _mm256_add_epi32(_mm256_set1_epi32(u), _mm256_mullo_epi32(mstep, _mm256_set1_epi32(du)));
+                    __m256i mv     = _mm256_add_epi32(_mm256_set1_epi32(v), _mm256_mullo_epi32(mstep, _mm256_set1_epi32(dv)));
+                    __m256i mdu    = _mm256_set1_epi32(du * 8);
+                    __m256i mdv    = _mm256_set1_epi32(dv * 8);
+                    __m256i mnull  = _mm256_setzero_si256();
+                    __m256i mxmax  = _mm256_set1_epi32(width  - 1);
+                    __m256i mymax  = _mm256_set1_epi32(height - 1);
+                    __m256i mpitch = _mm256_set1_epi32(srcPitch);
+
+                    while (count >= 8) {
+                        __m256i mx = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(mu, 16), mnull), mxmax);
+                        __m256i my = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(mv, 16), mnull), mymax);
+                        __m256i mi = _mm256_add_epi32(_mm256_mullo_epi32(my, mpitch), mx);
+
+                        _mm256_storeu_si256((__m256i*)dst, _mm256_i32gather_epi32((const int*)src, mi, 4));
+
+                        mu = _mm256_add_epi32(mu, mdu);
+                        mv = _mm256_add_epi32(mv, mdv);
+                        u += du * 8;
+                        v += dv * 8;
+                        dst   += 8;
+                        count -= 8;
+                    }
+
+                    while (count > 0) {
+                        int x = std::min(std::max(u >> 16, 0), width  - 1);
+                        int y = std::min(std::max(v >> 16, 0), height - 1);
+
+                        *dst = src[y * srcPitch + x];
+
+                        u += du;
+                        v += dv;
+                        dst++;
+                        count--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void grey_avx2(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    transform(dst, dstPitch, width, height, avx2_grey());
+                }
+
+                //-----------------------------------------------------------------
+                void invert_avx2(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    transform(dst, dstPitch, width, height, avx2_invert());
+                }
+
+                //-----------------------------------------------------------------
+                void invert_pm_avx2(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    transform(dst, dstPitch, width, height, avx2_invert_pm());
+                }
+
+                //-----------------------------------------------------------------
+                void set_alpha_avx2(RGBA* dst, int dstPitch, int width, int height, int alpha)
+                {
+                    transform(dst, dstPitch, width, height, avx2_set_alpha(alpha));
+                }
+
+                //-----------------------------------------------------------------
+                void swizzle_avx2(RGBA* dst, int dstPitch, int width, int height, int order)
+                {
+                    transform(dst, dstPitch, width, height, avx2_swizzle(order));
+                }
+
+                //-----------------------------------------------------------------
+                void mirror_avx2(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    __m256i mreverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* l = dst + iy * dstPitch;
+                        RGBA* r = l + width;
+
+                        // exchange reversed blocks from both ends
+                        while (r - l >= 16) {
+                            __m256i ml = _mm256_loadu_si256((const __m256i*)l);
+                            __m256i mr = _mm256_loadu_si256((const __m256i*)(r - 8));
+                            _mm256_storeu_si256((__m256i*)l,       _mm256_permutevar8x32_epi32(mr, mreverse));
+                            _mm256_storeu_si256((__m256i*)(r - 8), _mm256_permutevar8x32_epi32(ml, mreverse));
+                            l += 8;
+                            r -= 8;
+                        }
+
+                        r--;
+                        while (l < r) {
+                            std::swap(*l, *r);
+                            l++;
+                            r--;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void swap_avx2(RGBA* a, RGBA* b, int count)
+                {
+                    while (count >= 8) {
+                        __m256i ma = _mm256_loadu_si256((const __m256i*)a);
+                        __m256i mb = _mm256_loadu_si256((const __m256i*)b);
+                        _mm256_storeu_si256((__m256i*)a, mb);
+                        _mm256_storeu_si256((__m256i*)b, ma);
+                        a += 8;
+                        b += 8;
+                        count -= 8;
+                    }
+                    std::swap_ranges(a, a + count, b);
+                }
+
+                //-----------------------------------------------------------------
+                void swap_mirrored_avx2(RGBA* a, RGBA* b, int count)
+                {
+                    __m256i mreverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+                    // a moves forward, the end of b moves back
+                    while (count >= 8) {
+                        __m256i ma = _mm256_loadu_si256((const __m256i*)a);
+                        __m256i mb = _mm256_loadu_si256((const __m256i*)(b + count - 8));
+                        _mm256_storeu_si256((__m256i*)a,               _mm256_permutevar8x32_epi32(mb, mreverse));
+                        _mm256_storeu_si256((__m256i*)(b + count - 8), _mm256_permutevar8x32_epi32(ma, mreverse));
+                        a += 8;
+                        count -= 8;
+                    }
+                    std::swap_ranges(a, a + count, std::reverse_iterator<RGBA*>(b + count));
+                }
+
+                //-----------------------------------------------------------------
+                inline void transpose8x8(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch)
+                {
+                    __m256i r0 = _mm256_loadu_si256((const __m256i*)(src + 0 * srcPitch));
+                    __m256i r1 = _mm256_loadu_si256((const __m256i*)(src + 1 * srcPitch));
+                    __m256i r2 = _mm256_loadu_si256((const __m256i*)(src + 2 * srcPitch));
+                    __m256i r3 = _mm256_loadu_si256((const __m256i*)(src + 3 * srcPitch));
+                    __m256i r4 = _mm256_loadu_si256((const __m256i*)(src + 4 * srcPitch));
+                    __m256i r5 = _mm256_loadu_si256((const __m256i*)(src + 5 * srcPitch));
+                    __m256i r6 = _mm256_loadu_si256((const __m256i*)(src + 6 * srcPitch));
+                    __m256i r7 = _mm256_loadu_si256((const __m256i*)(src + 7 * srcPitch));
+
+                    // 2x2 blocks within each 128-bit lane
+                    __m256i t0 = _mm256_unpacklo_epi32(r0, r1);
+                    __m256i t1 = _mm256_unpackhi_epi32(r0, r1);
+                    __m256i t2 = _mm256_unpacklo_epi32(r2, r3);
+                    __m256i t3 = _mm256_unpackhi_epi32(r2, r3);
+                    __m256i t4 = _mm256_unpacklo_epi32(r4, r5);
+                    __m256i t5 = _mm256_unpackhi_epi32(r4, r5);
+                    __m256i t6 = _mm256_unpacklo_epi32(r6, r7);
+                    __m256i t7 = _mm256_unpackhi_epi32(r6, r7);
+
+                    // 4x4 blocks within each 128-bit lane
+                    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+                    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+                    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+                    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+                    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+                    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+                    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+                    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+                    // and across the lanes
+                    _mm256_storeu_si256((__m256i*)(dst + 0 * dstPitch), _mm256_permute2x128_si256(u0, u4, 0x20));
+                    _mm256_storeu_si256((__m256i*)(dst + 1 * dstPitch), _mm256_permute2x128_si256(u1, u5, 0x20));
+                    _mm256_storeu_si256((__m256i*)(dst + 2 * dstPitch), _mm256_permute2x128_si256(u2, u6, 0x20));
+                    _mm256_storeu_si256((__m256i*)(dst + 3 * dstPitch), _mm256_permute2x128_si256(u3, u7, 0x20));
+                    _mm256_storeu_si256((__m256i*)(dst + 4 * dstPitch), _mm256_permute2x128_si256(u0, u4, 0x31));
+                    _mm256_storeu_si256((__m256i*)(dst + 5 * dstPitch), _mm256_permute2x128_si256(u1, u5, 0x31));
+                    _mm256_storeu_si256((__m256i*)(dst + 6 * dstPitch), _mm256_permute2x128_si256(u2, u6, 0x31));
+                    _mm256_storeu_si256((__m256i*)(dst + 7 * dstPitch), _mm256_permute2x128_si256(u3, u7, 0x31));
+                }
+
+                //-----------------------------------------------------------------
+                void transpose_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    // tile by tile, so both sides stay in the cache
+                    for (int ty = 0; ty < height; ty += TransposeTileSize) {
+                        for (int tx = 0; tx < width; tx += TransposeTileSize) {
+                            int th = std::min(TransposeTileSize, height - ty);
+                            int tw = std::min(TransposeTileSize, width  - tx);
+                            int bh = th & ~7;
+                            int bw = tw & ~7;
+
+                            for (int y = ty; y < ty + bh; y += 8) {
+                                for (int x = tx; x < tx + bw; x += 8) {
+                                    transpose8x8(dst + x * dstPitch + y, dstPitch, src + y * srcPitch + x, srcPitch);
+                                }
+                            }
+
+                            // pixels outside the 8x8 blocks at the image edges
+                            if (bh < th || bw < tw) {
+                                for (int y = ty; y < ty + th; y++) {
+                                    for (int x = (y < ty + bh ? tx + bw : tx); x < tx + tw; x++) {
+                                        dst[x * dstPitch + y] = src[y * srcPitch + x];
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void blur_columns_avx2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, int radius)
+                {
+                    __m256i mnull   = _mm256_setzero_si256();
+                    __m256i mfactor = _mm256_set1_epi16((short)BoxBlurFactor(radius));
+                    __m256i mindex  = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+                    // the windows of all columns move down together, thirty-two
+                    // sums for every block of eight pixels, in the order of the
+                    // unpacks within the 128-bit lanes, which the pack undoes
+                    std::vector<u16> sums((width + 7) / 8 * 32);
+
+                    for (int ix = 0; ix < width; ix += 8) {
+                        __m256i mmask = _mm256_cmpgt_epi32(_mm256_set1_epi32(width - ix), mindex);
+                        __m256i mp    = _mm256_maskload_epi32((const int*)(src + ix), mmask);
+                        __m256i lo    = _mm256_mullo_epi16(_mm256_unpacklo_epi8(mp, mnull), _mm256_set1_epi16(radius + 1));
+                        __m256i hi    = _mm256_mullo_epi16(_mm256_unpackhi_epi8(mp, mnull), _mm256_set1_epi16(radius + 1));
+                        for (int k = 1; k <= radius; k++) {
+                            mp = _mm256_maskload_epi32((const int*)(src + std::min(k, height - 1) * srcPitch + ix), mmask);
+                            lo = _mm256_add_epi16(lo, _mm256_unpacklo_epi8(mp, mnull));
+                            hi = _mm256_add_epi16(hi, _mm256_unpackhi_epi8(mp, mnull));
+                        }
+                        _mm256_storeu_si256((__m256i*)&sums[ix * 4],      lo);
+                        _mm256_storeu_si256((__m256i*)&sums[ix * 4 + 16], hi);
+                    }
+
+                    int num_blocks = width / 8 * 8;
+
+                    for (int iy = 0; iy < height; iy++) {
+                        const RGBA* in  = src + std::min(iy + radius + 1, height - 1) * srcPitch;
+                        const RGBA* out = src + std::max(iy - radius, 0) * srcPitch;
+                        RGBA*       dp  = dst + iy * dstPitch;
+
+                        for (int ix = 0; ix < width; ix += 8) {
+                            __m256i lo = _mm256_loadu_si256((const __m256i*)&sums[ix * 4]);
+                            __m256i hi = _mm256_loadu_si256((const __m256i*)&sums[ix * 4 + 16]);
+                            __m256i mp = _mm256_packus_epi16(_mm256_mulhi_epu16(lo, mfactor), _mm256_mulhi_epu16(hi, mfactor));
+
+                            __m256i mi;
+                            __m256i mo;
+                            if (ix < num_blocks) {
+                                _mm256_storeu_si256((__m256i*)(dp + ix), mp);
+                                mi = _mm256_loadu_si256((const __m256i*)(in  + ix));
+                                mo = _mm256_loadu_si256((const __m256i*)(out + ix));
+                            } else {
+                                __m256i mmask = _mm256_cmpgt_epi32(_mm256_set1_epi32(width - ix), mindex);
+                                _mm256_maskstore_epi32((int*)(dp + ix), mmask, mp);
+                                mi = _mm256_maskload_epi32((const int*)(in  + ix), mmask);
+                                mo = _mm256_maskload_epi32((const int*)(out + ix), mmask);
+                            }
+
+                            lo = _mm256_sub_epi16(_mm256_add_epi16(lo, _mm256_unpacklo_epi8(mi, mnull)), _mm256_unpacklo_epi8(mo, mnull));
+                            hi = _mm256_sub_epi16(_mm256_add_epi16(hi, _mm256_unpackhi_epi8(mi, mnull)), _mm256_unpackhi_epi8(mo, mnull));
+                            _mm256_storeu_si256((__m256i*)&sums[ix * 4],      lo);
+                            _mm256_storeu_si256((__m256i*)&sums[ix * 4 + 16], hi);
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void color_matrix_avx2(RGBA* dst, int dstPitch, int width, int height, const int* matrix)
+                {
+                    transform(dst, dstPitch, width, height, avx2_color_matrix<false>(matrix));
+                }
+
+                //-----------------------------------------------------------------
+                void color_matrix_pm_avx2(RGBA* dst, int dstPitch, int width, int height, const int* matrix)
+                {
+                    transform(dst, dstPitch, width, height, avx2_color_matrix<true>(matrix));
+                }
+
+            } // anonymous namespace
+
+            //-----------------------------------------------------------------
+            void InitAvx2Kernels(KernelTable& table)
+            {
+                table.name   = "AVX2";
+                table.clear  = clear_avx2;
+                table.set    = set_avx2;
+                table.mix    = mix_avx2;
+                table.add    = add_avx2;
+                table.sub    = sub_avx2;
+                table.mul    = mul_avx2;
+                table.setCol = set_col_avx2;
+                table.mixCol = mix_col_avx2;
+                table.addCol = add_col_avx2;
+                table.subCol = sub_col_avx2;
+                table.mulCol = mul_col_avx2;
+
+                table.mixPremul    = mix_pm_avx2;
+                table.setRgb       = set_rgb_avx2;
+                table.setRgbMasked = set_rgb_masked_avx2;
+                table.mixPremulCol = mix_pm_col_avx2;
+
+                table.sampleNearest = sample_nearest_avx2;
+
+                table.grey         = grey_avx2;
+                table.invert       = invert_avx2;
+                table.invertPremul = invert_pm_avx2;
+                table.mirror       = mirror_avx2;
+                table.setAlpha     = set_alpha_avx2;
+                table.swizzle      = swizzle_avx2;
+                table.swap         = swap_avx2;
+                table.swapMirrored = swap_mirrored_avx2;
+                table.transpose    = transpose_avx2;
+                table.blurColumns  = blur_columns_avx2; // the row sums are serial, blurRows stays SSE2
+
+                table.colorMatrix       = color_matrix_avx2;
+                table.colorMatrixPremul = color_matrix_pm_avx2;
+            }
+
+        } // namespace kernels
+    } // namespace graphics
+} // namespace rpgss
+
+#pragma GCC pop_options
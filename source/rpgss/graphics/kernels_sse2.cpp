@@ -0,0 +1,1069 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <stdint.h>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include <emmintrin.h>
+
+#include "renderers.hpp"
+#include "kernels.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace kernels {
+
+            namespace {
+
+                //-----------------------------------------------------------------
+                template<typename Operation, typename Renderer>
+                void blit(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, Operation operation, Renderer fallback_renderer)
+                {
+                    int di = dstPitch - width;
+                    int si = srcPitch - width;
+
+                    int num_blocks    = width / 4;
+                    int num_remaining = width % 4;
+
+                    int iy = height;
+                    while (iy > 0) {
+
+                        int ix = num_blocks;
+                        while (ix > 0) {
+                            operation(dst, src);
+                            dst += 4;
+                            src += 4;
+                            ix--;
+                        }
+
+                        ix = num_remaining;
+                        while (ix > 0) {
+                            fallback_renderer(dst, src);
+                            dst++;
+                            src++;
+                            ix--;
+                        }
+
+                        dst += di;
+                        src += si;
+                        iy--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                template<typename Operation>
+                void transform(RGBA* dst, int dstPitch, int width, int height, Operation operation)
+                {
+                    int num_blocks    = width / 4;
+                    int num_remaining = width % 4;
+
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* dp = dst + iy * dstPitch;
+
+                        int ix = num_blocks;
+                        while (ix > 0) {
+                            _mm_storeu_si128((__m128i*)dp, operation(_mm_loadu_si128((const __m128i*)dp)));
+                            dp += 4;
+                            ix--;
+                        }
+
+                        // the remaining pixels go through a temporary block
+                        if (num_remaining > 0) {
+                            RGBA block[4];
+                            std::copy(dp, dp + num_remaining, block);
+                            _mm_storeu_si128((__m128i*)block, operation(_mm_loadu_si128((const __m128i*)block)));
+                            std::copy(block, block + num_remaining, dp);
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                inline __m128i modulate(__m128i ms, __m128i mcol)
+                {
+                    __m128i mnull = _mm_setzero_si128();
+                    __m128i t1 = _mm_unpacklo_epi8(ms, mnull);
+                    __m128i t2 = _mm_unpackhi_epi8(ms, mnull);
+                    t1 = _mm_mullo_epi16(t1, mcol);
+                    t2 = _mm_mullo_epi16(t2, mcol);
+                    t1 = _mm_srli_epi16(t1, 8);
+                    t2 = _mm_srli_epi16(t2, 8);
+                    return _mm_packus_epi16(t1, t2);
+                }
+
+                //-----------------------------------------------------------------
+                inline __m128i mix(__m128i md, __m128i ms)
+                {
+                    __m128i mnull  = _mm_setzero_si128();
+                    __m128i mone   = _mm_set1_epi16(1);
+                    __m128i m256   = _mm_set1_epi16(256);
+                    __m128i malpha = _mm_set1_epi32(0xFF000000);
+                    __m128i t1, t2, t3, a1, a2;
+
+                    // mix first two
+                    t1 = _mm_unpacklo_epi8(ms, mnull);
+                    t2 = _mm_unpacklo_epi8(md, mnull);
+                    a1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(t1, 0xFF), 0xFF);
+                    a2 = _mm_sub_epi16(m256, a1);
+                    a1 = _mm_add_epi16(a1, mone);
+                    t1 = _mm_add_epi16(_mm_mullo_epi16(t1, a1), _mm_mullo_epi16(t2, a2));
+                    t1 = _mm_srli_epi16(t1, 8);
+
+                    // mix next two
+                    t2 = _mm_unpackhi_epi8(ms, mnull);
+                    t3 = _mm_unpackhi_epi8(md, mnull);
+                    a1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(t2, 0xFF), 0xFF);
+                    a2 = _mm_sub_epi16(m256, a1);
+                    a1 = _mm_add_epi16(a1, mone);
+                    t2 = _mm_add_epi16(_mm_mullo_epi16(t2, a1), _mm_mullo_epi16(t3, a2));
+                    t2 = _mm_srli_epi16(t2, 8);
+
+                    // combine and keep destination alpha
+                    t1 = _mm_packus_epi16(t1, t2);
+                    return _mm_or_si128(_mm_andnot_si128(malpha, t1), _mm_and_si128(md, malpha));
+                }
+
+                //-----------------------------------------------------------------
+                inline __m128i mix_pm(__m128i md, __m128i ms)
+                {
+                    __m128i mnull  = _mm_setzero_si128();
+                    __m128i m256   = _mm_set1_epi16(256);
+                    __m128i malpha = _mm_set1_epi32(0xFF000000);
+                    __m128i t1, t2, t3, a1;
+
+                    // first two
+                    t1 = _mm_unpacklo_epi8(ms, mnull);
+                    t2 = _mm_unpacklo_epi8(md, mnull);
+                    a1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(t1, 0xFF), 0xFF);
+                    a1 = _mm_sub_epi16(m256, a1);
+                    t2 = _mm_srli_epi16(_mm_mullo_epi16(t2, a1), 8);
+                    t1 = _mm_add_epi16(t1, t2);
+
+                    // next two
+                    t2 = _mm_unpackhi_epi8(ms, mnull);
+                    t3 = _mm_unpackhi_epi8(md, mnull);
+                    a1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(t2, 0xFF), 0xFF);
+                    a1 = _mm_sub_epi16(m256, a1);
+                    t3 = _mm_srli_epi16(_mm_mullo_epi16(t3, a1), 8);
+                    t2 = _mm_add_epi16(t2, t3);
+
+                    // combine and keep destination alpha
+                    t1 = _mm_packus_epi16(t1, t2);
+                    return _mm_or_si128(_mm_andnot_si128(malpha, t1), _mm_and_si128(md, malpha));
+                }
+
+                //-----------------------------------------------------------------
+                inline __m128i mul(__m128i md, __m128i ms)
+                {
+                    __m128i mnull = _mm_setzero_si128();
+                    __m128i mone  = _mm_set1_epi16(1);
+
+                    // multiply first two
+                    __m128i t1 = _mm_unpacklo_epi8(ms, mnull);
+                    __m128i t2 = _mm_unpacklo_epi8(md, mnull);
+                    t1 = _mm_adds_epu16(t1, mone);
+                    t1 = _mm_mullo_epi16(t1, t2);
+                    t1 = _mm_srli_epi16(t1, 8);
+
+                    // multiply next two
+                    __m128i u1 = _mm_unpackhi_epi8(ms, mnull);
+                    __m128i u2 = _mm_unpackhi_epi8(md, mnull);
+                    u1 = _mm_adds_epu16(u1, mone);
+                    u1 = _mm_mullo_epi16(u1, u2);
+                    u1 = _mm_srli_epi16(u1, 8);
+
+                    // combine
+                    return _mm_packus_epi16(t1, u1);
+                }
+
+                //-----------------------------------------------------------------
+                inline bool all_transparent(__m128i ms)
+                {
+                    __m128i ma = _mm_and_si128(ms, _mm_set1_epi32(0xFF000000));
+                    return _mm_movemask_epi8(_mm_cmpeq_epi32(ma, _mm_setzero_si128())) == 0xFFFF;
+                }
+
+                //-----------------------------------------------------------------
+                inline bool all_opaque(__m128i ms)
+                {
+                    __m128i malpha = _mm_set1_epi32(0xFF000000);
+                    __m128i ma = _mm_and_si128(ms, malpha);
+                    return _mm_movemask_epi8(_mm_cmpeq_epi32(ma, malpha)) == 0xFFFF;
+                }
+
+                //-----------------------------------------------------------------
+                inline bool all_zero(__m128i ms)
+                {
+                    return _mm_movemask_epi8(_mm_cmpeq_epi8(ms, _mm_setzero_si128())) == 0xFFFF;
+                }
+
+                //-----------------------------------------------------------------
+                struct sse2_set {
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        _mm_storeu_si128((__m128i*)dp, _mm_loadu_si128((const __m128i*)sp));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_mix {
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+
+                        // fully transparent, nothing to do
+                        if (all_transparent(ms)) {
+                            return;
+                        }
+
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+
+                        // fully opaque, copy color and keep destination alpha
+                        if (all_opaque(ms)) {
+                            __m128i malpha = _mm_set1_epi32(0xFF000000);
+                            _mm_storeu_si128((__m128i*)dp, _mm_or_si128(_mm_andnot_si128(malpha, ms), _mm_and_si128(md, malpha)));
+                            return;
+                        }
+
+                        _mm_storeu_si128((__m128i*)dp, mix(md, ms));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_add {
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+                        _mm_storeu_si128((__m128i*)dp, _mm_adds_epu8(md, ms));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_sub {
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+                        _mm_storeu_si128((__m128i*)dp, _mm_subs_epu8(md, ms));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_mul {
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+                        _mm_storeu_si128((__m128i*)dp, mul(md, ms));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_mix_pm {
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+
+                        // nothing to add, nothing to do
+                        if (all_zero(ms)) {
+                            return;
+                        }
+
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+                        _mm_storeu_si128((__m128i*)dp, mix_pm(md, ms));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_set_rgb {
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i malpha = _mm_set1_epi32(0xFF000000);
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+                        _mm_storeu_si128((__m128i*)dp, _mm_or_si128(_mm_andnot_si128(malpha, ms), _mm_and_si128(md, malpha)));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_set_rgb_masked {
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+
+                        // fully transparent, nothing to do
+                        if (all_transparent(ms)) {
+                            return;
+                        }
+
+                        __m128i malpha = _mm_set1_epi32(0xFF000000);
+                        __m128i md     = _mm_loadu_si128((const __m128i*)dp);
+                        __m128i mskip  = _mm_cmpeq_epi32(_mm_and_si128(ms, malpha), _mm_setzero_si128());
+                        __m128i mres   = _mm_or_si128(_mm_andnot_si128(malpha, ms), _mm_and_si128(md, malpha));
+                        _mm_storeu_si128((__m128i*)dp, _mm_or_si128(_mm_and_si128(mskip, md), _mm_andnot_si128(mskip, mres)));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_col {
+                    __m128i mcol;
+
+                    explicit sse2_col(RGBA c)
+                        : mcol(_mm_set_epi16(c.alpha + 1, c.blue + 1, c.green + 1, c.red + 1, c.alpha + 1, c.blue + 1, c.green + 1, c.red + 1))
+                    {
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_set_col : sse2_col {
+                    explicit sse2_set_col(RGBA c) : sse2_col(c) { }
+
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+                        _mm_storeu_si128((__m128i*)dp, modulate(ms, mcol));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_mix_col : sse2_col {
+                    explicit sse2_mix_col(RGBA c) : sse2_col(c) { }
+
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+
+                        // fully transparent, nothing to do
+                        if (all_transparent(ms)) {
+                            return;
+                        }
+
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+                        _mm_storeu_si128((__m128i*)dp, mix(md, modulate(ms, mcol)));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_add_col : sse2_col {
+                    explicit sse2_add_col(RGBA c) : sse2_col(c) { }
+
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+                        _mm_storeu_si128((__m128i*)dp, _mm_adds_epu8(md, modulate(ms, mcol)));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_sub_col : sse2_col {
+                    explicit sse2_sub_col(RGBA c) : sse2_col(c) { }
+
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+                        _mm_storeu_si128((__m128i*)dp, _mm_subs_epu8(md, modulate(ms, mcol)));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_mul_col : sse2_col {
+                    explicit sse2_mul_col(RGBA c) : sse2_col(c) { }
+
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+                        _mm_storeu_si128((__m128i*)dp, mul(md, modulate(ms, mcol)));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_mix_pm_col {
+                    __m128i mcol;
+
+                    // the color's alpha scales the premultiplied color channels too
+                    explicit sse2_mix_pm_col(RGBA c)
+                    {
+                        int ca = c.alpha + 1;
+                        int cr = (c.red   + 1) * ca >> 8;
+                        int cg = (c.green + 1) * ca >> 8;
+                        int cb = (c.blue  + 1) * ca >> 8;
+                        mcol = _mm_set_epi16(ca, cb, cg, cr, ca, cb, cg, cr);
+                    }
+
+                    void operator()(RGBA* dp, const RGBA* sp) {
+                        __m128i ms = _mm_loadu_si128((const __m128i*)sp);
+
+                        // nothing to add, nothing to do
+                        if (all_zero(ms)) {
+                            return;
+                        }
+
+                        __m128i md = _mm_loadu_si128((const __m128i*)dp);
+                        _mm_storeu_si128((__m128i*)dp, mix_pm(md, modulate(ms, mcol)));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_grey {
+                    __m128i operator()(__m128i mp) {
+                        __m128i m255 = _mm_set1_epi32(0xFF);
+                        __m128i msum = _mm_add_epi32(_mm_and_si128(mp, m255), _mm_and_si128(_mm_srli_epi32(mp, 8), m255));
+                        msum = _mm_add_epi32(msum, _mm_and_si128(_mm_srli_epi32(mp, 16), m255));
+
+                        // (sum * 21846) >> 16 equals sum / 3 for every sum up to 765
+                        __m128i mq = _mm_mulhi_epu16(msum, _mm_set1_epi32(21846));
+                        mq = _mm_or_si128(mq, _mm_slli_epi32(mq, 8));
+                        mq = _mm_or_si128(mq, _mm_slli_epi32(mq, 8));
+
+                        return _mm_or_si128(mq, _mm_and_si128(mp, _mm_set1_epi32(0xFF000000)));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_invert {
+                    __m128i operator()(__m128i mp) {
+                        return _mm_xor_si128(mp, _mm_set1_epi32(0x00FFFFFF));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_invert_pm {
+                    __m128i operator()(__m128i mp) {
+                        __m128i malpha = _mm_set1_epi32(0xFF000000);
+
+                        // alpha in every channel
+                        __m128i ma = _mm_srli_epi32(mp, 24);
+                        ma = _mm_or_si128(ma, _mm_slli_epi32(ma, 8));
+                        ma = _mm_or_si128(ma, _mm_slli_epi32(ma, 16));
+
+                        return _mm_or_si128(_mm_andnot_si128(malpha, _mm_subs_epu8(ma, mp)), _mm_and_si128(mp, malpha));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_set_alpha {
+                    __m128i malpha;
+
+                    explicit sse2_set_alpha(int alpha)
+                        : malpha(_mm_set1_epi32((alpha & 0xFF) << 24))
+                    {
+                    }
+
+                    __m128i operator()(__m128i mp) {
+                        return _mm_or_si128(_mm_and_si128(mp, _mm_set1_epi32(0x00FFFFFF)), malpha);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                struct sse2_swizzle {
+                    __m128i mr;
+                    __m128i mg;
+                    __m128i mb;
+                    __m128i ma;
+
+                    // shift counts that move each source channel to the bottom
+                    explicit sse2_swizzle(int order)
+                        : mr(_mm_cvtsi32_si128(((order >> 0) & 3) * 8))
+                        , mg(_mm_cvtsi32_si128(((order >> 2) & 3) * 8))
+                        , mb(_mm_cvtsi32_si128(((order >> 4) & 3) * 8))
+                        , ma(_mm_cvtsi32_si128(((order >> 6) & 3) * 8))
+                    {
+                    }
+
+                    __m128i operator()(__m128i mp) {
+                        __m128i m255 = _mm_set1_epi32(0xFF);
+                        __m128i r = _mm_and_si128(_mm_srl_epi32(mp, mr), m255);
+                        __m128i g = _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(mp, mg), m255), 8);
+                        __m128i b = _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(mp, mb), m255), 16);
+                        __m128i a = _mm_slli_epi32(_mm_srl_epi32(mp, ma), 24);
+                        return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                template<bool premultiplied>
+                struct sse2_color_matrix {
+                    // coefficient pairs for the (red, blue) and (green, alpha) words
+                    __m128i mrb[4];
+                    __m128i mga[4];
+                    __m128i moffset[4];
+
+                    explicit sse2_color_matrix(const int* m)
+                    {
+                        for (int i = 0; i < 4; i++) {
+                            const int* row = m + i * 5;
+                            mrb[i]     = _mm_unpacklo_epi16(_mm_set1_epi16(row[0]), _mm_set1_epi16(row[2]));
+                            mga[i]     = _mm_unpacklo_epi16(_mm_set1_epi16(row[1]), _mm_set1_epi16(row[3]));
+                            moffset[i] = _mm_set1_epi32(row[4] + 128);
+                        }
+                    }
+
+                    __m128i channel(__m128i rb, __m128i ga, int i) {
+                        __m128i sum = _mm_add_epi32(_mm_madd_epi16(rb, mrb[i]), _mm_madd_epi16(ga, mga[i]));
+                        return _mm_srai_epi32(_mm_add_epi32(sum, moffset[i]), 8);
+                    }
+
+                    __m128i operator()(__m128i mp) {
+                        __m128i mmask = _mm_set1_epi32(0x00FF00FF);
+                        __m128i rb = _mm_and_si128(mp, mmask);
+                        __m128i ga = _mm_and_si128(_mm_srli_epi32(mp, 8), mmask);
+
+                        // (r0..r3, g0..g3) and (b0..b3, a0..a3), clamped to 0..255
+                        __m128i mnull = _mm_setzero_si128();
+                        __m128i m255  = _mm_set1_epi16(255);
+                        __m128i rg = _mm_packs_epi32(channel(rb, ga, 0), channel(rb, ga, 1));
+                        __m128i ba = _mm_packs_epi32(channel(rb, ga, 2), channel(rb, ga, 3));
+                        rg = _mm_min_epi16(_mm_max_epi16(rg, mnull), m255);
+                        ba = _mm_min_epi16(_mm_max_epi16(ba, mnull), m255);
+
+                        if (premultiplied) {
+                            __m128i aa = _mm_unpackhi_epi64(ba, ba);
+                            rg = _mm_min_epi16(rg, aa);
+                            ba = _mm_min_epi16(ba, aa);
+                        }
+
+                        __m128i lo = _mm_or_si128(rg, _mm_slli_epi16(_mm_srli_si128(rg, 8), 8));
+                        __m128i hi = _mm_or_si128(ba, _mm_slli_epi16(_mm_srli_si128(ba, 8), 8));
+                        return _mm_unpacklo_epi16(lo, hi);
+                    }
+                };
+
+                //-----------------------------------------------------------------
+                void clear_sse2(RGBA* dst, int dstPitch, int width, int height, RGBA color)
+                {
+                    if (dstPitch == width) {
+                        width *= height;
+                        height = 1;
+                    }
+
+                    __m128i mcolor = _mm_set1_epi32(*((int*)&color));
+
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* dp = dst + iy * dstPitch;
+                        int   n  = width;
+
+                        while (n > 0 && ((uintptr_t)dp & 15)) {
+                            *dp = color;
+                            dp++;
+                            n--;
+                        }
+
+                        while (n >= 4) {
+                            _mm_store_si128((__m128i*)dp, mcolor);
+                            dp += 4;
+                            n  -= 4;
+                        }
+
+                        while (n > 0) {
+                            *dp = color;
+                            dp++;
+                            n--;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void set_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_set(), rgba_set());
+                }
+
+                //-----------------------------------------------------------------
+                void mix_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_mix(), rgba_mix());
+                }
+
+                //-----------------------------------------------------------------
+                void add_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_add(), rgba_add());
+                }
+
+                //-----------------------------------------------------------------
+                void sub_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_sub(), rgba_sub());
+                }
+
+                //-----------------------------------------------------------------
+                void mul_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_mul(), rgba_mul());
+                }
+
+                //-----------------------------------------------------------------
+                void mix_pm_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_mix_pm(), rgba_mix_pm());
+                }
+
+                //-----------------------------------------------------------------
+                void set_rgb_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_set_rgb(), rgba_set_rgb());
+                }
+
+                //-----------------------------------------------------------------
+                void set_rgb_masked_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_set_rgb_masked(), rgba_set_rgb_masked());
+                }
+
+                //-----------------------------------------------------------------
+                void set_col_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_set_col(color), rgba_set_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void mix_col_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_mix_col(color), rgba_mix_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void add_col_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_add_col(color), rgba_add_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void sub_col_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_sub_col(color), rgba_sub_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void mul_col_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_mul_col(color), rgba_mul_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void mix_pm_col_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, RGBA color)
+                {
+                    blit(dst, dstPitch, src, srcPitch, width, height, sse2_mix_pm_col(color), rgba_mix_pm_col(color));
+                }
+
+                //-----------------------------------------------------------------
+                void sample_bilinear_sse2(RGBA* dst, const RGBA* src, int srcPitch, int width, int height, int u, int v, int du, int dv, int count)
+                {
+                    const int umax = (width  - 1) << 16;
+                    const int vmax = (height - 1) << 16;
+
+                    __m128i mnull = _mm_setzero_si128();
+
+                    while (count > 0) {
+                        int cu = std::min(std::max(u, 0), umax);
+                        int cv = std::min(std::max(v, 0), vmax);
+
+                        int x0 = cu >> 16;
+                        int y0 = cv >> 16;
+                        int x1 = std::min(x0 + 1, width  - 1);
+                        int y1 = std::min(y0 + 1, height - 1);
+                        int fx = (cu >> 8) & 0xFF;
+                        int fy = (cv >> 8) & 0xFF;
+
+                        const int* r0 = (const int*)(src + y0 * srcPitch);
+                        const int* r1 = (const int*)(src + y1 * srcPitch);
+
+                        // left and right texel of each row, widened to 16 bits
+                        __m128i t0 = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(r0[x0]), _mm_cvtsi32_si128(r0[x1])), mnull);
+                        __m128i t1 = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(r1[x0]), _mm_cvtsi32_si128(r1[x1])), mnull);
+
+                        // vertical, the sum fits into 16 unsigned bits
+                        t0 = _mm_mullo_epi16(t0, _mm_set1_epi16(256 - fy));
+                        t1 = _mm_mullo_epi16(t1, _mm_set1_epi16(fy));
+                        t0 = _mm_srli_epi16(_mm_add_epi16(t0, t1), 8);
+
+                        // horizontal, interleave left and right channels for madd
+                        t0 = _mm_unpacklo_epi16(t0, _mm_unpackhi_epi64(t0, t0));
+                        t0 = _mm_madd_epi16(t0, _mm_set1_epi32((fx << 16) | (256 - fx)));
+                        t0 = _mm_srli_epi32(t0, 8);
+                        t0 = _mm_packs_epi32(t0, t0);
+                        t0 = _mm_packus_epi16(t0, t0);
+
+                        *(int*)dst = _mm_cvtsi128_si32(t0);
+
+                        u += du;
+                        v += dv;
+                        dst++;
+                        count--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void sample_bilinear_straight_sse2(RGBA* dst, const RGBA* src, int srcPitch, int width, int height, int u, int v, int du, int dv, int count)
+                {
+                    const int umax = (width  - 1) << 16;
+                    const int vmax = (height - 1) << 16;
+
+                    __m128i mnull   = _mm_setzero_si128();
+                    __m128i mone    = _mm_set1_epi16(1);
+                    __m128i mcolors = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+                    __m128i malpha  = _mm_set_epi16(256, 0, 0, 0, 256, 0, 0, 0);
+
+                    while (count > 0) {
+                        int cu = std::min(std::max(u, 0), umax);
+                        int cv = std::min(std::max(v, 0), vmax);
+
+                        int x0 = cu >> 16;
+                        int y0 = cv >> 16;
+                        int x1 = std::min(x0 + 1, width  - 1);
+                        int y1 = std::min(y0 + 1, height - 1);
+                        int fx = (cu >> 8) & 0xFF;
+                        int fy = (cv >> 8) & 0xFF;
+
+                        const int* r0 = (const int*)(src + y0 * srcPitch);
+                        const int* r1 = (const int*)(src + y1 * srcPitch);
+
+                        __m128i t0 = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(r0[x0]), _mm_cvtsi32_si128(r0[x1])), mnull);
+                        __m128i t1 = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(r1[x0]), _mm_cvtsi32_si128(r1[x1])), mnull);
+
+                        // premultiply like PremultiplyRGBA, alpha is multiplied by 256
+                        __m128i a0 = _mm_add_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(t0, 0xFF), 0xFF), mone);
+                        __m128i a1 = _mm_add_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(t1, 0xFF), 0xFF), mone);
+                        a0 = _mm_or_si128(_mm_and_si128(a0, mcolors), malpha);
+                        a1 = _mm_or_si128(_mm_and_si128(a1, mcolors), malpha);
+                        t0 = _mm_srli_epi16(_mm_mullo_epi16(t0, a0), 8);
+                        t1 = _mm_srli_epi16(_mm_mullo_epi16(t1, a1), 8);
+
+                        t0 = _mm_mullo_epi16(t0, _mm_set1_epi16(256 - fy));
+                        t1 = _mm_mullo_epi16(t1, _mm_set1_epi16(fy));
+                        t0 = _mm_srli_epi16(_mm_add_epi16(t0, t1), 8);
+
+                        t0 = _mm_unpacklo_epi16(t0, _mm_unpackhi_epi64(t0, t0));
+                        t0 = _mm_madd_epi16(t0, _mm_set1_epi32((fx << 16) | (256 - fx)));
+                        t0 = _mm_srli_epi32(t0, 8);
+                        t0 = _mm_packs_epi32(t0, t0);
+                        t0 = _mm_packus_epi16(t0, t0);
+
+                        *(int*)dst = _mm_cvtsi128_si32(t0);
+
+                        if (dst->alpha != 255) {
+                            *dst = UnpremultiplyRGBA(*dst);
+                        }
+
+                        u += du;
+                        v += dv;
+                        dst++;
+                        count--;
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void grey_sse2(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    transform(dst, dstPitch, width, height, sse2_grey());
+                }
+
+                //-----------------------------------------------------------------
+                void invert_sse2(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    transform(dst, dstPitch, width, height, sse2_invert());
+                }
+
+                //-----------------------------------------------------------------
+                void invert_pm_sse2(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    transform(dst, dstPitch, width, height, sse2_invert_pm());
+                }
+
+                //-----------------------------------------------------------------
+                void set_alpha_sse2(RGBA* dst, int dstPitch, int width, int height, int alpha)
+                {
+                    transform(dst, dstPitch, width, height, sse2_set_alpha(alpha));
+                }
+
+                //-----------------------------------------------------------------
+                void swizzle_sse2(RGBA* dst, int dstPitch, int width, int height, int order)
+                {
+                    transform(dst, dstPitch, width, height, sse2_swizzle(order));
+                }
+
+                //-----------------------------------------------------------------
+                void mirror_sse2(RGBA* dst, int dstPitch, int width, int height)
+                {
+                    for (int iy = 0; iy < height; iy++) {
+                        RGBA* l = dst + iy * dstPitch;
+                        RGBA* r = l + width;
+
+                        // exchange reversed blocks from both ends
+                        while (r - l >= 8) {
+                            __m128i ml = _mm_loadu_si128((const __m128i*)l);
+                            __m128i mr = _mm_loadu_si128((const __m128i*)(r - 4));
+                            _mm_storeu_si128((__m128i*)l,       _mm_shuffle_epi32(mr, 0x1B));
+                            _mm_storeu_si128((__m128i*)(r - 4), _mm_shuffle_epi32(ml, 0x1B));
+                            l += 4;
+                            r -= 4;
+                        }
+
+                        r--;
+                        while (l < r) {
+                            std::swap(*l, *r);
+                            l++;
+                            r--;
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void swap_sse2(RGBA* a, RGBA* b, int count)
+                {
+                    while (count >= 4) {
+                        __m128i ma = _mm_loadu_si128((const __m128i*)a);
+                        __m128i mb = _mm_loadu_si128((const __m128i*)b);
+                        _mm_storeu_si128((__m128i*)a, mb);
+                        _mm_storeu_si128((__m128i*)b, ma);
+                        a += 4;
+                        b += 4;
+                        count -= 4;
+                    }
+                    std::swap_ranges(a, a + count, b);
+                }
+
+                //-----------------------------------------------------------------
+                void swap_mirrored_sse2(RGBA* a, RGBA* b, int count)
+                {
+                    // a moves forward, the end of b moves back
+                    while (count >= 4) {
+                        __m128i ma = _mm_loadu_si128((const __m128i*)a);
+                        __m128i mb = _mm_loadu_si128((const __m128i*)(b + count - 4));
+                        _mm_storeu_si128((__m128i*)a,               _mm_shuffle_epi32(mb, 0x1B));
+                        _mm_storeu_si128((__m128i*)(b + count - 4), _mm_shuffle_epi32(ma, 0x1B));
+                        a += 4;
+                        count -= 4;
+                    }
+                    std::swap_ranges(a, a + count, std::reverse_iterator<RGBA*>(b + count));
+                }
+
+                //-----------------------------------------------------------------
+                inline void transpose4x4(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch)
+                {
+                    __m128i r0 = _mm_loadu_si128((const __m128i*)(src + 0 * srcPitch));
+                    __m128i r1 = _mm_loadu_si128((const __m128i*)(src + 1 * srcPitch));
+                    __m128i r2 = _mm_loadu_si128((const __m128i*)(src + 2 * srcPitch));
+                    __m128i r3 = _mm_loadu_si128((const __m128i*)(src + 3 * srcPitch));
+
+                    __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+                    __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+                    __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+                    __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+                    _mm_storeu_si128((__m128i*)(dst + 0 * dstPitch), _mm_unpacklo_epi64(t0, t1));
+                    _mm_storeu_si128((__m128i*)(dst + 1 * dstPitch), _mm_unpackhi_epi64(t0, t1));
+                    _mm_storeu_si128((__m128i*)(dst + 2 * dstPitch), _mm_unpacklo_epi64(t2, t3));
+                    _mm_storeu_si128((__m128i*)(dst + 3 * dstPitch), _mm_unpackhi_epi64(t2, t3));
+                }
+
+                //-----------------------------------------------------------------
+                void transpose_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height)
+                {
+                    // tile by tile, so both sides stay in the cache
+                    for (int ty = 0; ty < height; ty += TransposeTileSize) {
+                        for (int tx = 0; tx < width; tx += TransposeTileSize) {
+                            int th = std::min(TransposeTileSize, height - ty);
+                            int tw = std::min(TransposeTileSize, width  - tx);
+                            int bh = th & ~3;
+                            int bw = tw & ~3;
+
+                            for (int y = ty; y < ty + bh; y += 4) {
+                                for (int x = tx; x < tx + bw; x += 4) {
+                                    transpose4x4(dst + x * dstPitch + y, dstPitch, src + y * srcPitch + x, srcPitch);
+                                }
+                            }
+
+                            // pixels outside the 4x4 blocks at the image edges
+                            if (bh < th || bw < tw) {
+                                for (int y = ty; y < ty + th; y++) {
+                                    for (int x = (y < ty + bh ? tx + bw : tx); x < tx + tw; x++) {
+                                        dst[x * dstPitch + y] = src[y * srcPitch + x];
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                inline __m128i load_pixel_pair(const RGBA* a, const RGBA* b)
+                {
+                    __m128i mp = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*(const int*)a), _mm_cvtsi32_si128(*(const int*)b));
+                    return _mm_unpacklo_epi8(mp, _mm_setzero_si128());
+                }
+
+                //-----------------------------------------------------------------
+                void blur_rows_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, int radius)
+                {
+                    __m128i mfactor = _mm_set1_epi16((short)BoxBlurFactor(radius));
+
+                    // two rows at a time, the sums of a pixel of each row share a register
+                    for (int iy = 0; iy < height; iy += 2) {
+                        int next = std::min(iy + 1, height - 1);
+
+                        const RGBA* sa = src + iy   * srcPitch;
+                        const RGBA* sb = src + next * srcPitch;
+                        RGBA*       da = dst + iy   * dstPitch;
+                        RGBA*       db = dst + next * dstPitch;
+
+                        __m128i msum = _mm_mullo_epi16(load_pixel_pair(sa, sb), _mm_set1_epi16(radius + 1));
+                        for (int k = 1; k <= radius; k++) {
+                            int i = std::min(k, width - 1);
+                            msum = _mm_add_epi16(msum, load_pixel_pair(sa + i, sb + i));
+                        }
+
+                        for (int ix = 0; ix < width; ix++) {
+                            __m128i mp = _mm_mulhi_epu16(msum, mfactor);
+                            mp = _mm_packus_epi16(mp, mp);
+                            *(int*)(db + ix) = _mm_cvtsi128_si32(_mm_srli_si128(mp, 4));
+                            *(int*)(da + ix) = _mm_cvtsi128_si32(mp);
+
+                            int in  = std::min(ix + radius + 1, width - 1);
+                            int out = std::max(ix - radius, 0);
+                            msum = _mm_add_epi16(msum, load_pixel_pair(sa + in,  sb + in));
+                            msum = _mm_sub_epi16(msum, load_pixel_pair(sa + out, sb + out));
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                inline __m128i load_block(const RGBA* p, int count)
+                {
+                    if (count == 4) {
+                        return _mm_loadu_si128((const __m128i*)p);
+                    }
+                    RGBA block[4];
+                    std::copy(p, p + count, block);
+                    return _mm_loadu_si128((const __m128i*)block);
+                }
+
+                //-----------------------------------------------------------------
+                inline void store_block(RGBA* p, int count, __m128i mp)
+                {
+                    if (count == 4) {
+                        _mm_storeu_si128((__m128i*)p, mp);
+                        return;
+                    }
+                    RGBA block[4];
+                    _mm_storeu_si128((__m128i*)block, mp);
+                    std::copy(block, block + count, p);
+                }
+
+                //-----------------------------------------------------------------
+                void blur_columns_sse2(RGBA* dst, int dstPitch, const RGBA* src, int srcPitch, int width, int height, int radius)
+                {
+                    __m128i mnull   = _mm_setzero_si128();
+                    __m128i mfactor = _mm_set1_epi16((short)BoxBlurFactor(radius));
+
+                    // the windows of all columns move down together,
+                    // sixteen sums for every block of four pixels
+                    std::vector<u16> sums((width + 3) / 4 * 16);
+
+                    for (int ix = 0; ix < width; ix += 4) {
+                        int     count = std::min(4, width - ix);
+                        __m128i mp    = load_block(src + ix, count);
+                        __m128i lo    = _mm_mullo_epi16(_mm_unpacklo_epi8(mp, mnull), _mm_set1_epi16(radius + 1));
+                        __m128i hi    = _mm_mullo_epi16(_mm_unpackhi_epi8(mp, mnull), _mm_set1_epi16(radius + 1));
+                        for (int k = 1; k <= radius; k++) {
+                            mp = load_block(src + std::min(k, height - 1) * srcPitch + ix, count);
+                            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(mp, mnull));
+                            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(mp, mnull));
+                        }
+                        _mm_storeu_si128((__m128i*)&sums[ix * 4],     lo);
+                        _mm_storeu_si128((__m128i*)&sums[ix * 4 + 8], hi);
+                    }
+
+                    for (int iy = 0; iy < height; iy++) {
+                        const RGBA* in  = src + std::min(iy + radius + 1, height - 1) * srcPitch;
+                        const RGBA* out = src + std::max(iy - radius, 0) * srcPitch;
+                        RGBA*       dp  = dst + iy * dstPitch;
+
+                        for (int ix = 0; ix < width; ix += 4) {
+                            int     count = std::min(4, width - ix);
+                            __m128i lo    = _mm_loadu_si128((const __m128i*)&sums[ix * 4]);
+                            __m128i hi    = _mm_loadu_si128((const __m128i*)&sums[ix * 4 + 8]);
+
+                            store_block(dp + ix, count, _mm_packus_epi16(_mm_mulhi_epu16(lo, mfactor), _mm_mulhi_epu16(hi, mfactor)));
+
+                            __m128i mi = load_block(in  + ix, count);
+                            __m128i mo = load_block(out + ix, count);
+                            lo = _mm_sub_epi16(_mm_add_epi16(lo, _mm_unpacklo_epi8(mi, mnull)), _mm_unpacklo_epi8(mo, mnull));
+                            hi = _mm_sub_epi16(_mm_add_epi16(hi, _mm_unpackhi_epi8(mi, mnull)), _mm_unpackhi_epi8(mo, mnull));
+                            _mm_storeu_si128((__m128i*)&sums[ix * 4],     lo);
+                            _mm_storeu_si128((__m128i*)&sums[ix * 4 + 8], hi);
+                        }
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                void color_matrix_sse2(RGBA* dst, int dstPitch, int width, int height, const int* matrix)
+                {
+                    transform(dst, dstPitch, width, height, sse2_color_matrix<false>(matrix));
+                }
+
+                //-----------------------------------------------------------------
+                void color_matrix_pm_sse2(RGBA* dst, int dstPitch, int width, int height, const int* matrix)
+                {
+                    transform(dst, dstPitch, width, height, sse2_color_matrix<true>(matrix));
+                }
+
+            } // anonymous namespace
+
+            //-----------------------------------------------------------------
+            void InitSse2Kernels(KernelTable& table)
+            {
+                table.name   = "SSE2";
+                table.clear  = clear_sse2;
+                table.set    = set_sse2;
+                table.mix    = mix_sse2;
+                table.add    = add_sse2;
+                table.sub    = sub_sse2;
+                table.mul    = mul_sse2;
+                table.setCol = set_col_sse2;
+                table.mixCol = mix_col_sse2;
+                table.addCol = add_col_sse2;
+                table.subCol = sub_col_sse2;
+                table.mulCol = mul_col_sse2;
+
+                table.mixPremul    = mix_pm_sse2;
+                table.setRgb       = set_rgb_sse2;
+                table.setRgbMasked = set_rgb_masked_sse2;
+                table.mixPremulCol = mix_pm_col_sse2;
+
+                table.sampleBilinear         = sample_bilinear_sse2;
+                table.sampleBilinearStraight = sample_bilinear_straight_sse2;
+
+                table.grey         = grey_sse2;
+                table.invert       = invert_sse2;
+                table.invertPremul = invert_pm_sse2;
+                table.mirror       = mirror_sse2;
+                table.setAlpha     = set_alpha_sse2;
+                table.swizzle      = swizzle_sse2;
+                table.swap         = swap_sse2;
+                table.swapMirrored = swap_mirrored_sse2;
+                table.transpose    = transpose_sse2;
+                table.blurRows     = blur_rows_sse2;
+                table.blurColumns  = blur_columns_sse2;
+
+                table.colorMatrix       = color_matrix_sse2;
+                table.colorMatrixPremul = color_matrix_pm_sse2;
+            }
+
+        } // namespace kernels
+    } // namespace graphics
+} // namespace rpgss
@@ -0,0 +1,321 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include <windows.h>
+
+#include "../common/SpinLock.hpp"
+#include "graphics.hpp"
+#include "loader.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace loader {
+
+            namespace {
+
+                HANDLE        Thread    = 0;
+                HANDLE        WakeEvent = 0;
+                bool          Quit      = false;
+                int           Pending   = 0;
+                SpinLock      Lock;
+
+                // the worker only sees raw pointers, references are
+                // taken and dropped on the game thread through InFlight
+                std::deque<Request*>      Queue;
+                std::vector<Request::Ptr> InFlight;
+
+            } // anonymous namespace
+
+            //-----------------------------------------------------------------
+            class Loader {
+            public:
+                //-----------------------------------------------------------------
+                static DWORD WINAPI WorkerMain(LPVOID)
+                {
+                    for (;;) {
+                        Request* request = 0;
+
+                        {
+                            ScopedLock lock(Lock);
+
+                            if (Quit) {
+                                break;
+                            }
+
+                            if (!Queue.empty()) {
+                                request = Queue.front();
+                                request->_state = Request::State::Loading;
+                                request->_busy  = true;
+                                Queue.pop_front();
+                            }
+                        }
+
+                        if (!request) {
+                            WaitForSingleObject(WakeEvent, INFINITE);
+                            continue;
+                        }
+
+                        Image::Ptr image = ReadImage(request->_filename, request->_premultiply);
+
+                        ScopedLock lock(Lock);
+
+                        if (request->_state != Request::State::Cancelled) {
+                            request->_state = (image ? Request::State::Done : Request::State::Failed);
+                            request->_image = image;
+                        }
+
+                        // the game thread may take the image or drop the request
+                        // as soon as the lock is released, so let go of both here
+                        image = 0;
+                        request->_busy = false;
+                        Pending--;
+                    }
+
+                    return 0;
+                }
+
+                //-----------------------------------------------------------------
+                static bool StartWorker()
+                {
+                    WakeEvent = CreateEvent(0, FALSE, FALSE, 0);
+                    if (!WakeEvent) {
+                        return false;
+                    }
+
+                    Thread = CreateThread(0, 0, WorkerMain, 0, 0, 0);
+                    if (!Thread) {
+                        CloseHandle(WakeEvent);
+                        WakeEvent = 0;
+                        return false;
+                    }
+
+                    return true;
+                }
+
+                //-----------------------------------------------------------------
+                // a request cancelled while loading is still used by the worker
+                static bool IsFinished(const Request::Ptr& request)
+                {
+                    return request->_state >= Request::State::Done && !request->_busy;
+                }
+
+                //-----------------------------------------------------------------
+                static void DropFinished()
+                {
+                    ScopedLock lock(Lock);
+                    InFlight.erase(std::remove_if(InFlight.begin(), InFlight.end(), IsFinished), InFlight.end());
+                }
+
+                //-----------------------------------------------------------------
+                static Request::Ptr Enqueue(const std::string& filename, bool premultiply)
+                {
+                    DropFinished();
+
+                    if (!Thread && !StartWorker()) {
+                        // decode right away rather than not at all
+                        Request::Ptr request = new Request(filename, premultiply);
+                        request->_image = ReadImage(filename, premultiply);
+                        request->_state = (request->_image ? Request::State::Done : Request::State::Failed);
+                        return request;
+                    }
+
+                    Request::Ptr request = new Request(filename, premultiply);
+
+                    {
+                        ScopedLock lock(Lock);
+
+                        if (Pending >= MaxPending) {
+                            return 0;
+                        }
+
+                        Queue.push_back(request);
+                        Pending++;
+                    }
+
+                    InFlight.push_back(request);
+                    SetEvent(WakeEvent);
+
+                    return request;
+                }
+
+                //-----------------------------------------------------------------
+                static void StopWorker()
+                {
+                    if (!Thread) {
+                        return;
+                    }
+
+                    {
+                        ScopedLock lock(Lock);
+
+                        for (size_t i = 0; i < Queue.size(); i++) {
+                            Queue[i]->_state = Request::State::Cancelled;
+                        }
+
+                        Pending -= (int)Queue.size();
+                        Queue.clear();
+                        Quit = true;
+                    }
+
+                    // a file being decoded is finished first
+                    SetEvent(WakeEvent);
+                    WaitForSingleObject(Thread, INFINITE);
+                    CloseHandle(Thread);
+                    CloseHandle(WakeEvent);
+
+                    Thread    = 0;
+                    WakeEvent = 0;
+                    Quit      = false;
+                    Pending   = 0;
+
+                    InFlight.clear();
+                }
+            };
+
+            //-----------------------------------------------------------------
+            Request::Request(const std::string& filename, bool premultiply)
+                : _filename(filename)
+                , _premultiply(premultiply)
+                , _state(State::Queued)
+                , _busy(false)
+            {
+            }
+
+            //-----------------------------------------------------------------
+            Request::~Request()
+            {
+            }
+
+            //-----------------------------------------------------------------
+            int
+            Request::getState() const
+            {
+                ScopedLock lock(Lock);
+                return _state;
+            }
+
+            //-----------------------------------------------------------------
+            bool
+            Request::isReady() const
+            {
+                return getState() >= State::Done;
+            }
+
+            //-----------------------------------------------------------------
+            Image*
+            Request::getImage()
+            {
+                if (getState() != State::Done) {
+                    return 0;
+                }
+                return _image;
+            }
+
+            //-----------------------------------------------------------------
+            Image*
+            Request::wait()
+            {
+                bool decode = false;
+
+                {
+                    ScopedLock lock(Lock);
+
+                    if (_state == State::Queued) {
+                        std::deque<Request*>::iterator it = std::find(Queue.begin(), Queue.end(), this);
+                        if (it != Queue.end()) {
+                            Queue.erase(it);
+                            Pending--;
+                        }
+                        _state = State::Loading;
+                        decode = true;
+                    }
+                }
+
+                if (decode) {
+                    Image::Ptr image = ReadImage(_filename, _premultiply);
+
+                    ScopedLock lock(Lock);
+                    _image = image;
+                    _state = (image ? State::Done : State::Failed);
+                } else {
+                    while (!isReady()) {
+                        Sleep(1);
+                    }
+                }
+
+                return getImage();
+            }
+
+            //-----------------------------------------------------------------
+            bool
+            Request::cancel()
+            {
+                ScopedLock lock(Lock);
+
+                switch (_state) {
+                    case State::Queued: {
+                        std::deque<Request*>::iterator it = std::find(Queue.begin(), Queue.end(), this);
+                        if (it != Queue.end()) {
+                            Queue.erase(it);
+                            Pending--;
+                        }
+                        _state = State::Cancelled;
+                        return true;
+                    }
+                    case State::Loading:
+                        // the worker drops the image once it is decoded
+                        _state = State::Cancelled;
+                        return true;
+                    default:
+                        return false;
+                }
+            }
+
+            //-----------------------------------------------------------------
+            Request::Ptr ReadImageAsync(const std::string& filename, bool premultiply)
+            {
+                return Loader::Enqueue(filename, premultiply);
+            }
+
+            //-----------------------------------------------------------------
+            int GetPendingCount()
+            {
+                ScopedLock lock(Lock);
+                return Pending;
+            }
+
+            //-----------------------------------------------------------------
+            void Shutdown()
+            {
+                Loader::StopWorker();
+            }
+
+        } // namespace loader
+    } // namespace graphics
+} // namespace rpgss
@@ -0,0 +1,123 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_GRAPHICS_LOADER_HPP_INCLUDED
+#define RPGSS_GRAPHICS_LOADER_HPP_INCLUDED
+
+#include <string>
+
+#include "../common/RefCountedObject.hpp"
+#include "../common/RefCountedObjectPtr.hpp"
+#include "Image.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace loader {
+
+            class Loader;
+
+            // requests waiting for or being decoded by the worker
+            const int MaxPending = 32;
+
+            // an image being decoded on the loader thread, polled by
+            // the game thread until it is ready
+            class Request : public RefCountedObject {
+            public:
+                typedef RefCountedObjectPtr<Request> Ptr;
+
+                struct State {
+                    enum {
+                        Queued,
+                        Loading,
+                        Done,
+                        Failed,
+                        Cancelled,
+                    };
+                };
+
+            public:
+                const std::string& getFilename() const;
+                bool getPremultiply() const;
+                int  getState() const;
+
+                // true once the request will not change anymore
+                bool isReady() const;
+
+                // the decoded image, 0 unless the state is Done
+                Image* getImage();
+
+                // blocks until the request is ready and returns getImage(),
+                // a request the worker has not started is decoded right here
+                Image* wait();
+
+                // returns false if the request is already finished
+                bool cancel();
+
+            private:
+                friend class Loader;
+
+                // use ReadImageAsync()
+                Request(const std::string& filename, bool premultiply);
+                ~Request();
+
+            private:
+                std::string _filename;
+                bool        _premultiply;
+                int         _state; // guarded by the loader lock
+                bool        _busy;  // set while the worker uses the request, guarded by the loader lock
+                Image::Ptr  _image; // set by the worker before the state becomes Done
+            };
+
+            //-----------------------------------------------------------------
+            inline const std::string&
+            Request::getFilename() const
+            {
+                return _filename;
+            }
+
+            //-----------------------------------------------------------------
+            inline bool
+            Request::getPremultiply() const
+            {
+                return _premultiply;
+            }
+
+            // queues the file for decoding on the loader thread, which is
+            // started on the first call, returns 0 if MaxPending requests
+            // are already waiting
+            Request::Ptr ReadImageAsync(const std::string& filename, bool premultiply = false);
+
+            // requests waiting for or being decoded by the worker
+            int GetPendingCount();
+
+            // cancels all requests and stops the loader thread
+            void Shutdown();
+
+        } // namespace loader
+    } // namespace graphics
+} // namespace rpgss
+
+
+#endif // RPGSS_GRAPHICS_LOADER_HPP_INCLUDED
@@ -0,0 +1,293 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "../common/byteorder.hpp"
+#include "../common/lz.hpp"
+#include "../io/io.hpp"
+#include "graphics.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+
+        namespace {
+
+            // all fields are little endian
+            //
+            //  0  8  magic
+            //  8  2  version
+            // 10  2  flags
+            // 12  4  width
+            // 16  4  height
+            // 20  4  rows per chunk, 0 if the pixels are stored raw
+            //
+            // followed by the rgba rows, either raw or in chunks of a 32-bit
+            // size and the lz compressed rows, chunks that would not shrink
+            // are stored raw with the size of the raw rows
+            const char NativeMagic[8] = { 'R', 'P', 'G', 'S', 'S', 'I', 'M', 'G' };
+            const int  NativeVersion  = 1;
+            const int  HeaderSize     = 24;
+
+            // about 64 KB of rows per chunk
+            const int ChunkBytes = 64 * 1024;
+
+            struct NativeFlags {
+                enum {
+                    Premultiplied = 1 << 0,
+                };
+            };
+
+            //-----------------------------------------------------------------
+            bool ReadChunks(io::File* file, Image* image, int chunkRows)
+            {
+                int row_bytes = image->getWidth() * sizeof(RGBA);
+                u8* pixels    = (u8*)image->getPixels();
+
+                std::vector<u8> buffer;
+
+                for (int y = 0; y < image->getHeight(); y += chunkRows) {
+                    int raw_size = std::min(chunkRows, image->getHeight() - y) * row_bytes;
+                    u8* rows     = pixels + y * row_bytes;
+
+                    u8 size_bytes[4];
+                    if (file->read(size_bytes, 4) != 4) {
+                        return false;
+                    }
+
+                    u32 size = Get32(size_bytes);
+
+                    if (size == (u32)raw_size) {
+                        if (file->read(rows, raw_size) != raw_size) {
+                            return false;
+                        }
+                        continue;
+                    }
+
+                    if (size == 0 || size > (u32)LzCompressBound(raw_size)) {
+                        return false;
+                    }
+
+                    buffer.resize(size);
+                    if (file->read(&buffer[0], size) != (int)size) {
+                        return false;
+                    }
+
+                    if (!LzDecompress(&buffer[0], size, rows, raw_size)) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            //-----------------------------------------------------------------
+            bool WriteChunks(const Image* image, io::File* file)
+            {
+                int width     = image->getWidth();
+                int height    = image->getHeight();
+                int row_bytes = width * sizeof(RGBA);
+                int rows      = std::max(1, ChunkBytes / row_bytes);
+
+                std::vector<u8> gathered;
+                std::vector<u8> compressed(4 + LzCompressBound(std::min(rows, height) * row_bytes));
+
+                for (int y = 0; y < height; y += rows) {
+                    int chunk_rows = std::min(rows, height - y);
+                    int raw_size   = chunk_rows * row_bytes;
+
+                    // views are not stored contiguously
+                    const u8* raw = (const u8*)(image->getPixels() + y * image->getPitch());
+                    if (image->getPitch() != width) {
+                        gathered.resize(raw_size);
+                        for (int i = 0; i < chunk_rows; i++) {
+                            std::memcpy(&gathered[i * row_bytes], image->getPixels() + (y + i) * image->getPitch(), row_bytes);
+                        }
+                        raw = &gathered[0];
+                    }
+
+                    int size = LzCompress(raw, raw_size, &compressed[4], compressed.size() - 4);
+
+                    if (size <= 0 || size >= raw_size) {
+                        Put32(&compressed[0], raw_size);
+                        if (file->write(&compressed[0], 4) != 4 || file->write(raw, raw_size) != raw_size) {
+                            return false;
+                        }
+                    } else {
+                        Put32(&compressed[0], size);
+                        if (file->write(&compressed[0], 4 + size) != 4 + size) {
+                            return false;
+                        }
+                    }
+                }
+
+                return true;
+            }
+
+        } // anonymous namespace
+
+        //-----------------------------------------------------------------
+        bool IsNativeImage(io::File* file)
+        {
+            int pos = file->tell();
+            if (pos < 0) {
+                return false;
+            }
+
+            u8 magic[sizeof(NativeMagic)];
+            bool result = (file->read(magic, sizeof(magic)) == sizeof(magic) &&
+                           std::memcmp(magic, NativeMagic, sizeof(magic)) == 0);
+
+            file->seek(pos, io::File::Begin);
+            return result;
+        }
+
+        //-----------------------------------------------------------------
+        Image::Ptr ReadNativeImage(io::File* file, bool premultiply)
+        {
+            u8 header[HeaderSize];
+            if (file->read(header, HeaderSize) != HeaderSize ||
+                std::memcmp(header, NativeMagic, sizeof(NativeMagic)) != 0 ||
+                Get16(header + 8) != NativeVersion)
+            {
+                return 0;
+            }
+
+            u32 flags      = Get16(header + 10);
+            u32 width      = Get32(header + 12);
+            u32 height     = Get32(header + 16);
+            u32 chunk_rows = Get32(header + 20);
+
+            // the size in bytes has to fit into an int
+            if (width == 0 || height == 0 || width > 0x7FFFFFFF / sizeof(RGBA) / height) {
+                return 0;
+            }
+
+            // reject sizes the rest of the file cannot hold before allocating them
+            int remaining = file->getSize() - file->tell();
+            if (remaining <= 0) {
+                return 0;
+            }
+            u32 size = width * height * sizeof(RGBA);
+            if (chunk_rows == 0) {
+                if (size > (u32)remaining) {
+                    return 0;
+                }
+            } else {
+                // each chunk takes its size and at least one byte, and no
+                // byte of compressed data decompresses to more than LzMaxRatio
+                if (chunk_rows > height) {
+                    chunk_rows = height;
+                }
+                u32 chunks = (height + chunk_rows - 1) / chunk_rows;
+                if (chunks > (u32)remaining / 5 || size / LzMaxRatio > (u32)remaining) {
+                    return 0;
+                }
+            }
+
+            // pixels are read straight into the image
+            Image::Ptr image = Image::New(width, height);
+            if (!image) {
+                return 0;
+            }
+
+            if (chunk_rows == 0) {
+                if (file->read((u8*)image->getPixels(), size) != (int)size) {
+                    return 0;
+                }
+            } else {
+                if (!ReadChunks(file, image, chunk_rows)) {
+                    return 0;
+                }
+            }
+
+            image->setPremultiplied((flags & NativeFlags::Premultiplied) != 0);
+
+            if (premultiply) {
+                image->premultiply();
+            } else {
+                image->unpremultiply();
+            }
+
+            // classify once at load time rather than on the first draw
+            image->getAlphaClass();
+
+            return image;
+        }
+
+        //-----------------------------------------------------------------
+        bool WriteNativeImage(const Image* image, const std::string& filename, bool compress)
+        {
+            io::File::Ptr file = io::OpenFile(filename, io::File::Out);
+
+            if (!file) {
+                return false;
+            }
+
+            return WriteNativeImage(image, file, compress);
+        }
+
+        //-----------------------------------------------------------------
+        bool WriteNativeImage(const Image* image, io::File* file, bool compress)
+        {
+            int width     = image->getWidth();
+            int height    = image->getHeight();
+            int row_bytes = width * sizeof(RGBA);
+
+            u8 header[HeaderSize];
+            std::memcpy(header, NativeMagic, sizeof(NativeMagic));
+            Put16(header + 8,  NativeVersion);
+            Put16(header + 10, image->isPremultiplied() ? NativeFlags::Premultiplied : 0);
+            Put32(header + 12, width);
+            Put32(header + 16, height);
+            Put32(header + 20, compress ? std::max(1, ChunkBytes / row_bytes) : 0);
+
+            if (file->write(header, HeaderSize) != HeaderSize) {
+                return false;
+            }
+
+            if (compress) {
+                return WriteChunks(image, file);
+            }
+
+            if (image->getPitch() == width) {
+                int size = image->getSizeInBytes();
+                return file->write((const u8*)image->getPixels(), size) == size;
+            }
+
+            // views are not stored contiguously
+            for (int y = 0; y < height; y++) {
+                if (file->write((const u8*)(image->getPixels() + y * image->getPitch()), row_bytes) != row_bytes) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+    } // namespace graphics
+} // namespace rpgss
@@ -0,0 +1,187 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+
+#include <windows.h>
+
+#include "../common/types.hpp"
+#include "parallel.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace parallel {
+
+            namespace {
+
+                struct Worker {
+                    HANDLE thread;
+                    HANDLE wakeEvent;
+                    Task*  task; // 0 tells the worker to quit
+                    int    y1;
+                    int    y2;
+                };
+
+                Worker        Workers[MaxWorkers];
+                int           WorkerCount  = 0;
+                HANDLE        DoneEvent    = 0;
+                volatile LONG PendingBands = 0;
+                bool          Running      = false;
+                DWORD         OwnerThread  = 0;
+
+                //-----------------------------------------------------------------
+                DWORD WINAPI WorkerMain(LPVOID param)
+                {
+                    Worker* worker = (Worker*)param;
+
+                    for (;;) {
+                        WaitForSingleObject(worker->wakeEvent, INFINITE);
+
+                        if (!worker->task) {
+                            break;
+                        }
+
+                        worker->task->run(worker->y1, worker->y2);
+
+                        if (InterlockedDecrement(&PendingBands) == 0) {
+                            SetEvent(DoneEvent);
+                        }
+                    }
+
+                    return 0;
+                }
+
+                //-----------------------------------------------------------------
+                void StopWorkers()
+                {
+                    for (int i = 0; i < WorkerCount; i++) {
+                        Workers[i].task = 0;
+                        SetEvent(Workers[i].wakeEvent);
+                    }
+
+                    for (int i = 0; i < WorkerCount; i++) {
+                        WaitForSingleObject(Workers[i].thread, INFINITE);
+                        CloseHandle(Workers[i].thread);
+                        CloseHandle(Workers[i].wakeEvent);
+                    }
+
+                    if (DoneEvent) {
+                        CloseHandle(DoneEvent);
+                        DoneEvent = 0;
+                    }
+
+                    WorkerCount = 0;
+                }
+
+                //-----------------------------------------------------------------
+                void StartWorkers(int count)
+                {
+                    DoneEvent = CreateEvent(0, FALSE, FALSE, 0);
+                    if (!DoneEvent) {
+                        return;
+                    }
+
+                    // keep however many workers could be started
+                    for (int i = 0; i < count; i++) {
+                        Worker& worker = Workers[i];
+
+                        worker.task      = 0;
+                        worker.wakeEvent = CreateEvent(0, FALSE, FALSE, 0);
+                        if (!worker.wakeEvent) {
+                            break;
+                        }
+
+                        worker.thread = CreateThread(0, 0, WorkerMain, &worker, 0, 0);
+                        if (!worker.thread) {
+                            CloseHandle(worker.wakeEvent);
+                            break;
+                        }
+
+                        WorkerCount++;
+                    }
+                }
+
+            } // anonymous namespace
+
+            //-----------------------------------------------------------------
+            void SetWorkerCount(int count)
+            {
+                count = std::max(0, std::min(count, MaxWorkers));
+
+                if (count == WorkerCount) {
+                    return;
+                }
+
+                StopWorkers();
+
+                OwnerThread = GetCurrentThreadId();
+
+                if (count > 0) {
+                    StartWorkers(count);
+                }
+            }
+
+            //-----------------------------------------------------------------
+            int GetWorkerCount()
+            {
+                return WorkerCount;
+            }
+
+            //-----------------------------------------------------------------
+            void Run(Task& task, int width, int height)
+            {
+                int bands = std::min(WorkerCount + 1, height / MinBandHeight);
+
+                // nested calls and calls from other threads (the image
+                // loader) run on the calling thread
+                if (bands < 2 || GetCurrentThreadId() != OwnerThread || Running || (i64)width * height < MinPixels) {
+                    if (height > 0) {
+                        task.run(0, height);
+                    }
+                    return;
+                }
+
+                Running = true;
+
+                PendingBands = bands - 1;
+
+                for (int i = 1; i < bands; i++) {
+                    Worker& worker = Workers[i - 1];
+                    worker.task = &task;
+                    worker.y1   = height * i / bands;
+                    worker.y2   = height * (i + 1) / bands;
+                    SetEvent(worker.wakeEvent);
+                }
+
+                task.run(0, height / bands);
+
+                WaitForSingleObject(DoneEvent, INFINITE);
+
+                Running = false;
+            }
+
+        } // namespace parallel
+    } // namespace graphics
+} // namespace rpgss
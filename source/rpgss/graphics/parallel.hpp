@@ -0,0 +1,86 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_GRAPHICS_PARALLEL_HPP_INCLUDED
+#define RPGSS_GRAPHICS_PARALLEL_HPP_INCLUDED
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace parallel {
+
+            // operations on fewer pixels are not worth waking the workers
+            const int MinPixels = 256 * 256;
+
+            // bands are never split thinner than this
+            const int MinBandHeight = 16;
+
+            const int MaxWorkers = 16;
+
+            // an operation that can be split into horizontal bands,
+            // bands never overlap and may run concurrently
+            class Task {
+            public:
+                virtual ~Task() { }
+                virtual void run(int y1, int y2) = 0;
+            };
+
+            //-----------------------------------------------------------------
+            template<typename funcT>
+            class FuncTask : public Task {
+            public:
+                explicit FuncTask(funcT func) : _func(func) {
+                }
+
+                void run(int y1, int y2) {
+                    _func(y1, y2);
+                }
+
+            private:
+                funcT _func;
+            };
+
+            // 0 workers runs everything on the calling thread
+            void SetWorkerCount(int count);
+            int  GetWorkerCount();
+
+            // splits rows [0, height) into bands, one runs on the calling
+            // thread and the others on the workers, returns when all are done,
+            // only the thread that last called SetWorkerCount() uses the workers
+            void Run(Task& task, int width, int height);
+
+            //-----------------------------------------------------------------
+            template<typename funcT>
+            void ForEachBand(int width, int height, funcT func)
+            {
+                FuncTask<funcT> task(func);
+                Run(task, width, height);
+            }
+
+        } // namespace parallel
+    } // namespace graphics
+} // namespace rpgss
+
+
+#endif // RPGSS_GRAPHICS_PARALLEL_HPP_INCLUDED
@@ -0,0 +1,208 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <cstdlib>
+#include <algorithm>
+
+#include "../common/SpinLock.hpp"
+#include "pixelpool.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace pixelpool {
+
+            namespace {
+
+                // size classes go 1 KB, 1.5 KB, 2 KB, 3 KB, 4 KB ... 32 MB, 48 MB,
+                // so at most a third of a buffer is wasted
+                const int MinClassShift = 10;
+                const int MaxClassShift = 25;
+                const int ClassCount    = (MaxClassShift - MinClassShift + 1) * 2;
+
+                // stored right before each buffer
+                struct Header {
+                    void*   raw;
+                    Header* next;
+                    int     size;
+                    int     sizeClass; // -1 if larger than the largest class
+                };
+
+                Header*       FreeLists[ClassCount];
+                int           Limit       = 16 * 1024 * 1024;
+                int           LiveBytes   = 0;
+                int           PooledBytes = 0;
+                SpinLock      Lock;
+
+                //-----------------------------------------------------------------
+                int GetSizeClass(int size, int& classSize)
+                {
+                    for (int shift = MinClassShift; shift <= MaxClassShift; shift++) {
+                        int index = (shift - MinClassShift) * 2;
+                        if (size <= (1 << shift)) {
+                            classSize = (1 << shift);
+                            return index;
+                        }
+                        if (size <= (3 << (shift - 1))) {
+                            classSize = (3 << (shift - 1));
+                            return index + 1;
+                        }
+                    }
+                    classSize = size;
+                    return -1;
+                }
+
+                //-----------------------------------------------------------------
+                // must be called with the lock held, returns the buffers to free
+                Header* Trim(int limit)
+                {
+                    Header* freed = 0;
+                    for (int i = ClassCount - 1; i >= 0 && PooledBytes > limit; i--) {
+                        while (FreeLists[i] && PooledBytes > limit) {
+                            Header* header = FreeLists[i];
+                            FreeLists[i] = header->next;
+                            PooledBytes -= header->size;
+                            header->next = freed;
+                            freed = header;
+                        }
+                    }
+                    return freed;
+                }
+
+                //-----------------------------------------------------------------
+                void FreeHeaders(Header* header)
+                {
+                    while (header) {
+                        Header* next = header->next;
+                        std::free(header->raw);
+                        header = next;
+                    }
+                }
+
+            } // anonymous namespace
+
+            //-----------------------------------------------------------------
+            void* Allocate(int size)
+            {
+                if (size <= 0) {
+                    return 0;
+                }
+
+                int classSize;
+                int sizeClass = GetSizeClass(size, classSize);
+
+                if (sizeClass >= 0) {
+                    ScopedLock lock(Lock);
+                    if (Header* header = FreeLists[sizeClass]) {
+                        FreeLists[sizeClass] = header->next;
+                        PooledBytes -= classSize;
+                        LiveBytes   += classSize;
+                        return header + 1;
+                    }
+                }
+
+                void* raw = std::malloc(classSize + sizeof(Header) + Alignment - 1);
+                if (!raw) {
+                    return 0;
+                }
+
+                size_t  buffer = ((size_t)raw + sizeof(Header) + Alignment - 1) & ~(size_t)(Alignment - 1);
+                Header* header = (Header*)buffer - 1;
+                header->raw       = raw;
+                header->next      = 0;
+                header->size      = classSize;
+                header->sizeClass = sizeClass;
+
+                ScopedLock lock(Lock);
+                LiveBytes += classSize;
+                return header + 1;
+            }
+
+            //-----------------------------------------------------------------
+            void Free(void* buffer)
+            {
+                if (!buffer) {
+                    return;
+                }
+
+                Header* header = (Header*)buffer - 1;
+
+                {
+                    ScopedLock lock(Lock);
+                    LiveBytes -= header->size;
+                    if (header->sizeClass >= 0 && PooledBytes + header->size <= Limit) {
+                        header->next = FreeLists[header->sizeClass];
+                        FreeLists[header->sizeClass] = header;
+                        PooledBytes += header->size;
+                        return;
+                    }
+                }
+
+                std::free(header->raw);
+            }
+
+            //-----------------------------------------------------------------
+            void SetLimit(int bytes)
+            {
+                Header* freed;
+                {
+                    ScopedLock lock(Lock);
+                    Limit = std::max(bytes, 0);
+                    freed = Trim(Limit);
+                }
+                FreeHeaders(freed);
+            }
+
+            //-----------------------------------------------------------------
+            int GetLimit()
+            {
+                return Limit;
+            }
+
+            //-----------------------------------------------------------------
+            int GetLiveBytes()
+            {
+                return LiveBytes;
+            }
+
+            //-----------------------------------------------------------------
+            int GetPooledBytes()
+            {
+                return PooledBytes;
+            }
+
+            //-----------------------------------------------------------------
+            void Clear()
+            {
+                Header* freed;
+                {
+                    ScopedLock lock(Lock);
+                    freed = Trim(0);
+                }
+                FreeHeaders(freed);
+            }
+
+        } // namespace pixelpool
+    } // namespace graphics
+} // namespace rpgss
@@ -0,0 +1,59 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_GRAPHICS_PIXELPOOL_HPP_INCLUDED
+#define RPGSS_GRAPHICS_PIXELPOOL_HPP_INCLUDED
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace pixelpool {
+
+            // pixel buffers start on a cache line
+            const int Alignment = 64;
+
+            // sizes are rounded up to a size class, freed buffers are kept
+            // on a free list per class and handed out again, may be called
+            // from any thread
+            void* Allocate(int size);
+            void  Free(void* buffer);
+
+            // freed buffers are kept as long as the pool stays within this
+            // many bytes, 0 frees all buffers right away
+            void SetLimit(int bytes);
+            int  GetLimit();
+
+            // bytes in buffers handed out and bytes kept for reuse
+            int GetLiveBytes();
+            int GetPooledBytes();
+
+            // frees all buffers kept for reuse
+            void Clear();
+
+        } // namespace pixelpool
+    } // namespace graphics
+} // namespace rpgss
+
+
+#endif // RPGSS_GRAPHICS_PIXELPOOL_HPP_INCLUDED
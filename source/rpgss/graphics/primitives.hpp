@@ -25,10 +25,14 @@
 #ifndef RPGSS_GRAPHICS_PRIMITIVES_HPP_INCLUDED
 #define RPGSS_GRAPHICS_PRIMITIVES_HPP_INCLUDED
 
+#include <algorithm>
+#include <cmath>
+
 #include "../common/types.hpp"
 #include "../core/Vec2.hpp"
 #include "../core/Rect.hpp"
 #include "RGBA.hpp"
+#include "SpanTable.hpp"
 
 
 namespace rpgss {
@@ -159,7 +163,8 @@ namespace rpgss {
                     int dinc, i1, i2;
 
                     if (y1 == y2) {
-                        if (y1 < dstClipRect.ul.y || y1 > dstClipRect.lr.y) {
+                        if (y1 < dstClipRect.ul.y || y1 > dstClipRect.lr.y ||
+                            std::max(x1, x2) < dstClipRect.ul.x || std::min(x1, x2) > dstClipRect.lr.x) {
                             return; // fully clipped
                         }
                         i1 = minmax(x1, dstClipRect.ul.x, dstClipRect.lr.x);
@@ -167,7 +172,8 @@ namespace rpgss {
                         dptr = dstPixels + y1 * dstPitch + i1;
                         dinc = 1;
                     } else {
-                        if (x1 < dstClipRect.ul.x || x1 > dstClipRect.lr.x) {
+                        if (x1 < dstClipRect.ul.x || x1 > dstClipRect.lr.x ||
+                            std::max(y1, y2) < dstClipRect.ul.y || std::min(y1, y2) > dstClipRect.lr.y) {
                             return; // fully clipped
                         }
                         i1 = minmax(y1, dstClipRect.ul.y, dstClipRect.lr.y);
@@ -313,6 +319,10 @@ namespace rpgss {
                     int dinc, itemp, idelta, i1, i2;
 
                     if (y1 == y2) {
+                        if (y1 < dstClipRect.ul.y || y1 > dstClipRect.lr.y ||
+                            std::max(x1, x2) < dstClipRect.ul.x || std::min(x1, x2) > dstClipRect.lr.x) {
+                            return; // fully clipped
+                        }
                         i1     = minmax(x1, dstClipRect.ul.x, dstClipRect.lr.x);
                         i2     = minmax(x2, dstClipRect.ul.x, dstClipRect.lr.x);
                         itemp  = x1;
@@ -320,6 +330,10 @@ namespace rpgss {
                         dptr   = dstPixels + y1 * dstPitch + i1;
                         dinc   = 1;
                     } else {
+                        if (x1 < dstClipRect.ul.x || x1 > dstClipRect.lr.x ||
+                            std::max(y1, y2) < dstClipRect.ul.y || std::min(y1, y2) > dstClipRect.lr.y) {
+                            return; // fully clipped
+                        }
                         i1     = minmax(y1, dstClipRect.ul.y, dstClipRect.lr.y);
                         i2     = minmax(y2, dstClipRect.ul.y, dstClipRect.lr.y);
                         itemp  = y1;
@@ -629,34 +643,6 @@ namespace rpgss {
                 }
             }
 
-            //-----------------------------------------------------------------
-            template<typename dstT, typename renderT>
-            __attribute__((__noinline__))
-            void Triangle(
-                dstT*        dstPixels,
-                int          dstPitch,
-                core::Recti  dstClipRect,
-                core::Vec2i  vertices[4],
-                RGBA         color,
-                renderT      renderer)
-            {
-                // TODO
-            }
-
-            //-----------------------------------------------------------------
-            template<typename dstT, typename renderT>
-            __attribute__((__noinline__))
-            void Triangle(
-                dstT*        dstPixels,
-                int          dstPitch,
-                core::Recti  dstClipRect,
-                core::Vec2i  vertices[4],
-                RGBA         colors[3],
-                renderT      renderer)
-            {
-                // TODO
-            }
-
             //-----------------------------------------------------------------
             template<typename dstT, typename renderT>
             __attribute__((__noinline__))
@@ -1015,19 +1001,177 @@ namespace rpgss {
             }
 
             //-----------------------------------------------------------------
-            template<typename dstT, typename srcT, typename renderT>
+            // scanline buffer size of the filtered primitives
+            const int FilterBufferSize = 256;
+
+            //-----------------------------------------------------------------
+            // scanline renderer of the filtered primitives, the scanline is resampled
+            // by sampler into a buffer, which is then drawn by spanRenderer
+            template<typename dstT, typename samplerT, typename spanT>
+            struct FilteredSpan {
+                dstT*       dstPixels;
+                int         dstPitch;
+                const RGBA* srcPixels;
+                int         srcPitch;
+                int         srcWidth;
+                int         srcHeight;
+                samplerT    sampler;
+                spanT       spanRenderer;
+
+                void operator()(int x, int y, int len, int u, int v, int du, int dv) {
+                    RGBA  buffer[FilterBufferSize];
+                    dstT* dptr = dstPixels + y * dstPitch + x;
+
+                    while (len > 0) {
+                        int n = std::min(len, FilterBufferSize);
+                        sampler(buffer, srcPixels, srcPitch, srcWidth, srcHeight, u, v, du, dv, n);
+                        spanRenderer(dptr, buffer, n);
+                        dptr += n;
+                        u    += n * du;
+                        v    += n * dv;
+                        len  -= n;
+                    }
+                }
+            };
+
+            //-----------------------------------------------------------------
+            // like the scaled TexturedRectangle, but each scanline is resampled
+            // by sampler and drawn by spanRenderer (see FilteredSpan)
+            template<typename dstT, typename samplerT, typename spanT>
             __attribute__((__noinline__))
-            void TexturedQuad(
+            void FilteredRectangle(
                 dstT*        dstPixels,
                 int          dstPitch,
                 core::Recti  dstClipRect,
-                core::Vec2i  dstPos[4],
-                srcT*        srcPixels,
+                core::Recti  dstRect,
+                const RGBA*  srcPixels,
                 int          srcPitch,
                 core::Recti  srcRect,
-                renderT      renderer)
+                samplerT     sampler,
+                spanT        spanRenderer)
             {
-                if (dstClipRect.isEmpty()) {
+                if (dstClipRect.isEmpty() || dstRect.isEmpty() || srcRect.isEmpty()) {
+                    return;
+                }
+
+                core::Recti drct = dstRect.getIntersection(dstClipRect);
+                if (drct.isEmpty()) {
+                    return;
+                }
+
+                // 16.16 fixed point, pixel centers map to pixel centers
+                const int du = (srcRect.getWidth()  << 16) / dstRect.getWidth();
+                const int dv = (srcRect.getHeight() << 16) / dstRect.getHeight();
+                const int u0 = (du >> 1) - 0x8000 + (drct.getX() - dstRect.getX()) * du;
+                int       v  = (dv >> 1) - 0x8000 + (drct.getY() - dstRect.getY()) * dv;
+
+                FilteredSpan<dstT, samplerT, spanT> span = {
+                    dstPixels,
+                    dstPitch,
+                    srcPixels + (srcRect.getY() * srcPitch) + srcRect.getX(),
+                    srcPitch,
+                    srcRect.getWidth(),
+                    srcRect.getHeight(),
+                    sampler,
+                    spanRenderer
+                };
+
+                for (int iy = drct.ul.y; iy <= drct.lr.y; iy++) {
+                    span(drct.getX(), iy, drct.getWidth(), u0, v, du, 0);
+                    v += dv;
+                }
+            }
+
+            //-----------------------------------------------------------------
+            template<typename renderT>
+            struct PixelRun {
+                renderT renderer;
+
+                explicit PixelRun(renderT r = renderT())
+                    : renderer(r)
+                {
+                }
+
+                template<typename dstT, typename srcT>
+                void operator()(dstT* dst, const srcT* src, int len) {
+                    while (len > 0) {
+                        renderer(dst, src);
+                        ++dst;
+                        ++src;
+                        --len;
+                    }
+                }
+            };
+
+            //-----------------------------------------------------------------
+            // like TexturedRectangle, but transparent source pixels are skipped,
+            // opaque runs go to copier and translucent runs go to blender
+            template<typename dstT, typename srcT, typename copyT, typename blendT>
+            __attribute__((__noinline__))
+            void SpannedRectangle(
+                dstT*            dstPixels,
+                int              dstPitch,
+                core::Recti      dstClipRect,
+                core::Vec2i      dstPos,
+                const srcT*      srcPixels,
+                int              srcPitch,
+                core::Recti      srcRect,
+                const SpanTable& spanTable,
+                copyT            copier,
+                blendT           blender)
+            {
+                if (dstClipRect.isEmpty() || srcRect.isEmpty()) {
+                    return;
+                }
+
+                core::Recti drct = core::Recti(dstPos, srcRect.getDimensions()).getIntersection(dstClipRect);
+                if (drct.isEmpty()) {
+                    return;
+                }
+
+                core::Recti srct(srcRect.getPosition() + (drct.getPosition() - dstPos), drct.getDimensions());
+
+                const int sx1 = srct.getX();
+                const int sx2 = srct.getX() + srct.getWidth();
+
+                dstT*       drow = dstPixels + (drct.getY() * dstPitch) + drct.getX();
+                const srcT* srow = srcPixels + (srct.getY() * srcPitch);
+
+                for (int sy = srct.getY(); sy < srct.getY() + srct.getHeight(); sy++) {
+                    const SpanTable::Span* span = spanTable.getRowBegin(sy);
+                    const SpanTable::Span* end  = spanTable.getRowEnd(sy);
+
+                    for (; span != end && span->x < sx2; ++span) {
+                        int x1 = std::max(span->x, sx1);
+                        int x2 = std::min(span->x + span->length, sx2);
+                        if (x1 >= x2) {
+                            continue;
+                        }
+
+                        if (span->type == SpanTable::Span::Opaque) {
+                            copier(drow + (x1 - sx1), srow + x1, x2 - x1);
+                        } else {
+                            blender(drow + (x1 - sx1), srow + x1, x2 - x1);
+                        }
+                    }
+
+                    drow += dstPitch;
+                    srow += srcPitch;
+                }
+            }
+
+            //-----------------------------------------------------------------
+            // walks the scanlines of a quad, whose corners map to the corners of srcRect,
+            // and calls span(x, y, len, u, v, du, dv) for each of them, u and v are source
+            // texel coordinates relative to srcRect in 16.16 fixed point and stay inside it
+            template<typename spanT>
+            void QuadSpans(
+                const core::Recti& dstClipRect,
+                const core::Vec2i  dstPos[4],
+                const core::Recti& srcRect,
+                spanT&             span)
+            {
+                if (dstClipRect.isEmpty() || srcRect.isEmpty()) {
                     return;
                 }
 
@@ -1048,13 +1192,13 @@ namespace rpgss {
                 int minY = minmax(dstPos[top].y,    dstClipRect.ul.y, dstClipRect.lr.y);
                 int maxY = minmax(dstPos[bottom].y, dstClipRect.ul.y, dstClipRect.lr.y);
 
-                // precalculate line segment information
+                // precalculate line segment information,
+                // each segment is stepped once per scanline
                 struct segment {
                     // y1 < y2, always
-                    int x1, x2;
-                    int y1, y2;
-                    int u1, u2;
-                    int v1, v2;
+                    int x1, y1, y2;
+                    int u1, v1;
+                    int dx, du, dv; // per scanline, 16.16
                 } segments[4];
 
                 // segment 0 = top
@@ -1068,22 +1212,31 @@ namespace rpgss {
                     int p1 = i;
                     int p2 = (i + 1) & 3;  // x & 3 == x % 4
 
-                    s->x1 = dstPos[p1].x;
-                    s->y1 = dstPos[p1].y;
-                    s->u1 = (i == 1 || i == 2 ? srcRect.getWidth()  - 1 : 0);
-                    s->v1 = (i == 2 || i == 3 ? srcRect.getHeight() - 1 : 0);
-
-                    s->x2 = dstPos[p2].x;
-                    s->y2 = dstPos[p2].y;
-                    s->u2 = (i == 0 || i == 1 ? srcRect.getWidth()  - 1 : 0);
-                    s->v2 = (i == 1 || i == 2 ? srcRect.getHeight() - 1 : 0);
-
-                    if (dstPos[p1].y > dstPos[p2].y) {
-                        std::swap(s->x1, s->x2);
-                        std::swap(s->y1, s->y2);
-                        std::swap(s->u1, s->u2);
-                        std::swap(s->v1, s->v2);
+                    int x1 = dstPos[p1].x;
+                    int y1 = dstPos[p1].y;
+                    int u1 = (i == 1 || i == 2 ? srcRect.getWidth()  - 1 : 0) << 16;
+                    int v1 = (i == 2 || i == 3 ? srcRect.getHeight() - 1 : 0) << 16;
+
+                    int x2 = dstPos[p2].x;
+                    int y2 = dstPos[p2].y;
+                    int u2 = (i == 0 || i == 1 ? srcRect.getWidth()  - 1 : 0) << 16;
+                    int v2 = (i == 1 || i == 2 ? srcRect.getHeight() - 1 : 0) << 16;
+
+                    if (y1 > y2) {
+                        std::swap(x1, x2);
+                        std::swap(y1, y2);
+                        std::swap(u1, u2);
+                        std::swap(v1, v2);
                     }
+
+                    s->x1 = x1 * 65536;
+                    s->y1 = y1;
+                    s->y2 = y2;
+                    s->u1 = u1;
+                    s->v1 = v1;
+                    s->dx = (y1 == y2 ? 0 : ((x2 - x1) * 65536) / (y2 - y1));
+                    s->du = (y1 == y2 ? 0 : (u2 - u1) / (y2 - y1));
+                    s->dv = (y1 == y2 ? 0 : (v2 - v1) / (y2 - y1));
                 }
 
                 // draw scanlines
@@ -1093,7 +1246,6 @@ namespace rpgss {
                     int minX = dstClipRect.lr.x + 1;
                     int maxX = dstClipRect.ul.x - 1;
 
-                    // default values in case no
                     int minU = 0;
                     int minV = 0;
                     int maxU = 0;
@@ -1101,50 +1253,564 @@ namespace rpgss {
 
                     // intersect iy in each line
                     for (int i = 3; i >= 0; --i) {
-                        segment* s = segments + i;
+                        const segment* s = segments + i;
 
-                        // if iy is even in the segment and segment's length is not zero
                         if (s->y1 <= iy && iy <= s->y2) {
-                            int x = (s->y1 == s->y2 ?
-                                     s->x1 :
-                                     s->x1 + (iy - s->y1) * (s->x2 - s->x1) / (s->y2 - s->y1));
-                            int u = (s->y1 == s->y2 ?
-                                     s->u1 :
-                                     s->u1 + (iy - s->y1) * (s->u2 - s->u1) / (s->y2 - s->y1));
-                            int v = (s->y1 == s->y2 ?
-                                     s->v1 :
-                                     s->v1 + (iy - s->y1) * (s->v2 - s->v1) / (s->y2 - s->y1));
+                            int n = iy - s->y1;
+                            int x = (s->x1 + n * s->dx) >> 16;
 
                             // update minimum and maximum x values
                             if (x < minX) {
                                 minX = x;
-                                minU = u;
-                                minV = v;
+                                minU = s->u1 + n * s->du;
+                                minV = s->v1 + n * s->dv;
                             }
 
                             if (x > maxX) {
                                 maxX = x;
-                                maxU = u;
-                                maxV = v;
+                                maxU = s->u1 + n * s->du;
+                                maxV = s->v1 + n * s->dv;
                             }
                         }
                     }
 
+                    // nothing to draw on this scanline
+                    if (minX >= maxX) {
+                        continue;
+                    }
+
+                    // the only divisions per scanline
+                    const int du = (maxU - minU) / (maxX - minX);
+                    const int dv = (maxV - minV) / (maxX - minX);
+
                     // now clip the x extents
-                    int oldMinX = minX;
-                    int oldMaxX = maxX;
+                    int x1 = std::max(minX, (int)dstClipRect.ul.x);
+                    int x2 = std::min(maxX, (int)dstClipRect.lr.x);
+
+                    if (x1 <= x2) {
+                        span(x1, iy, x2 - x1 + 1, minU + (x1 - minX) * du, minV + (x1 - minX) * dv, du, dv);
+                    }
+                }
+            }
+
+            //-----------------------------------------------------------------
+            // scanline renderer of TexturedQuad
+            template<typename dstT, typename srcT, typename renderT>
+            struct TexturedSpan {
+                dstT*       dstPixels;
+                int         dstPitch;
+                const srcT* srcPixels;
+                int         srcPitch;
+                renderT     renderer;
+
+                void operator()(int x, int y, int len, int u, int v, int du, int dv) {
+                    dstT* dptr = dstPixels + y * dstPitch + x;
+
+                    // round to the nearest texel
+                    u += 0x8000;
+                    v += 0x8000;
+
+                    while (len > 0) {
+                        renderer(dptr, srcPixels + (v >> 16) * srcPitch + (u >> 16));
+                        ++dptr;
+                        u += du;
+                        v += dv;
+                        --len;
+                    }
+                }
+            };
+
+            //-----------------------------------------------------------------
+            template<typename dstT, typename srcT, typename renderT>
+            __attribute__((__noinline__))
+            void TexturedQuad(
+                dstT*        dstPixels,
+                int          dstPitch,
+                core::Recti  dstClipRect,
+                core::Vec2i  dstPos[4],
+                const srcT*  srcPixels,
+                int          srcPitch,
+                core::Recti  srcRect,
+                renderT      renderer)
+            {
+                TexturedSpan<dstT, srcT, renderT> span = {
+                    dstPixels,
+                    dstPitch,
+                    srcPixels + (srcRect.getY() * srcPitch) + srcRect.getX(),
+                    srcPitch,
+                    renderer
+                };
+
+                QuadSpans(dstClipRect, dstPos, srcRect, span);
+            }
+
+            //-----------------------------------------------------------------
+            // like TexturedQuad, but each scanline is resampled by sampler
+            // and drawn by spanRenderer (see FilteredSpan)
+            template<typename dstT, typename samplerT, typename spanT>
+            __attribute__((__noinline__))
+            void FilteredQuad(
+                dstT*        dstPixels,
+                int          dstPitch,
+                core::Recti  dstClipRect,
+                core::Vec2i  dstPos[4],
+                const RGBA*  srcPixels,
+                int          srcPitch,
+                core::Recti  srcRect,
+                samplerT     sampler,
+                spanT        spanRenderer)
+            {
+                FilteredSpan<dstT, samplerT, spanT> span = {
+                    dstPixels,
+                    dstPitch,
+                    srcPixels + (srcRect.getY() * srcPitch) + srcRect.getX(),
+                    srcPitch,
+                    srcRect.getWidth(),
+                    srcRect.getHeight(),
+                    sampler,
+                    spanRenderer
+                };
+
+                QuadSpans(dstClipRect, dstPos, srcRect, span);
+            }
+
+            //-----------------------------------------------------------------
+            // narrows [n1, n2] to the n for which a + d * n lies in [0, limit)
+            inline void clip_affine_range(i64 a, i64 d, i64 limit, int& n1, int& n2)
+            {
+                if (d == 0) {
+                    if (a < 0 || a >= limit) {
+                        n2 = n1 - 1;
+                    }
+                    return;
+                }
 
-                    minX = minmax(minX, dstClipRect.ul.x, dstClipRect.lr.x);
-                    maxX = minmax(maxX, dstClipRect.ul.x, dstClipRect.lr.x);
+                // slightly generous, the caller checks the end points exactly
+                double lo = (double)(0     - a) / d;
+                double hi = (double)(limit - a) / d;
+                if (d < 0) {
+                    std::swap(lo, hi);
+                }
+
+                n1 = std::max(n1, (int)std::max(std::floor(lo) - 1.0, -2147483648.0));
+                n2 = std::min(n2, (int)std::min(std::ceil(hi)  + 1.0,  2147483647.0));
+            }
+
+            //-----------------------------------------------------------------
+            // bounding box of a rectangle rotated around its center
+            inline core::Recti GetTransformedBounds(const core::Recti& rect, float angle)
+            {
+                double rad = angle * (3.14159265358979 / 180.0);
+                double cs  = std::cos(rad);
+                double sn  = std::sin(rad);
+
+                double hw = rect.getWidth()  * 0.5;
+                double hh = rect.getHeight() * 0.5;
+                double cx = rect.getX() + hw;
+                double cy = rect.getY() + hh;
+
+                double ex = std::fabs(hw * cs) + std::fabs(hh * sn);
+                double ey = std::fabs(hw * sn) + std::fabs(hh * cs);
+
+                return core::Recti(
+                    (int)std::floor(cx - ex),
+                    (int)std::floor(cy - ey),
+                    (int)std::ceil(cx + ex) - (int)std::floor(cx - ex),
+                    (int)std::ceil(cy + ey) - (int)std::floor(cy - ey)
+                );
+            }
+
+            //-----------------------------------------------------------------
+            // draws srcRect stretched to dstRect and rotated by angle degrees around the
+            // center of dstRect (see core::Vec2::rotateBy), the inverse mapping is set up
+            // once and each scanline is clipped against the source and handed to FilteredSpan
+            template<typename dstT, typename samplerT, typename spanT>
+            __attribute__((__noinline__))
+            void TransformedRectangle(
+                dstT*        dstPixels,
+                int          dstPitch,
+                core::Recti  dstClipRect,
+                core::Recti  dstRect,
+                float        angle,
+                const RGBA*  srcPixels,
+                int          srcPitch,
+                core::Recti  srcRect,
+                samplerT     sampler,
+                spanT        spanRenderer)
+            {
+                if (dstClipRect.isEmpty() || dstRect.isEmpty() || srcRect.isEmpty()) {
+                    return;
+                }
+
+                double rad = angle * (3.14159265358979 / 180.0);
+                double cs  = std::cos(rad);
+                double sn  = std::sin(rad);
+
+                double hw = dstRect.getWidth()  * 0.5;
+                double hh = dstRect.getHeight() * 0.5;
+                double cx = dstRect.getX() + hw;
+                double cy = dstRect.getY() + hh;
+
+                core::Recti bounds = GetTransformedBounds(dstRect, angle).getIntersection(dstClipRect);
+                if (bounds.isEmpty()) {
+                    return;
+                }
+
+                // inverse mapping from destination pixel centers to source texel centers
+                double sx = srcRect.getWidth()  / (double)dstRect.getWidth();
+                double sy = srcRect.getHeight() / (double)dstRect.getHeight();
+
+                double tx = bounds.getX() + 0.5 - cx;
+                double ty = bounds.getY() + 0.5 - cy;
+
+                const int dudx = (int)(sx *  cs * 65536.0);
+                const int dvdx = (int)(sy *  sn * 65536.0);
+                const int dudy = (int)(sx * -sn * 65536.0);
+                const int dvdy = (int)(sy *  cs * 65536.0);
+
+                int u = (int)((sx * (tx * cs - ty * sn) + srcRect.getWidth()  * 0.5 - 0.5) * 65536.0);
+                int v = (int)((sy * (tx * sn + ty * cs) + srcRect.getHeight() * 0.5 - 0.5) * 65536.0);
+
+                // texels are hit if their center is within half a texel
+                const i64 ulimit = (i64)srcRect.getWidth()  << 16;
+                const i64 vlimit = (i64)srcRect.getHeight() << 16;
+
+                FilteredSpan<dstT, samplerT, spanT> span = {
+                    dstPixels,
+                    dstPitch,
+                    srcPixels + (srcRect.getY() * srcPitch) + srcRect.getX(),
+                    srcPitch,
+                    srcRect.getWidth(),
+                    srcRect.getHeight(),
+                    sampler,
+                    spanRenderer
+                };
+
+                for (int iy = bounds.ul.y; iy <= bounds.lr.y; iy++) {
+                    int n1 = 0;
+                    int n2 = bounds.getWidth() - 1;
+
+                    clip_affine_range((i64)u + 0x8000, dudx, ulimit, n1, n2);
+                    clip_affine_range((i64)v + 0x8000, dvdx, vlimit, n1, n2);
+
+                    // rounding may leave a pixel outside the source at either end
+                    while (n1 <= n2 && !(
+                        (u32)(u + 0x8000 + n1 * dudx) < (u32)ulimit &&
+                        (u32)(v + 0x8000 + n1 * dvdx) < (u32)vlimit))
+                    {
+                        ++n1;
+                    }
+
+                    while (n1 <= n2 && !(
+                        (u32)(u + 0x8000 + n2 * dudx) < (u32)ulimit &&
+                        (u32)(v + 0x8000 + n2 * dvdx) < (u32)vlimit))
+                    {
+                        --n2;
+                    }
+
+                    if (n1 <= n2) {
+                        span(bounds.ul.x + n1, iy, n2 - n1 + 1, u + n1 * dudx, v + n1 * dvdx, dudx, dvdx);
+                    }
+
+                    u += dudy;
+                    v += dvdy;
+                }
+            }
+
+            //-----------------------------------------------------------------
+            inline i64 floor_div(i64 a, i64 b)
+            {
+                i64 q = a / b;
+                if ((a % b) != 0 && ((a < 0) != (b < 0))) {
+                    --q;
+                }
+                return q;
+            }
+
+            //-----------------------------------------------------------------
+            // edge functions of a triangle, evaluated at pixel centers in
+            // doubled coordinates so everything stays integral; pixels on
+            // shared edges belong to exactly one triangle (top-left rule)
+            class TriangleEdges {
+            public:
+                TriangleEdges(const core::Vec2i vertices[3]) {
+                    for (int i = 0; i < 3; i++) {
+                        _x[i] = (i64)vertices[i].x * 2;
+                        _y[i] = (i64)vertices[i].y * 2;
+                    }
+
+                    _area = evaluate(0, _x[2], _y[2]);
+
+                    // make the inside positive
+                    _flipped = _area < 0;
+                    if (_flipped) {
+                        std::swap(_x[1], _x[2]);
+                        std::swap(_y[1], _y[2]);
+                        _area = -_area;
+                    }
+
+                    for (int i = 0; i < 3; i++) {
+                        i64 dx = _x[(i + 1) % 3] - _x[i];
+                        i64 dy = _y[(i + 1) % 3] - _y[i];
+                        _bias[i] = (dy < 0 || (dy == 0 && dx > 0)) ? 0 : 1;
+                    }
+                }
+
+                bool isEmpty() const {
+                    return _area == 0;
+                }
+
+                // true if vertices 1 and 2 were swapped
+                bool isFlipped() const {
+                    return _flipped;
+                }
+
+                i64 getArea() const {
+                    return _area;
+                }
+
+                core::Recti getBounds() const {
+                    i64 x1 = std::min(_x[0], std::min(_x[1], _x[2])) / 2;
+                    i64 y1 = std::min(_y[0], std::min(_y[1], _y[2])) / 2;
+                    i64 x2 = std::max(_x[0], std::max(_x[1], _x[2])) / 2;
+                    i64 y2 = std::max(_y[0], std::max(_y[1], _y[2])) / 2;
+                    return core::Recti((int)x1, (int)y1, (int)(x2 - x1), (int)(y2 - y1));
+                }
+
+                // edge i runs from vertex i to vertex i + 1
+                i64 evaluate(int i, i64 px, i64 py) const {
+                    int j = (i + 1) % 3;
+                    return (_x[j] - _x[i]) * (py - _y[i]) - (_y[j] - _y[i]) * (px - _x[i]);
+                }
+
+                // narrows [x1, x2) to the pixels of row y inside the triangle
+                bool getSpan(int y, int& x1, int& x2) const {
+                    i64 l  = x1;
+                    i64 r  = x2;
+                    i64 py = (i64)y * 2 + 1;
+
+                    for (int i = 0; i < 3; i++) {
+                        int j  = (i + 1) % 3;
+                        i64 dx = _x[j] - _x[i];
+                        i64 dy = _y[j] - _y[i];
+
+                        // inside if dy * px <= k, px = 2 * x + 1
+                        i64 k = dx * (py - _y[i]) + dy * _x[i] - _bias[i];
+
+                        if (dy > 0) {
+                            r = std::min(r, floor_div(floor_div(k, dy) - 1, 2) + 1);
+                        } else if (dy < 0) {
+                            l = std::max(l, -floor_div(-floor_div(-k, dy) - 1, -2));
+                        } else if (k < 0) {
+                            return false;
+                        }
+                    }
+
+                    if (l >= r) {
+                        return false;
+                    }
+
+                    x1 = (int)l;
+                    x2 = (int)r;
+                    return true;
+                }
+
+            private:
+                i64  _x[3];
+                i64  _y[3];
+                i64  _area;
+                int  _bias[3];
+                bool _flipped;
+            };
 
-                    // render the scanline pixels
-                    if (minX != maxX) {
-                        for (int ix = minX; ix <= maxX; ix++) {
-                            int iu = minU + (ix - oldMinX) * (maxU - minU) / (oldMaxX - oldMinX);
-                            int iv = minV + (ix - oldMinX) * (maxV - minV) / (oldMaxX - oldMinX);
+            //-----------------------------------------------------------------
+            // filled triangle, each scanline is drawn by spanRenderer in blocks
+            // of up to FilterBufferSize pixels (see FilteredSpan)
+            template<typename dstT, typename spanT>
+            __attribute__((__noinline__))
+            void Triangle(
+                dstT*             dstPixels,
+                int               dstPitch,
+                core::Recti       dstClipRect,
+                const core::Vec2i vertices[3],
+                RGBA              color,
+                spanT             spanRenderer)
+            {
+                TriangleEdges edges(vertices);
+                if (edges.isEmpty()) {
+                    return;
+                }
+
+                core::Recti drct = dstClipRect.getIntersection(edges.getBounds());
+                if (drct.isEmpty()) {
+                    return;
+                }
+
+                RGBA buffer[FilterBufferSize];
+                std::fill(buffer, buffer + std::min(drct.getWidth(), FilterBufferSize), color);
+
+                for (int iy = drct.ul.y; iy <= drct.lr.y; iy++) {
+                    int x1 = drct.ul.x;
+                    int x2 = drct.lr.x + 1;
+                    if (!edges.getSpan(iy, x1, x2)) {
+                        continue;
+                    }
+
+                    dstT* dptr = dstPixels + iy * dstPitch + x1;
+                    int   len  = x2 - x1;
+
+                    while (len > 0) {
+                        int n = std::min(len, FilterBufferSize);
+                        spanRenderer(dptr, buffer, n);
+                        dptr += n;
+                        len  -= n;
+                    }
+                }
+            }
+
+            //-----------------------------------------------------------------
+            inline int triangle_channel(const TriangleEdges& edges, const int c[3], i64 px, i64 py)
+            {
+                // vertex i is weighted by the edge opposite to it
+                i64 sum = c[0] * edges.evaluate(1, px, py) +
+                          c[1] * edges.evaluate(2, px, py) +
+                          c[2] * edges.evaluate(0, px, py);
+                double v = (double)sum / edges.getArea();
+                return (int)(std::max(0.0, std::min(255.0, v)) * 65536.0);
+            }
+
+            //-----------------------------------------------------------------
+            // gouraud shaded triangle, colors are interpolated in 16.16
+            // fixed point along each scanline
+            template<typename dstT, typename spanT>
+            __attribute__((__noinline__))
+            void Triangle(
+                dstT*             dstPixels,
+                int               dstPitch,
+                core::Recti       dstClipRect,
+                const core::Vec2i vertices[3],
+                const RGBA        colors[3],
+                spanT             spanRenderer)
+            {
+                if (colors[0] == colors[1] && colors[0] == colors[2]) {
+                    // fall back on simpler algorithm
+                    Triangle(dstPixels, dstPitch, dstClipRect, vertices, colors[0], spanRenderer);
+                    return;
+                }
+
+                TriangleEdges edges(vertices);
+                if (edges.isEmpty()) {
+                    return;
+                }
+
+                core::Recti drct = dstClipRect.getIntersection(edges.getBounds());
+                if (drct.isEmpty()) {
+                    return;
+                }
+
+                RGBA c[3] = { colors[0], colors[1], colors[2] };
+                if (edges.isFlipped()) {
+                    std::swap(c[1], c[2]);
+                }
+
+                int cr[3] = { c[0].red,   c[1].red,   c[2].red   };
+                int cg[3] = { c[0].green, c[1].green, c[2].green };
+                int cb[3] = { c[0].blue,  c[1].blue,  c[2].blue  };
+                int ca[3] = { c[0].alpha, c[1].alpha, c[2].alpha };
+
+                RGBA buffer[FilterBufferSize];
+
+                for (int iy = drct.ul.y; iy <= drct.lr.y; iy++) {
+                    int x1 = drct.ul.x;
+                    int x2 = drct.lr.x + 1;
+                    if (!edges.getSpan(iy, x1, x2)) {
+                        continue;
+                    }
 
-                            renderer(dstPixels + iy * dstPitch + ix, srcPixels + iv * srcPitch + iu);
+                    dstT* dptr = dstPixels + iy * dstPitch + x1;
+                    int   len  = x2 - x1;
+
+                    // colors at the first and last pixel centers of the span
+                    i64 py  = (i64)iy * 2 + 1;
+                    i64 px1 = (i64)x1 * 2 + 1;
+                    i64 px2 = (i64)x2 * 2 - 1;
+
+                    i32 r = triangle_channel(edges, cr, px1, py);
+                    i32 g = triangle_channel(edges, cg, px1, py);
+                    i32 b = triangle_channel(edges, cb, px1, py);
+                    i32 a = triangle_channel(edges, ca, px1, py);
+
+                    i32 step_r = 0;
+                    i32 step_g = 0;
+                    i32 step_b = 0;
+                    i32 step_a = 0;
+
+                    if (len > 1) {
+                        step_r = (triangle_channel(edges, cr, px2, py) - r) / (len - 1);
+                        step_g = (triangle_channel(edges, cg, px2, py) - g) / (len - 1);
+                        step_b = (triangle_channel(edges, cb, px2, py) - b) / (len - 1);
+                        step_a = (triangle_channel(edges, ca, px2, py) - a) / (len - 1);
+                    }
+
+                    while (len > 0) {
+                        int n = std::min(len, FilterBufferSize);
+
+                        for (int i = 0; i < n; i++) {
+                            buffer[i].red   = r >> 16;
+                            buffer[i].green = g >> 16;
+                            buffer[i].blue  = b >> 16;
+                            buffer[i].alpha = a >> 16;
+                            r += step_r;
+                            g += step_g;
+                            b += step_b;
+                            a += step_a;
                         }
+
+                        spanRenderer(dptr, buffer, n);
+                        dptr += n;
+                        len  -= n;
+                    }
+                }
+            }
+
+            //-----------------------------------------------------------------
+            // unscaled glyphs from one glyph image, glyphT has a srcRect and
+            // a dstRect of equal size; each glyph row is drawn by spanRenderer
+            template<typename dstT, typename glyphT, typename spanT>
+            __attribute__((__noinline__))
+            void GlyphRun(
+                dstT*         dstPixels,
+                int           dstPitch,
+                core::Recti   dstClipRect,
+                const RGBA*   glyphPixels,
+                int           glyphPitch,
+                const glyphT* glyphs,
+                int           count,
+                spanT         spanRenderer)
+            {
+                if (dstClipRect.isEmpty()) {
+                    return;
+                }
+
+                for (int i = 0; i < count; i++) {
+                    const glyphT& glyph = glyphs[i];
+
+                    core::Recti drct = dstClipRect.getIntersection(glyph.dstRect);
+                    if (drct.isEmpty()) {
+                        continue;
+                    }
+
+                    int sx = glyph.srcRect.getX() + (drct.getX() - glyph.dstRect.getX());
+                    int sy = glyph.srcRect.getY() + (drct.getY() - glyph.dstRect.getY());
+
+                    dstT*       dptr = dstPixels   + drct.getY() * dstPitch   + drct.getX();
+                    const RGBA* sptr = glyphPixels + sy          * glyphPitch + sx;
+
+                    int w = drct.getWidth();
+                    for (int iy = drct.getHeight(); iy > 0; --iy) {
+                        spanRenderer(dptr, sptr, w);
+                        dptr += dstPitch;
+                        sptr += glyphPitch;
                     }
                 }
             }
@@ -0,0 +1,266 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_GRAPHICS_RENDERERS_HPP_INCLUDED
+#define RPGSS_GRAPHICS_RENDERERS_HPP_INCLUDED
+
+#include <algorithm>
+
+#include "RGBA.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+
+        //-----------------------------------------------------------------
+        struct rgba_set {
+            void operator()(RGBA* dst, const RGBA* src) {
+                dst->red   = src->red;
+                dst->green = src->green;
+                dst->blue  = src->blue;
+                dst->alpha = src->alpha;
+            }
+
+            void operator()(RGBA* dst, u8 red, u8 green, u8 blue, u8 alpha) {
+                dst->red   = red;
+                dst->green = green;
+                dst->blue  = blue;
+                dst->alpha = alpha;
+            }
+        };
+
+        struct rgba_mix {
+            void operator()(RGBA* dst, const RGBA* src) {
+                int sa = src->alpha  + 1;
+                int da = 256 - src->alpha;
+                dst->red   = (dst->red   * da + src->red   * sa) >> 8;
+                dst->green = (dst->green * da + src->green * sa) >> 8;
+                dst->blue  = (dst->blue  * da + src->blue  * sa) >> 8;
+            }
+
+            void operator()(RGBA* dst, u8 red, u8 green, u8 blue, u8 alpha) {
+                int sa = alpha  + 1;
+                int da = 256 - alpha;
+                dst->red   = (dst->red   * da + red   * sa) >> 8;
+                dst->green = (dst->green * da + green * sa) >> 8;
+                dst->blue  = (dst->blue  * da + blue  * sa) >> 8;
+            }
+        };
+
+        struct rgba_set_rgb {
+            void operator()(RGBA* dst, const RGBA* src) {
+                dst->red   = src->red;
+                dst->green = src->green;
+                dst->blue  = src->blue;
+            }
+        };
+
+        struct rgba_set_rgb_masked {
+            void operator()(RGBA* dst, const RGBA* src) {
+                if (src->alpha) {
+                    dst->red   = src->red;
+                    dst->green = src->green;
+                    dst->blue  = src->blue;
+                }
+            }
+        };
+
+        struct rgba_mix_pm {
+            void operator()(RGBA* dst, const RGBA* src) {
+                int da = 256 - src->alpha;
+                dst->red   = std::min(src->red   + (dst->red   * da >> 8), 255);
+                dst->green = std::min(src->green + (dst->green * da >> 8), 255);
+                dst->blue  = std::min(src->blue  + (dst->blue  * da >> 8), 255);
+            }
+        };
+
+        struct rgba_add {
+            void operator()(RGBA* dst, const RGBA* src) {
+                dst->red   = std::min(dst->red   + src->red,   255);
+                dst->green = std::min(dst->green + src->green, 255);
+                dst->blue  = std::min(dst->blue  + src->blue,  255);
+                dst->alpha = std::min(dst->alpha + src->alpha, 255);
+            }
+
+            void operator()(RGBA* dst, u8 red, u8 green, u8 blue, u8 alpha) {
+                dst->red   = std::min(dst->red   + red,   255);
+                dst->green = std::min(dst->green + green, 255);
+                dst->blue  = std::min(dst->blue  + blue,  255);
+                dst->alpha = std::min(dst->alpha + alpha, 255);
+            }
+        };
+
+        struct rgba_sub {
+            void operator()(RGBA* dst, const RGBA* src) {
+                dst->red   = std::max(dst->red   - src->red,   0);
+                dst->green = std::max(dst->green - src->green, 0);
+                dst->blue  = std::max(dst->blue  - src->blue,  0);
+                dst->alpha = std::max(dst->alpha - src->alpha, 0);
+            }
+
+            void operator()(RGBA* dst, u8 red, u8 green, u8 blue, u8 alpha) {
+                dst->red   = std::max(dst->red   - red,   0);
+                dst->green = std::max(dst->green - green, 0);
+                dst->blue  = std::max(dst->blue  - blue,  0);
+                dst->alpha = std::max(dst->alpha - alpha, 0);
+            }
+        };
+
+        struct rgba_mul {
+            void operator()(RGBA* dst, const RGBA* src) {
+                dst->red   = dst->red   * (src->red   + 1) >> 8;
+                dst->green = dst->green * (src->green + 1) >> 8;
+                dst->blue  = dst->blue  * (src->blue  + 1) >> 8;
+                dst->alpha = dst->alpha * (src->alpha + 1) >> 8;
+            }
+
+            void operator()(RGBA* dst, u8 red, u8 green, u8 blue, u8 alpha) {
+                dst->red   = dst->red   * (red   + 1) >> 8;
+                dst->green = dst->green * (green + 1) >> 8;
+                dst->blue  = dst->blue  * (blue  + 1) >> 8;
+                dst->alpha = dst->alpha * (alpha + 1) >> 8;
+            }
+        };
+
+        //-----------------------------------------------------------------
+        struct rgba_set_col
+        {
+            RGBA c;
+
+            explicit rgba_set_col(RGBA color)
+                : c(color)
+            {
+            }
+
+            void operator()(RGBA* dst, const RGBA* src) {
+                dst->red   = src->red   * (c.red   + 1) >> 8;
+                dst->green = src->green * (c.green + 1) >> 8;
+                dst->blue  = src->blue  * (c.blue  + 1) >> 8;
+                dst->alpha = src->alpha * (c.alpha + 1) >> 8;
+            }
+        };
+
+        //-----------------------------------------------------------------
+        struct rgba_mix_col
+        {
+            RGBA c;
+
+            explicit rgba_mix_col(RGBA color)
+                : c(color)
+            {
+            }
+
+            void operator()(RGBA* dst, const RGBA* src) {
+                int sa = (src->alpha * (c.alpha + 1) >> 8) + 1;
+                int da = 256 - (sa - 1);
+                dst->red   = (dst->red   * da + (src->red   * (c.red   + 1) >> 8) * sa) >> 8;
+                dst->green = (dst->green * da + (src->green * (c.green + 1) >> 8) * sa) >> 8;
+                dst->blue  = (dst->blue  * da + (src->blue  * (c.blue  + 1) >> 8) * sa) >> 8;
+            }
+        };
+
+        //-----------------------------------------------------------------
+        struct rgba_mix_pm_col
+        {
+            int cr;
+            int cg;
+            int cb;
+            int ca;
+
+            // the color's alpha scales the premultiplied color channels too
+            explicit rgba_mix_pm_col(RGBA color)
+                : cr((color.red   + 1) * (color.alpha + 1) >> 8)
+                , cg((color.green + 1) * (color.alpha + 1) >> 8)
+                , cb((color.blue  + 1) * (color.alpha + 1) >> 8)
+                , ca(color.alpha + 1)
+            {
+            }
+
+            void operator()(RGBA* dst, const RGBA* src) {
+                int da = 256 - (src->alpha * ca >> 8);
+                dst->red   = std::min((src->red   * cr >> 8) + (dst->red   * da >> 8), 255);
+                dst->green = std::min((src->green * cg >> 8) + (dst->green * da >> 8), 255);
+                dst->blue  = std::min((src->blue  * cb >> 8) + (dst->blue  * da >> 8), 255);
+            }
+        };
+
+        //-----------------------------------------------------------------
+        struct rgba_add_col
+        {
+            RGBA c;
+
+            explicit rgba_add_col(RGBA color)
+                : c(color)
+            {
+            }
+
+            void operator()(RGBA* dst, const RGBA* src) {
+                dst->red   = std::min(dst->red   + (src->red   * (c.red   + 1) >> 8), 255);
+                dst->green = std::min(dst->green + (src->green * (c.green + 1) >> 8), 255);
+                dst->blue  = std::min(dst->blue  + (src->blue  * (c.blue  + 1) >> 8), 255);
+                dst->alpha = std::min(dst->alpha + (src->alpha * (c.alpha + 1) >> 8), 255);
+            }
+        };
+
+        //-----------------------------------------------------------------
+        struct rgba_sub_col
+        {
+            RGBA c;
+
+            explicit rgba_sub_col(RGBA color)
+                : c(color)
+            {
+            }
+
+            void operator()(RGBA* dst, const RGBA* src) {
+                dst->red   = std::max(dst->red   - (src->red   * (c.red   + 1) >> 8), 0);
+                dst->green = std::max(dst->green - (src->green * (c.green + 1) >> 8), 0);
+                dst->blue  = std::max(dst->blue  - (src->blue  * (c.blue  + 1) >> 8), 0);
+                dst->alpha = std::max(dst->alpha - (src->alpha * (c.alpha + 1) >> 8), 0);
+            }
+        };
+
+        //-----------------------------------------------------------------
+        struct rgba_mul_col
+        {
+            RGBA c;
+
+            explicit rgba_mul_col(RGBA color)
+                : c(color)
+            {
+            }
+
+            void operator()(RGBA* dst, const RGBA* src) {
+                dst->red   = dst->red   * ((src->red   * (c.red   + 1) >> 8) + 1) >> 8;
+                dst->green = dst->green * ((src->green * (c.green + 1) >> 8) + 1) >> 8;
+                dst->blue  = dst->blue  * ((src->blue  * (c.blue  + 1) >> 8) + 1) >> 8;
+                dst->alpha = dst->alpha * ((src->alpha * (c.alpha + 1) >> 8) + 1) >> 8;
+            }
+        };
+
+    } // namespace graphics
+} // namespace rpgss
+
+
+#endif // RPGSS_GRAPHICS_RENDERERS_HPP_INCLUDED
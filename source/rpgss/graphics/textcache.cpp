@@ -0,0 +1,241 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <list>
+#include <map>
+
+#include "textcache.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace textcache {
+
+            namespace {
+
+                struct Key {
+                    const Font* font;
+                    int         tabWidth;
+                    float       scale;
+                    u32         color;
+                    std::string text;
+
+                    bool operator<(const Key& that) const {
+                        if (font     != that.font)     return font     < that.font;
+                        if (tabWidth != that.tabWidth) return tabWidth < that.tabWidth;
+                        if (scale    != that.scale)    return scale    < that.scale;
+                        if (color    != that.color)    return color    < that.color;
+                        return text < that.text;
+                    }
+                };
+
+                struct Entry {
+                    Key       key;
+                    Font::Ptr font; // keeps the key's font address from being reused
+                    Run       run;
+                    int       size;
+                };
+
+                typedef std::list<Entry> EntryList;
+                typedef std::map<Key, EntryList::iterator> EntryMap;
+
+                EntryList Entries; // most recently used first
+                EntryMap  Lookup;
+                int       Budget  = 0;
+                int       Size    = 0;
+                int       Hits    = 0;
+                int       Misses  = 0;
+                bool      Filling = false;
+
+                //-----------------------------------------------------------------
+                void EvictUntil(int size)
+                {
+                    while (Size > size && !Entries.empty()) {
+                        Entry& entry = Entries.back();
+                        Size -= entry.size;
+                        Lookup.erase(entry.key);
+                        Entries.pop_back();
+                    }
+                }
+
+                //-----------------------------------------------------------------
+                bool RenderRun(const Font* font, const char* text, int len, float scale, RGBA color, Run& run)
+                {
+                    font->layoutText(core::Vec2i(0, 0), text, len, scale, run.glyphs);
+
+                    int x1 = 0;
+                    int y1 = 0;
+                    int x2 = -1;
+                    int y2 = -1;
+
+                    for (int i = 0; i < (int)run.glyphs.size(); i++) {
+                        const core::Recti& rect = run.glyphs[i].dstRect;
+                        if (rect.isEmpty()) {
+                            continue;
+                        }
+                        if (x2 < x1) {
+                            x1 = rect.ul.x;
+                            y1 = rect.ul.y;
+                            x2 = rect.lr.x;
+                            y2 = rect.lr.y;
+                        } else {
+                            x1 = std::min(x1, rect.ul.x);
+                            y1 = std::min(y1, rect.ul.y);
+                            x2 = std::max(x2, rect.lr.x);
+                            y2 = std::max(y2, rect.lr.y);
+                        }
+                    }
+
+                    if (x2 < x1) {
+                        return false;
+                    }
+
+                    run.image = Image::New(x2 - x1 + 1, y2 - y1 + 1, RGBA(0, 0, 0, 0));
+                    if (!run.image) {
+                        return false;
+                    }
+
+                    // the run replays exactly what drawText writes into the glyph rects
+                    Filling = true;
+                    run.image->drawText(font, core::Vec2i(-x1, -y1), text, len, scale, color);
+                    Filling = false;
+
+                    for (int i = 0; i < (int)run.glyphs.size(); i++) {
+                        run.glyphs[i].srcRect = run.glyphs[i].dstRect;
+                        run.glyphs[i].srcRect.translate(-x1, -y1);
+                    }
+
+                    return true;
+                }
+
+            } // anonymous namespace
+
+            //-----------------------------------------------------------------
+            void SetBudget(int bytes)
+            {
+                Budget = std::max(bytes, 0);
+                EvictUntil(Budget);
+            }
+
+            //-----------------------------------------------------------------
+            int GetBudget()
+            {
+                return Budget;
+            }
+
+            //-----------------------------------------------------------------
+            int GetSize()
+            {
+                return Size;
+            }
+
+            //-----------------------------------------------------------------
+            int GetRunCount()
+            {
+                return (int)Lookup.size();
+            }
+
+            //-----------------------------------------------------------------
+            int GetHits()
+            {
+                return Hits;
+            }
+
+            //-----------------------------------------------------------------
+            int GetMisses()
+            {
+                return Misses;
+            }
+
+            //-----------------------------------------------------------------
+            void Clear()
+            {
+                Lookup.clear();
+                Entries.clear();
+                Size   = 0;
+                Hits   = 0;
+                Misses = 0;
+            }
+
+            //-----------------------------------------------------------------
+            const Run* Get(const Font* font, const char* text, int len, float scale, RGBA color)
+            {
+                if (Budget == 0 || Filling) {
+                    return 0;
+                }
+
+                if (len < 0) {
+                    len = std::strlen(text);
+                }
+
+                Key key;
+                key.font     = font;
+                key.tabWidth = font->getTabWidth();
+                key.scale    = scale;
+                key.color    = color.toRGBA8888();
+                key.text.assign(text, len);
+
+                EntryMap::iterator it = Lookup.find(key);
+                if (it != Lookup.end()) {
+                    Hits++;
+                    Entries.splice(Entries.begin(), Entries, it->second);
+                    return &it->second->run;
+                }
+
+                Misses++;
+
+                Run run;
+                if (!RenderRun(font, text, len, scale, color, run)) {
+                    return 0;
+                }
+
+                int size = run.image->getWidth() * run.image->getHeight() * sizeof(RGBA)
+                         + run.glyphs.size() * sizeof(Font::Glyph)
+                         + key.text.size();
+
+                if (size > Budget) {
+                    return 0;
+                }
+
+                EvictUntil(Budget - size);
+
+                Entries.push_front(Entry());
+                Entry& entry = Entries.front();
+                entry.key  = key;
+                entry.font = const_cast<Font*>(font);
+                entry.run  = run;
+                entry.size = size;
+
+                Lookup[key] = Entries.begin();
+                Size += size;
+
+                return &entry.run;
+            }
+
+        } // namespace textcache
+    } // namespace graphics
+} // namespace rpgss
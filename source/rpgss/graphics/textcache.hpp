@@ -0,0 +1,67 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_GRAPHICS_TEXTCACHE_HPP_INCLUDED
+#define RPGSS_GRAPHICS_TEXTCACHE_HPP_INCLUDED
+
+#include <vector>
+
+#include "RGBA.hpp"
+#include "Image.hpp"
+#include "Font.hpp"
+
+
+namespace rpgss {
+    namespace graphics {
+        namespace textcache {
+
+            // a pre-rendered string
+            struct Run {
+                Image::Ptr               image;
+                std::vector<Font::Glyph> glyphs; // srcRect in image, dstRect relative to the text position
+            };
+
+            // 0 bytes disables the cache (the default)
+            void SetBudget(int bytes);
+            int  GetBudget();
+
+            // bytes used by the cached runs
+            int  GetSize();
+            int  GetRunCount();
+            int  GetHits();
+            int  GetMisses();
+
+            // drops all runs and resets the counters
+            void Clear();
+
+            // returns the cached run, rendering it on a miss, or 0 if
+            // the cache is disabled or the run does not fit the budget
+            const Run* Get(const Font* font, const char* text, int len, float scale, RGBA color);
+
+        } // namespace textcache
+    } // namespace graphics
+} // namespace rpgss
+
+
+#endif // RPGSS_GRAPHICS_TEXTCACHE_HPP_INCLUDED
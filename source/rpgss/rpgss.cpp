@@ -34,6 +34,7 @@
 #include "io/io.hpp"
 #include "audio/audio.hpp"
 #include "graphics/graphics.hpp"
+#include "script/game_module/Lightmap.hpp"
 #include "version.hpp"
 #include "error.hpp"
 #include "TokenParser.hpp"
@@ -188,6 +189,11 @@ void onSaveGame(int id, void __cdecl (* savePluginData)(char* data, int length))
 // Called every frame, before the screen is refreshed (see details!).
 void onFrame(RPG::Scene scene)
 {
+    // below anything the scripts draw
+    if (scene == RPG::SCENE_MAP) {
+        rpgss::script::game_module::Lightmap::Render();
+    }
+
     lua_getglobal(LUA_STATE, "onSceneDrawn");
     if (lua_isfunction(LUA_STATE, -1)) {
         // push function argument 1
@@ -483,10 +489,14 @@ void onExit()
 {
     RPGSS_DEBUG_GUARD("onExit()")
 
+    // the lightmap may hold an image of the scripts
+    rpgss::script::game_module::Lightmap::SetImage(0);
+
     // destroy context
     rpgss::Context::Close();
 
-    // shutdown subsystems
+    // shutdown subsystems, the image loader reads through the i/o subsystem
+    rpgss::graphics::DeinitGraphicsSubsystem();
     rpgss::audio::DeinitAudioSubsystem();
     rpgss::io::DeinitIoSubsystem();
 }
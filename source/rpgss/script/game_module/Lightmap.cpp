@@ -0,0 +1,261 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+
+#include <emmintrin.h>
+
+#define NOT_MAIN_MODULE
+#include <DynRPG/DynRPG.h>
+
+#include "../../common/cpuinfo.hpp"
+#include "Screen.hpp"
+#include "Lightmap.hpp"
+
+
+namespace rpgss {
+    namespace script {
+        namespace game_module {
+
+            //-----------------------------------------------------------------
+            graphics::Image::Ptr Lightmap::_image;
+            int Lightmap::_blendMode = graphics::BlendMode::Multiply;
+            int Lightmap::_opacity   = 255;
+
+            //-----------------------------------------------------------------
+            void
+            Lightmap::SetImage(graphics::Image* image)
+            {
+                _image = image;
+            }
+
+            //-----------------------------------------------------------------
+            graphics::Image*
+            Lightmap::GetImage()
+            {
+                return _image.get();
+            }
+
+            //-----------------------------------------------------------------
+            bool
+            Lightmap::SetBlendMode(int blendMode)
+            {
+                switch (blendMode) {
+                case graphics::BlendMode::Mix:
+                case graphics::BlendMode::Add:
+                case graphics::BlendMode::Multiply:
+                    _blendMode = blendMode;
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            //-----------------------------------------------------------------
+            int
+            Lightmap::GetBlendMode()
+            {
+                return _blendMode;
+            }
+
+            //-----------------------------------------------------------------
+            void
+            Lightmap::SetOpacity(int opacity)
+            {
+                _opacity = std::max(0, std::min(opacity, 255));
+            }
+
+            //-----------------------------------------------------------------
+            int
+            Lightmap::GetOpacity()
+            {
+                return _opacity;
+            }
+
+            //-----------------------------------------------------------------
+            void
+            Lightmap::Render()
+            {
+                if (!_image || _opacity == 0) {
+                    return;
+                }
+
+                int cx = RPG::map->getCameraX();
+                int cy = RPG::map->getCameraY();
+
+                // the part of the lightmap the camera shows
+                core::Recti rect = core::Recti(-cx, -cy, _image->getWidth(), _image->getHeight());
+                rect = rect.getIntersection(core::Recti(Screen::GetWidth(), Screen::GetHeight()));
+                rect = rect.getIntersection(Screen::GetClipRect());
+                if (rect.isEmpty()) {
+                    return;
+                }
+
+                const graphics::Image* image = _image.get();
+
+                int                   src_pitch  = image->getPitch();
+                const graphics::RGBA* src_pixels = image->getPixels() + (rect.getY() + cy) * src_pitch + (rect.getX() + cx);
+                int                   dst_pitch  = Screen::GetPitch();
+                u16*                  dst_pixels = Screen::GetPixels() + rect.getY() * dst_pitch + rect.getX();
+
+                // fades scale the light like they scale everything drawn on the screen
+                int brightness = Screen::ApplyBrightness(graphics::RGBA(255, 255, 255, _opacity)).red;
+                brightness += brightness >> 7;
+
+                bool sse2 = CpuSupportsSse2();
+
+                for (int y = 0; y < rect.getHeight(); y++) {
+                    if (sse2) {
+                        CompositeRow_sse2(dst_pixels + y * dst_pitch, src_pixels + y * src_pitch, rect.getWidth(), brightness);
+                    } else {
+                        CompositeRow_generic(dst_pixels + y * dst_pitch, src_pixels + y * src_pitch, rect.getWidth(), brightness);
+                    }
+                }
+            }
+
+            //-----------------------------------------------------------------
+            void
+            Lightmap::CompositeRow_generic(u16* dst, const graphics::RGBA* src, int count, int brightness)
+            {
+                // weights out of 256, premultiplied colors carry their alpha already,
+                // the brightness only scales the weight of the source colors
+                int  opacity       = ((_opacity + (_opacity >> 7)) * brightness) >> 8;
+                bool premultiplied = _image->isPremultiplied();
+
+                for (int i = 0; i < count; i++) {
+                    unsigned int c = *dst;
+                    int r = ((c >> 8) & 0xF8) | 0x07;
+                    int g = ((c >> 3) & 0xFC) | 0x03;
+                    int b = ((c << 3) & 0xF8) | 0x07;
+
+                    // the rounding of w can push premultiplied sums past 16 bits,
+                    // which the sse2 version saturates
+                    int w  = (src->alpha * (_opacity + 1)) >> 8;
+                    int dw = 256 - (w + (w >> 7));
+                    int sw = (premultiplied ? opacity : ((256 - dw) * brightness) >> 8);
+
+                    switch (_blendMode)
+                    {
+                        case graphics::BlendMode::Mix:
+                            r = std::min(r * dw + src->red   * sw, 65535) >> 8;
+                            g = std::min(g * dw + src->green * sw, 65535) >> 8;
+                            b = std::min(b * dw + src->blue  * sw, 65535) >> 8;
+                            break;
+                        case graphics::BlendMode::Add:
+                            r = std::min(r + ((src->red   * sw) >> 8), 255);
+                            g = std::min(g + ((src->green * sw) >> 8), 255);
+                            b = std::min(b + ((src->blue  * sw) >> 8), 255);
+                            break;
+                        case graphics::BlendMode::Multiply:
+                            // the light fades to white as the weight goes down
+                            r = (r * ((std::min(255 * dw + src->red   * sw, 65535) >> 8) + 1)) >> 8;
+                            g = (g * ((std::min(255 * dw + src->green * sw, 65535) >> 8) + 1)) >> 8;
+                            b = (b * ((std::min(255 * dw + src->blue  * sw, 65535) >> 8) + 1)) >> 8;
+                            break;
+                    }
+
+                    *dst = graphics::RGB565(r, g, b);
+                    dst++;
+                    src++;
+                }
+            }
+
+            //-----------------------------------------------------------------
+            void
+            Lightmap::CompositeRow_sse2(u16* dst, const graphics::RGBA* src, int count, int brightness)
+            {
+                int  opacity       = ((_opacity + (_opacity >> 7)) * brightness) >> 8;
+                bool premultiplied = _image->isPremultiplied();
+
+                __m128i m255     = _mm_set1_epi32(0x000000FF);
+                __m128i m256     = _mm_set1_epi16(256);
+                __m128i mopacity = _mm_set1_epi16(_opacity + 1);
+                __m128i msw      = _mm_set1_epi16(opacity);
+                __m128i mbright  = _mm_set1_epi16(brightness << 1);
+
+                int burst1 = count / 8;
+                int burst2 = count % 8;
+
+                for (int x = burst1; x > 0; x--) {
+                    // eight source pixels as one register per channel
+                    __m128i s0 = _mm_loadu_si128((const __m128i*)src);
+                    __m128i s1 = _mm_loadu_si128((const __m128i*)(src + 4));
+                    __m128i sr = _mm_packs_epi32(_mm_and_si128(s0, m255), _mm_and_si128(s1, m255));
+                    __m128i sg = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 8), m255), _mm_and_si128(_mm_srli_epi32(s1, 8), m255));
+                    __m128i sb = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 16), m255), _mm_and_si128(_mm_srli_epi32(s1, 16), m255));
+                    __m128i sa = _mm_packs_epi32(_mm_srli_epi32(s0, 24), _mm_srli_epi32(s1, 24));
+
+                    __m128i c = _mm_loadu_si128((const __m128i*)dst);
+                    __m128i r = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(c, 8), _mm_set1_epi16(0xF8)), _mm_set1_epi16(0x07));
+                    __m128i g = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(c, 3), _mm_set1_epi16(0xFC)), _mm_set1_epi16(0x03));
+                    __m128i b = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(c, 3), _mm_set1_epi16(0xF8)), _mm_set1_epi16(0x07));
+
+                    __m128i w  = _mm_srli_epi16(_mm_mullo_epi16(sa, mopacity), 8);
+                    __m128i tw = _mm_add_epi16(w, _mm_srli_epi16(w, 7));
+                    __m128i dw = _mm_sub_epi16(m256, tw);
+                    // (tw << 7) * (brightness << 1) >> 16 is tw * brightness >> 8 without overflow
+                    __m128i sw = (premultiplied ? msw : _mm_mulhi_epu16(_mm_slli_epi16(tw, 7), mbright));
+
+                    switch (_blendMode)
+                    {
+                        case graphics::BlendMode::Mix:
+                            r = _mm_srli_epi16(_mm_adds_epu16(_mm_mullo_epi16(r, dw), _mm_mullo_epi16(sr, sw)), 8);
+                            g = _mm_srli_epi16(_mm_adds_epu16(_mm_mullo_epi16(g, dw), _mm_mullo_epi16(sg, sw)), 8);
+                            b = _mm_srli_epi16(_mm_adds_epu16(_mm_mullo_epi16(b, dw), _mm_mullo_epi16(sb, sw)), 8);
+                            break;
+                        case graphics::BlendMode::Add:
+                            r = _mm_min_epi16(_mm_add_epi16(r, _mm_srli_epi16(_mm_mullo_epi16(sr, sw), 8)), _mm_set1_epi16(255));
+                            g = _mm_min_epi16(_mm_add_epi16(g, _mm_srli_epi16(_mm_mullo_epi16(sg, sw), 8)), _mm_set1_epi16(255));
+                            b = _mm_min_epi16(_mm_add_epi16(b, _mm_srli_epi16(_mm_mullo_epi16(sb, sw), 8)), _mm_set1_epi16(255));
+                            break;
+                        case graphics::BlendMode::Multiply:
+                        {
+                            __m128i white = _mm_mullo_epi16(_mm_set1_epi16(255), dw);
+                            __m128i one   = _mm_set1_epi16(1);
+                            __m128i lr = _mm_add_epi16(_mm_srli_epi16(_mm_adds_epu16(white, _mm_mullo_epi16(sr, sw)), 8), one);
+                            __m128i lg = _mm_add_epi16(_mm_srli_epi16(_mm_adds_epu16(white, _mm_mullo_epi16(sg, sw)), 8), one);
+                            __m128i lb = _mm_add_epi16(_mm_srli_epi16(_mm_adds_epu16(white, _mm_mullo_epi16(sb, sw)), 8), one);
+                            r = _mm_srli_epi16(_mm_mullo_epi16(r, lr), 8);
+                            g = _mm_srli_epi16(_mm_mullo_epi16(g, lg), 8);
+                            b = _mm_srli_epi16(_mm_mullo_epi16(b, lb), 8);
+                            break;
+                        }
+                    }
+
+                    c = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(r, _mm_set1_epi16(0xF8)), 8), _mm_slli_epi16(_mm_and_si128(g, _mm_set1_epi16(0xFC)), 3));
+                    c = _mm_or_si128(c, _mm_srli_epi16(b, 3));
+                    _mm_storeu_si128((__m128i*)dst, c);
+
+                    dst += 8;
+                    src += 8;
+                }
+
+                if (burst2 > 0) {
+                    CompositeRow_generic(dst, src, burst2, brightness);
+                }
+            }
+
+        } // game_module
+    } // namespace script
+} // namespace rpgss
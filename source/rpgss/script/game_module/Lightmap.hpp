@@ -0,0 +1,70 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_SCRIPT_GAME_MODULE_LIGHTMAP_HPP_INCLUDED
+#define RPGSS_SCRIPT_GAME_MODULE_LIGHTMAP_HPP_INCLUDED
+
+#include "../../common/types.hpp"
+#include "../../graphics/Image.hpp"
+
+
+namespace rpgss {
+    namespace script {
+        namespace game_module {
+
+            // an image as large as the map, blended into the part of
+            // the screen the camera shows once per frame
+            class Lightmap {
+            public:
+                // 0 removes the lightmap
+                static void SetImage(graphics::Image* image);
+                static graphics::Image* GetImage();
+
+                // mix, add or multiply
+                static bool SetBlendMode(int blendMode);
+                static int GetBlendMode();
+
+                static void SetOpacity(int opacity);
+                static int GetOpacity();
+
+                // called every frame of the map scene
+                static void Render();
+
+            private:
+                Lightmap(); // non-instantiable
+                static void CompositeRow_generic(u16* dst, const graphics::RGBA* src, int count, int brightness);
+                static void CompositeRow_sse2(u16* dst, const graphics::RGBA* src, int count, int brightness);
+
+            private:
+                static graphics::Image::Ptr _image;
+                static int _blendMode;
+                static int _opacity;
+            };
+
+        } // game_module
+    } // namespace script
+} // namespace rpgss
+
+
+#endif // RPGSS_SCRIPT_GAME_MODULE_LIGHTMAP_HPP_INCLUDED
@@ -24,6 +24,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <vector>
 
 #include <emmintrin.h>
 
@@ -32,6 +33,8 @@
 
 #include "../../common/cpuinfo.hpp"
 #include "../../graphics/primitives.hpp"
+#include "../../graphics/kernels.hpp"
+#include "../../graphics/ColorMatrix.hpp"
 #include "../../graphics/Font.hpp"
 #include "../../graphics/WindowSkin.hpp"
 #include "Screen.hpp"
@@ -166,6 +169,32 @@ namespace rpgss {
                     }
                 };
 
+                //---------------------------------------------------------
+                struct rgb565_mix_pm
+                {
+                    __attribute__((__always_inline__))
+                    void operator()(u16* dst, const graphics::RGBA* src)
+                    {
+                        int da = 256 - src->alpha;
+                        int r  = (src->red   >> 3) + ((   (*dst >> 11)         * da) >> 8);
+                        int g  = (src->green >> 2) + ((( (*dst >>  5) & 0x3F) * da) >> 8);
+                        int b  = (src->blue  >> 3) + ((  (*dst        & 0x1F) * da) >> 8);
+                        *dst = (std::min(r, 31) << 11) | (std::min(g, 63) << 5) | std::min(b, 31);
+                    }
+                };
+
+                //---------------------------------------------------------
+                struct rgb565_set_masked
+                {
+                    __attribute__((__always_inline__))
+                    void operator()(u16* dst, const graphics::RGBA* src)
+                    {
+                        if (src->alpha) {
+                            *dst = ((src->red & 0xF8) << 8) | ((src->green & 0xFC) << 3) | (src->blue >> 3);
+                        }
+                    }
+                };
+
                 //---------------------------------------------------------
                 struct rgb565_add
                 {
@@ -495,6 +524,107 @@ namespace rpgss {
                     }
                 };
 
+                //---------------------------------------------------------
+                // rgb565_mix_col over a whole span, eight pixels per step
+                // (the results are identical to rgb565_mix_col)
+                struct rgb565_mix_col_run_sse2
+                {
+                    u16 cr;
+                    u16 cg;
+                    u16 cb;
+                    u16 ca;
+
+                    explicit rgb565_mix_col_run_sse2(graphics::RGBA color)
+                    {
+                        cr = color.red   + 1;
+                        cg = color.green + 1;
+                        cb = color.blue  + 1;
+                        ca = color.alpha + 1;
+                    }
+
+                    void operator()(u16* dst, const graphics::RGBA* src, int len)
+                    {
+                        const __m128i m8  = _mm_set1_epi32(0xFF);
+                        const __m128i m5  = _mm_set1_epi16(0x1F);
+                        const __m128i m6  = _mm_set1_epi16(0x3F);
+                        const __m128i one = _mm_set1_epi16(1);
+                        const __m128i max = _mm_set1_epi16(256);
+                        const __m128i mcr = _mm_set1_epi16(cr);
+                        const __m128i mcg = _mm_set1_epi16(cg);
+                        const __m128i mcb = _mm_set1_epi16(cb);
+                        const __m128i mca = _mm_set1_epi16(ca);
+
+                        for (; len >= 8; len -= 8) {
+                            __m128i s0 = _mm_loadu_si128((const __m128i*)src);
+                            __m128i s1 = _mm_loadu_si128((const __m128i*)(src + 4));
+                            __m128i d  = _mm_loadu_si128((const __m128i*)dst);
+
+                            // unpack the source channels to 16 bits
+                            __m128i r = _mm_packs_epi32(_mm_and_si128(s0, m8), _mm_and_si128(s1, m8));
+                            __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 8), m8), _mm_and_si128(_mm_srli_epi32(s1, 8), m8));
+                            __m128i b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 16), m8), _mm_and_si128(_mm_srli_epi32(s1, 16), m8));
+                            __m128i a = _mm_packs_epi32(_mm_srli_epi32(s0, 24), _mm_srli_epi32(s1, 24));
+
+                            a = _mm_srli_epi16(_mm_mullo_epi16(a, mca), 8);
+                            __m128i sa = _mm_add_epi16(a, one);
+                            __m128i da = _mm_sub_epi16(max, a);
+
+                            // (src * c * sa) >> 19 (>> 18 for green), the product of the
+                            // first two factors always fits into 16 bits
+                            r = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(r, mcr), sa), 3);
+                            g = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(g, mcg), sa), 2);
+                            b = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(b, mcb), sa), 3);
+
+                            r = _mm_add_epi16(r, _mm_srli_epi16(_mm_mullo_epi16(_mm_srli_epi16(d, 11), da), 8));
+                            g = _mm_add_epi16(g, _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(d, 5), m6), da), 8));
+                            b = _mm_add_epi16(b, _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(d, m5), da), 8));
+
+                            d = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b);
+                            _mm_storeu_si128((__m128i*)dst, d);
+
+                            dst += 8;
+                            src += 8;
+                        }
+
+                        if (len > 0) {
+                            rgb565_mix_col tail(graphics::RGBA(cr - 1, cg - 1, cb - 1, ca - 1));
+                            for (; len > 0; len--) {
+                                tail(dst, src);
+                                dst++;
+                                src++;
+                            }
+                        }
+                    }
+                };
+
+                //---------------------------------------------------------
+                struct rgb565_mix_pm_col
+                {
+                    u32 cr;
+                    u32 cg;
+                    u32 cb;
+                    u32 ca;
+
+                    // the color's alpha scales the premultiplied color channels too
+                    explicit rgb565_mix_pm_col(graphics::RGBA color)
+                    {
+                        ca = color.alpha + 1;
+                        cr = (color.red   + 1) * ca >> 8;
+                        cg = (color.green + 1) * ca >> 8;
+                        cb = (color.blue  + 1) * ca >> 8;
+                    }
+
+                    __attribute__((__always_inline__))
+                    void operator()(u16* dst, const graphics::RGBA* src)
+                    {
+                        int da = 256 - (src->alpha * ca >> 8);
+                        int r  = ((src->red   * cr) >> 11) + ((   (*dst >> 11)         * da) >> 8);
+                        int g  = ((src->green * cg) >> 10) + ((( (*dst >>  5) & 0x3F) * da) >> 8);
+                        int b  = ((src->blue  * cb) >> 11) + ((  (*dst        & 0x1F) * da) >> 8);
+                        *dst = (std::min(r, 31) << 11) | (std::min(g, 63) << 5) | std::min(b, 31);
+                    }
+                };
+
                 //---------------------------------------------------------
                 struct rgb565_add_col
                 {
@@ -701,6 +831,111 @@ namespace rpgss {
                     }
                 };
 
+                //---------------------------------------------------------
+                // passes the scanline renderer for blendMode and color to draw,
+                // which calls one of the filtered primitives with it
+                template<typename drawT>
+                void DrawSampled(drawT& draw, const graphics::Image* image, graphics::RGBA color, int blendMode, int filter)
+                {
+                    using graphics::primitives::PixelRun;
+
+                    graphics::kernels::SampleFunc sampler = graphics::kernels::Table.sampleNearest;
+
+                    // interpolation blends the edges of binary masks
+                    int alphaClass = image->getAlphaClass();
+
+                    // straight colors are weighted by their alpha when interpolated
+                    if (filter == graphics::FilterMode::Bilinear) {
+                        if (image->isPremultiplied() || alphaClass == graphics::AlphaClass::Opaque) {
+                            sampler = graphics::kernels::Table.sampleBilinear;
+                        } else {
+                            sampler = graphics::kernels::Table.sampleBilinearStraight;
+                        }
+                    }
+
+                    if (alphaClass == graphics::AlphaClass::Binary && filter == graphics::FilterMode::Bilinear) {
+                        alphaClass = graphics::AlphaClass::Translucent;
+                    }
+
+                    if (color == graphics::RGBA(255, 255, 255, 255))
+                    {
+                        switch (blendMode) {
+                        case graphics::BlendMode::Set:      draw(sampler, PixelRun<rgb565_set>()); break;
+                        case graphics::BlendMode::Mix:
+                            if (alphaClass == graphics::AlphaClass::Opaque) {
+                                draw(sampler, PixelRun<rgb565_set>());
+                            } else if (alphaClass == graphics::AlphaClass::Binary) {
+                                draw(sampler, PixelRun<rgb565_set_masked>());
+                            } else if (image->isPremultiplied()) {
+                                draw(sampler, PixelRun<rgb565_mix_pm>());
+                            } else {
+                                draw(sampler, PixelRun<rgb565_mix>());
+                            }
+                            break;
+                        case graphics::BlendMode::Add:      draw(sampler, PixelRun<rgb565_add>()); break;
+                        case graphics::BlendMode::Subtract: draw(sampler, PixelRun<rgb565_sub>()); break;
+                        case graphics::BlendMode::Multiply: draw(sampler, PixelRun<rgb565_mul>()); break;
+                        }
+                    }
+                    else
+                    {
+                        switch (blendMode) {
+                        case graphics::BlendMode::Set:      draw(sampler, PixelRun<rgb565_set_col>(rgb565_set_col(color))); break;
+                        case graphics::BlendMode::Mix:
+                            if (image->isPremultiplied()) {
+                                draw(sampler, PixelRun<rgb565_mix_pm_col>(rgb565_mix_pm_col(color)));
+                            } else {
+                                draw(sampler, PixelRun<rgb565_mix_col>(rgb565_mix_col(color)));
+                            }
+                            break;
+                        case graphics::BlendMode::Add:      draw(sampler, PixelRun<rgb565_add_col>(rgb565_add_col(color))); break;
+                        case graphics::BlendMode::Subtract: draw(sampler, PixelRun<rgb565_sub_col>(rgb565_sub_col(color))); break;
+                        case graphics::BlendMode::Multiply: draw(sampler, PixelRun<rgb565_mul_col>(rgb565_mul_col(color))); break;
+                        }
+                    }
+                }
+
+                //---------------------------------------------------------
+                struct DrawFilteredRectangle
+                {
+                    u16*                  pixels;
+                    int                   pitch;
+                    core::Recti           clipRect;
+                    core::Recti           rect;
+                    float                 angle;
+                    const graphics::RGBA* srcPixels;
+                    int                   srcPitch;
+                    core::Recti           srcRect;
+
+                    template<typename samplerT, typename spanT>
+                    void operator()(samplerT sampler, spanT spanRenderer)
+                    {
+                        if (angle == 0.0) {
+                            graphics::primitives::FilteredRectangle(pixels, pitch, clipRect, rect, srcPixels, srcPitch, srcRect, sampler, spanRenderer);
+                        } else {
+                            graphics::primitives::TransformedRectangle(pixels, pitch, clipRect, rect, angle, srcPixels, srcPitch, srcRect, sampler, spanRenderer);
+                        }
+                    }
+                };
+
+                //---------------------------------------------------------
+                struct DrawFilteredQuad
+                {
+                    u16*                  pixels;
+                    int                   pitch;
+                    core::Recti           clipRect;
+                    core::Vec2i*          pos;
+                    const graphics::RGBA* srcPixels;
+                    int                   srcPitch;
+                    core::Recti           srcRect;
+
+                    template<typename samplerT, typename spanT>
+                    void operator()(samplerT sampler, spanT spanRenderer)
+                    {
+                        graphics::primitives::FilteredQuad(pixels, pitch, clipRect, pos, srcPixels, srcPitch, srcRect, sampler, spanRenderer);
+                    }
+                };
+
             }
 
             //---------------------------------------------------------
@@ -794,12 +1029,15 @@ namespace rpgss {
 
                 if (destination) {
                     result = destination;
-                    result->resize(w, h);
+                    if (!result->resize(w, h)) {
+                        return 0;
+                    }
                 } else {
                     result = graphics::Image::New(w, h);
                 }
 
-                graphics::RGBA* dst = result->getPixels();
+                int             dst_pitch = result->getPitch();
+                graphics::RGBA* dst       = result->getPixels();
 
                 int  src_pitch = GetPitch();
                 u16* src       = GetPixels() + src_pitch * y + x;
@@ -811,6 +1049,7 @@ namespace rpgss {
                         dst++;
                     }
                     src += src_pitch - w;
+                    dst += dst_pitch - w;
                 }
 
                 return result;
@@ -874,7 +1113,7 @@ namespace rpgss {
 
             //-----------------------------------------------------------------
             void
-            Screen::Grey()
+            Screen::Grey_generic()
             {
                 int  dst_pitch  = GetPitch();
                 u16* dst_pixels = GetPixels();
@@ -893,6 +1132,83 @@ namespace rpgss {
                 }
             }
 
+            //-----------------------------------------------------------------
+            void
+            Screen::Grey_sse2()
+            {
+                u16* dp = GetPixels();
+                int  di = GetPitch() - GetWidth();
+
+                int burst1 = GetWidth() / 8;
+                int burst2 = GetWidth() % 8;
+
+                __m128i m31    = _mm_set1_epi16(0x001F);
+                __m128i mthird = _mm_set1_epi16(21846); // (sum * 21846) >> 16 equals sum / 3 here
+                __m128i mone   = _mm_set1_epi16(0x0001);
+
+                for (int y = GetHeight(); y > 0; y--) {
+                    for (int x = burst1; x > 0; x--) {
+                        __m128i mc = _mm_loadu_si128((const __m128i*)dp);
+                        __m128i ms = _mm_add_epi16(_mm_srli_epi16(mc, 11), _mm_and_si128(_mm_srli_epi16(mc, 6), m31));
+                        ms = _mm_add_epi16(ms, _mm_and_si128(mc, m31));
+                        __m128i mg = _mm_mulhi_epu16(ms, mthird);
+                        mg = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(mg, 11), _mm_slli_epi16(mg, 6)), _mm_or_si128(mg, mone));
+                        _mm_storeu_si128((__m128i*)dp, mg);
+                        dp += 8;
+                    }
+                    for (int x = burst2; x > 0; x--) {
+                        unsigned int c = *dp;
+                        unsigned int g = ((c >> 11) + ((c >> 6) & 0x001F) + (c & 0x001F)) / 3;
+                        *dp = (g << 11) | ((g << 6) | 0x01)  | g;
+                        dp++;
+                    }
+                    dp += di;
+                }
+            }
+
+            //-----------------------------------------------------------------
+            void
+            Screen::Grey()
+            {
+                if (CpuSupportsSse2()) {
+                    Grey_sse2();
+                } else {
+                    Grey_generic();
+                }
+            }
+
+            //-----------------------------------------------------------------
+            void
+            Screen::ApplyColorMatrix(const graphics::ColorMatrix& matrix)
+            {
+                if (_clipRect.isEmpty() || matrix.isIdentity()) {
+                    return;
+                }
+
+                int fixed[20];
+                matrix.toFixed(fixed);
+
+                int  dst_pitch  = GetPitch();
+                u16* dst_pixels = GetPixels() + _clipRect.ul.y * dst_pitch + _clipRect.ul.x;
+
+                int w = _clipRect.getWidth();
+                int h = _clipRect.getHeight();
+
+                // each row goes through the image kernel and back
+                std::vector<graphics::RGBA> row(w);
+
+                for (int y = 0; y < h; y++) {
+                    u16* dst = dst_pixels + dst_pitch * y;
+                    for (int x = 0; x < w; x++) {
+                        row[x] = graphics::RGB565ToRGBA(dst[x]);
+                    }
+                    graphics::kernels::Table.colorMatrix(&row[0], w, w, 1, fixed);
+                    for (int x = 0; x < w; x++) {
+                        dst[x] = graphics::RGBAToRGB565(row[x]);
+                    }
+                }
+            }
+
             //-----------------------------------------------------------------
             void
             Screen::DrawPoint(const core::Vec2i& pos, graphics::RGBA color, int blendMode)
@@ -962,87 +1278,192 @@ namespace rpgss {
             void
             Screen::DrawTriangle(bool fill, const core::Vec2i& p1, const core::Vec2i& p2, const core::Vec2i& p3, graphics::RGBA c1, graphics::RGBA c2, graphics::RGBA c3, int blendMode)
             {
+                if (!fill) {
+                    DrawLine(p1, p2, c1, c2, blendMode);
+                    DrawLine(p2, p3, c2, c3, blendMode);
+                    DrawLine(p3, p1, c3, c1, blendMode);
+                    return;
+                }
+
                 c1 = ApplyBrightness(c1);
                 c2 = ApplyBrightness(c2);
                 c3 = ApplyBrightness(c3);
 
-                // TODO
+                core::Vec2i    vertices[3] = { p1, p2, p3 };
+                graphics::RGBA colors[3]   = { c1, c2, c3 };
+
+                switch (blendMode) {
+                case graphics::BlendMode::Set:      graphics::primitives::Triangle(GetPixels(), GetPitch(), _clipRect, vertices, colors, graphics::primitives::PixelRun<rgb565_set>()); break;
+                case graphics::BlendMode::Mix:      graphics::primitives::Triangle(GetPixels(), GetPitch(), _clipRect, vertices, colors, graphics::primitives::PixelRun<rgb565_mix>()); break;
+                case graphics::BlendMode::Add:      graphics::primitives::Triangle(GetPixels(), GetPitch(), _clipRect, vertices, colors, graphics::primitives::PixelRun<rgb565_add>()); break;
+                case graphics::BlendMode::Subtract: graphics::primitives::Triangle(GetPixels(), GetPitch(), _clipRect, vertices, colors, graphics::primitives::PixelRun<rgb565_sub>()); break;
+                case graphics::BlendMode::Multiply: graphics::primitives::Triangle(GetPixels(), GetPitch(), _clipRect, vertices, colors, graphics::primitives::PixelRun<rgb565_mul>()); break;
+                }
             }
 
             //-----------------------------------------------------------------
             void
-            Screen::Draw(const graphics::Image* image, const core::Recti& image_rect, const core::Vec2i& pos, float angle, float scale, graphics::RGBA color, int blendMode)
+            Screen::Draw(const graphics::Image* image, const core::Recti& image_rect, const core::Vec2i& pos, float angle, float scale, graphics::RGBA color, int blendMode, int filter)
             {
                 color = ApplyBrightness(color);
 
-                if (angle == 0.0)
+                const graphics::SpanTable* spans = image->getSpanTable();
+
+                // opaque images take the textured rectangle path below, which
+                // copies them without blending
+                if (angle == 0.0 && scale == 1.0 && blendMode == graphics::BlendMode::Mix && spans &&
+                    (image->getAlphaClass() != graphics::AlphaClass::Opaque || color != graphics::RGBA(255, 255, 255, 255)))
+                {
+                    // transparent runs are skipped, opaque runs can be converted directly
+                    // unless they are modulated by a color
+                    if (color == graphics::RGBA(255, 255, 255, 255))
+                    {
+                        if (image->isPremultiplied()) {
+                            graphics::primitives::SpannedRectangle(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, *spans, graphics::primitives::PixelRun<rgb565_set>(), graphics::primitives::PixelRun<rgb565_mix_pm>());
+                        } else {
+                            graphics::primitives::SpannedRectangle(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, *spans, graphics::primitives::PixelRun<rgb565_set>(), graphics::primitives::PixelRun<rgb565_mix>());
+                        }
+                    }
+                    else
+                    {
+                        if (image->isPremultiplied()) {
+                            graphics::primitives::PixelRun<rgb565_mix_pm_col> blender((rgb565_mix_pm_col(color)));
+                            graphics::primitives::SpannedRectangle(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, *spans, blender, blender);
+                        } else {
+                            graphics::primitives::PixelRun<rgb565_mix_col> blender((rgb565_mix_col(color)));
+                            graphics::primitives::SpannedRectangle(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, *spans, blender, blender);
+                        }
+                    }
+                }
+                else if (angle == 0.0 && (scale == 1.0 || filter == graphics::FilterMode::Nearest))
                 {
                     core::Recti rect = core::Recti(pos, image_rect.getDimensions()).scale(scale);
 
                     if (color == graphics::RGBA(255, 255, 255, 255))
                     {
                         switch (blendMode) {
-                        case graphics::BlendMode::Set:      graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgb565_set()); break;
-                        case graphics::BlendMode::Mix:      graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgb565_mix()); break;
-                        case graphics::BlendMode::Add:      graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgb565_add()); break;
-                        case graphics::BlendMode::Subtract: graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgb565_sub()); break;
-                        case graphics::BlendMode::Multiply: graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgb565_mul()); break;
+                        case graphics::BlendMode::Set:      graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_set()); break;
+                        case graphics::BlendMode::Mix:
+                            if (image->getAlphaClass() == graphics::AlphaClass::Opaque) {
+                                graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_set());
+                            } else if (image->getAlphaClass() == graphics::AlphaClass::Binary) {
+                                graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_set_masked());
+                            } else if (image->isPremultiplied()) {
+                                graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_mix_pm());
+                            } else {
+                                graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_mix());
+                            }
+                            break;
+                        case graphics::BlendMode::Add:      graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_add()); break;
+                        case graphics::BlendMode::Subtract: graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_sub()); break;
+                        case graphics::BlendMode::Multiply: graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_mul()); break;
                         }
                     }
                     else
                     {
                         switch (blendMode) {
-                        case graphics::BlendMode::Set:      graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgb565_set_col(color)); break;
-                        case graphics::BlendMode::Mix:      graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgb565_mix_col(color)); break;
-                        case graphics::BlendMode::Add:      graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgb565_add_col(color)); break;
-                        case graphics::BlendMode::Subtract: graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgb565_sub_col(color)); break;
-                        case graphics::BlendMode::Multiply: graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getWidth(), image_rect, rgb565_mul_col(color)); break;
+                        case graphics::BlendMode::Set:      graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_set_col(color)); break;
+                        case graphics::BlendMode::Mix:
+                            if (image->isPremultiplied()) {
+                                graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_mix_pm_col(color));
+                            } else {
+                                graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_mix_col(color));
+                            }
+                            break;
+                        case graphics::BlendMode::Add:      graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_add_col(color)); break;
+                        case graphics::BlendMode::Subtract: graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_sub_col(color)); break;
+                        case graphics::BlendMode::Multiply: graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, rect, image->getPixels(), image->getPitch(), image_rect, rgb565_mul_col(color)); break;
                         }
                     }
                 }
                 else
                 {
-                    core::Recti rect = core::Recti(pos, image_rect.getDimensions()).scale(scale);
-                    core::Vec2i center = rect.getCenter();
+                    DrawFilteredRectangle draw = {
+                        GetPixels(),
+                        GetPitch(),
+                        _clipRect,
+                        core::Recti(pos, image_rect.getDimensions()).scale(scale),
+                        angle,
+                        image->getPixels(),
+                        image->getPitch(),
+                        image_rect
+                    };
+
+                    DrawSampled(draw, image, color, blendMode, filter);
+                }
+            }
+
+            //-----------------------------------------------------------------
+            void
+            Screen::DrawBatch(const graphics::Image* image, const graphics::DrawBatchItem* items, int count, int blendMode, int filter)
+            {
+                for (int i = 0; i < count; i++) {
+                    const graphics::DrawBatchItem& item = items[i];
 
-                    core::Vec2i ul = rect.getUpperLeft().rotateBy(angle, center);
-                    core::Vec2i ur = rect.getUpperRight().rotateBy(angle, center);
-                    core::Vec2i lr = rect.getLowerRight().rotateBy(angle, center);
-                    core::Vec2i ll = rect.getLowerLeft().rotateBy(angle, center);
+                    // skip sprites that are not entirely inside the source image
+                    if (item.srcRect.isEmpty() || !item.srcRect.isInside(0, 0, image->getWidth(), image->getHeight())) {
+                        continue;
+                    }
 
-                    Drawq(image, image_rect, ul, ur, lr, ll, color, blendMode);
+                    Draw(image, item.srcRect, item.pos, item.angle, item.scale, item.color, blendMode, filter);
                 }
             }
 
             //-----------------------------------------------------------------
             void
-            Screen::Drawq(const graphics::Image* image, const core::Recti& image_rect, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, graphics::RGBA color, int blendMode)
+            Screen::Drawq(const graphics::Image* image, const core::Recti& image_rect, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, graphics::RGBA color, int blendMode, int filter)
             {
                 color = ApplyBrightness(color);
                 core::Vec2i pos[4] = { ul, ur, lr, ll };
 
-                // graphics::primitives::TexturedQuad doesn't support yet arbitrary
-                // source rects directly, so we need this fix here for the time being
-                const graphics::RGBA* image_pixels = image->getPixels() + image_rect.getY() * image->getWidth() + image_rect.getX();
+                if (filter == graphics::FilterMode::Bilinear)
+                {
+                    DrawFilteredQuad draw = {
+                        GetPixels(),
+                        GetPitch(),
+                        _clipRect,
+                        pos,
+                        image->getPixels(),
+                        image->getPitch(),
+                        image_rect
+                    };
 
-                if (color == graphics::RGBA(255, 255, 255, 255))
+                    DrawSampled(draw, image, color, blendMode, filter);
+                }
+                else if (color == graphics::RGBA(255, 255, 255, 255))
                 {
                     switch (blendMode) {
-                    case graphics::BlendMode::Set:      graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image_pixels, image->getWidth(), image_rect, rgb565_set()); break;
-                    case graphics::BlendMode::Mix:      graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image_pixels, image->getWidth(), image_rect, rgb565_mix()); break;
-                    case graphics::BlendMode::Add:      graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image_pixels, image->getWidth(), image_rect, rgb565_add()); break;
-                    case graphics::BlendMode::Subtract: graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image_pixels, image->getWidth(), image_rect, rgb565_sub()); break;
-                    case graphics::BlendMode::Multiply: graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image_pixels, image->getWidth(), image_rect, rgb565_mul()); break;
+                    case graphics::BlendMode::Set:      graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_set()); break;
+                    case graphics::BlendMode::Mix:
+                        if (image->getAlphaClass() == graphics::AlphaClass::Opaque) {
+                            graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_set());
+                        } else if (image->getAlphaClass() == graphics::AlphaClass::Binary) {
+                            graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_set_masked());
+                        } else if (image->isPremultiplied()) {
+                            graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_mix_pm());
+                        } else {
+                            graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_mix());
+                        }
+                        break;
+                    case graphics::BlendMode::Add:      graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_add()); break;
+                    case graphics::BlendMode::Subtract: graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_sub()); break;
+                    case graphics::BlendMode::Multiply: graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_mul()); break;
                     }
                 }
                 else
                 {
                     switch (blendMode) {
-                    case graphics::BlendMode::Set:      graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image_pixels, image->getWidth(), image_rect, rgb565_set_col(color)); break;
-                    case graphics::BlendMode::Mix:      graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image_pixels, image->getWidth(), image_rect, rgb565_mix_col(color)); break;
-                    case graphics::BlendMode::Add:      graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image_pixels, image->getWidth(), image_rect, rgb565_add_col(color)); break;
-                    case graphics::BlendMode::Subtract: graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image_pixels, image->getWidth(), image_rect, rgb565_sub_col(color)); break;
-                    case graphics::BlendMode::Multiply: graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image_pixels, image->getWidth(), image_rect, rgb565_mul_col(color)); break;
+                    case graphics::BlendMode::Set:      graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_set_col(color)); break;
+                    case graphics::BlendMode::Mix:
+                        if (image->isPremultiplied()) {
+                            graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_mix_pm_col(color));
+                        } else {
+                            graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_mix_col(color));
+                        }
+                        break;
+                    case graphics::BlendMode::Add:      graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_add_col(color)); break;
+                    case graphics::BlendMode::Subtract: graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_sub_col(color)); break;
+                    case graphics::BlendMode::Multiply: graphics::primitives::TexturedQuad(GetPixels(), GetPitch(), _clipRect, pos, image->getPixels(), image->getPitch(), image_rect, rgb565_mul_col(color)); break;
                     }
                 }
             }
@@ -1056,74 +1477,33 @@ namespace rpgss {
 
                 color = ApplyBrightness(color);
 
-                if (len < 0) {
-                    len = std::strlen(text);
+                std::vector<graphics::Font::Glyph> glyphs;
+                font->layoutText(pos, text, len, scale, glyphs);
+
+                if (glyphs.empty()) {
+                    return;
                 }
 
-                int cur_x = pos.x;
-                int cur_y = pos.y;
+                const graphics::Image* glyph_image = font->getGlyphImage();
 
-                for (int i = 0; i < len; i++)
+                if (scale == 1.0)
                 {
-                    switch (text[i])
-                    {
-                        case ' ':
-                        {
-                            const graphics::Image* space_char_image = font->getCharImage(' ');
-                            int space_w = (int)(space_char_image ? space_char_image->getWidth() * scale : 0);
-                            cur_x += space_w;
-                            break;
-                        }
-                        case '\t':
-                        {
-                            const graphics::Image* space_char_image = font->getCharImage(' ');
-                            int tab_w = (int)(space_char_image ? space_char_image->getWidth() * font->getTabWidth() * scale : 0);
-                            if (tab_w > 0) {
-                                tab_w = tab_w - ((cur_x - pos.x) % tab_w);
-                            }
-                            cur_x += tab_w;
-                            break;
-                        }
-                        case '\n':
-                        {
-                            cur_x = pos.x;
-                            cur_y += (int)(font->getMaxCharHeight() * scale);
-                            break;
-                        }
-                        default:
-                        {
-                            const graphics::Image* char_image = font->getCharImage(text[i]);
-                            if (char_image)
-                            {
-                                if (color == graphics::RGBA(255, 255, 255, 255))
-                                {
-                                    graphics::primitives::TexturedRectangle(
-                                        GetPixels(),
-                                        GetPitch(),
-                                        _clipRect,
-                                        core::Recti(cur_x, cur_y, char_image->getWidth(), char_image->getHeight()).scale(scale),
-                                        char_image->getPixels(),
-                                        char_image->getWidth(),
-                                        core::Recti(0, 0, char_image->getWidth(), char_image->getHeight()),
-                                        rgb565_mix()
-                                    );
-                                }
-                                else
-                                {
-                                    graphics::primitives::TexturedRectangle(
-                                        GetPixels(),
-                                        GetPitch(),
-                                        _clipRect,
-                                        core::Recti(cur_x, cur_y, char_image->getWidth(), char_image->getHeight()).scale(scale),
-                                        char_image->getPixels(),
-                                        char_image->getWidth(),
-                                        core::Recti(0, 0, char_image->getWidth(), char_image->getHeight()),
-                                        rgb565_mix_col(color)
-                                    );
-                                }
-                                cur_x += (int)(char_image->getWidth() * scale);
-                            }
-                            break;
+                    // the whole string in one pass
+                    if (CpuSupportsSse2()) {
+                        graphics::primitives::GlyphRun(GetPixels(), GetPitch(), _clipRect, glyph_image->getPixels(), glyph_image->getPitch(), &glyphs[0], (int)glyphs.size(), rgb565_mix_col_run_sse2(color));
+                    } else if (color == graphics::RGBA(255, 255, 255, 255)) {
+                        graphics::primitives::GlyphRun(GetPixels(), GetPitch(), _clipRect, glyph_image->getPixels(), glyph_image->getPitch(), &glyphs[0], (int)glyphs.size(), graphics::primitives::PixelRun<rgb565_mix>());
+                    } else {
+                        graphics::primitives::GlyphRun(GetPixels(), GetPitch(), _clipRect, glyph_image->getPixels(), glyph_image->getPitch(), &glyphs[0], (int)glyphs.size(), graphics::primitives::PixelRun<rgb565_mix_col>(rgb565_mix_col(color)));
+                    }
+                }
+                else
+                {
+                    for (int i = 0; i < (int)glyphs.size(); i++) {
+                        if (color == graphics::RGBA(255, 255, 255, 255)) {
+                            graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, glyphs[i].dstRect, glyph_image->getPixels(), glyph_image->getPitch(), glyphs[i].srcRect, rgb565_mix());
+                        } else {
+                            graphics::primitives::TexturedRectangle(GetPixels(), GetPitch(), _clipRect, glyphs[i].dstRect, glyph_image->getPixels(), glyph_image->getPitch(), glyphs[i].srcRect, rgb565_mix_col(color));
                         }
                     }
                 }
@@ -1180,7 +1560,7 @@ namespace rpgss {
                     _clipRect,
                     core::Vec2i(x1 - tlBorder->getWidth(), y1 - tlBorder->getHeight()),
                     tlBorder->getPixels(),
-                    tlBorder->getWidth(),
+                    tlBorder->getPitch(),
                     core::Recti(tlBorder->getDimensions()),
                     rgb565_mix_col(color)
                 );
@@ -1192,7 +1572,7 @@ namespace rpgss {
                     _clipRect,
                     core::Vec2i(x2 + 1, y1 - trBorder->getHeight()),
                     trBorder->getPixels(),
-                    trBorder->getWidth(),
+                    trBorder->getPitch(),
                     core::Recti(trBorder->getDimensions()),
                     rgb565_mix_col(color)
                 );
@@ -1204,7 +1584,7 @@ namespace rpgss {
                     _clipRect,
                     core::Vec2i(x2 + 1, y2 + 1 ),
                     brBorder->getPixels(),
-                    brBorder->getWidth(),
+                    brBorder->getPitch(),
                     core::Recti(brBorder->getDimensions()),
                     rgb565_mix_col(color)
                 );
@@ -1216,7 +1596,7 @@ namespace rpgss {
                     _clipRect,
                     core::Vec2i(x1 - blBorder->getWidth(), y2 + 1 ),
                     blBorder->getPixels(),
-                    blBorder->getWidth(),
+                    blBorder->getPitch(),
                     core::Recti(blBorder->getDimensions()),
                     rgb565_mix_col(color)
                 );
@@ -1238,7 +1618,7 @@ namespace rpgss {
                             _clipRect,
                             core::Vec2i(i, y1 - tBorder->getHeight()),
                             tBorder->getPixels(),
-                            tBorder->getWidth(),
+                            tBorder->getPitch(),
                             core::Recti(tBorder->getDimensions()),
                             rgb565_mix_col(color)
                         );
@@ -1253,7 +1633,7 @@ namespace rpgss {
                             _clipRect,
                             core::Vec2i(i, y1 - tBorder->getHeight()),
                             tBorder->getPixels(),
-                            tBorder->getWidth(),
+                            tBorder->getPitch(),
                             core::Recti(0, 0, (x2 - i) + 1, tBorder->getHeight()),
                             rgb565_mix_col(color)
                         );
@@ -1268,7 +1648,7 @@ namespace rpgss {
                             _clipRect,
                             core::Vec2i(i, y2 + 1),
                             bBorder->getPixels(),
-                            bBorder->getWidth(),
+                            bBorder->getPitch(),
                             core::Recti(bBorder->getDimensions()),
                             rgb565_mix_col(color)
                         );
@@ -1283,7 +1663,7 @@ namespace rpgss {
                             _clipRect,
                             core::Vec2i(i, y2 + 1),
                             bBorder->getPixels(),
-                            bBorder->getWidth(),
+                            bBorder->getPitch(),
                             core::Recti(0, 0, (x2 - i) + 1, bBorder->getHeight()),
                             rgb565_mix_col(color)
                         );
@@ -1307,7 +1687,7 @@ namespace rpgss {
                             _clipRect,
                             core::Vec2i(x1 - lBorder->getWidth(), i),
                             lBorder->getPixels(),
-                            lBorder->getWidth(),
+                            lBorder->getPitch(),
                             core::Recti(lBorder->getDimensions()),
                             rgb565_mix_col(color)
                         );
@@ -1322,7 +1702,7 @@ namespace rpgss {
                             _clipRect,
                             core::Vec2i(x1 - lBorder->getWidth(), i),
                             lBorder->getPixels(),
-                            lBorder->getWidth(),
+                            lBorder->getPitch(),
                             core::Recti(0, 0, lBorder->getWidth(), (y2 - i) + 1),
                             rgb565_mix_col(color)
                         );
@@ -1337,7 +1717,7 @@ namespace rpgss {
                             _clipRect,
                             core::Vec2i(x2 + 1, i),
                             rBorder->getPixels(),
-                            rBorder->getWidth(),
+                            rBorder->getPitch(),
                             core::Recti(rBorder->getDimensions()),
                             rgb565_mix_col(color)
                         );
@@ -1352,7 +1732,7 @@ namespace rpgss {
                             _clipRect,
                             core::Vec2i(x2 + 1, i),
                             rBorder->getPixels(),
-                            rBorder->getWidth(),
+                            rBorder->getPitch(),
                             core::Recti(0, 0, rBorder->getWidth(), (y2 - i) + 1),
                             rgb565_mix_col(color)
                         );
@@ -51,14 +51,16 @@ namespace rpgss {
                 static graphics::Image::Ptr CopyRect(const core::Recti& rect, graphics::Image* destination = 0);
                 static void Clear(graphics::RGBA color = graphics::RGBA(0, 0, 0));
                 static void Grey();
+                static void ApplyColorMatrix(const graphics::ColorMatrix& matrix);
 
                 static void DrawPoint(const core::Vec2i& pos, graphics::RGBA color, int blendMode = graphics::BlendMode::Mix);
                 static void DrawLine(const core::Vec2i& p1, const core::Vec2i& p2, graphics::RGBA c1, graphics::RGBA c2, int blendMode = graphics::BlendMode::Mix);
                 static void DrawRectangle(bool fill, const core::Recti& rect, graphics::RGBA c1, graphics::RGBA c2, graphics::RGBA c3, graphics::RGBA c4, int blendMode = graphics::BlendMode::Mix);
                 static void DrawCircle(bool fill, const core::Vec2i& center, int radius, graphics::RGBA c1, graphics::RGBA c2, int blendMode = graphics::BlendMode::Mix);
                 static void DrawTriangle(bool fill, const core::Vec2i& p1, const core::Vec2i& p2, const core::Vec2i& p3, graphics::RGBA c1, graphics::RGBA c2, graphics::RGBA c3, int blendMode = graphics::BlendMode::Mix);
-                static void Draw(const graphics::Image* image, const core::Recti& image_rect, const core::Vec2i& pos, float angle = 0.0, float scale = 1.0, graphics::RGBA color = graphics::RGBA(255, 255, 255, 255), int blendMode = graphics::BlendMode::Mix);
-                static void Drawq(const graphics::Image* image, const core::Recti& image_rect, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, graphics::RGBA color = graphics::RGBA(255, 255, 255, 255), int blendMode = graphics::BlendMode::Mix);
+                static void Draw(const graphics::Image* image, const core::Recti& image_rect, const core::Vec2i& pos, float angle = 0.0, float scale = 1.0, graphics::RGBA color = graphics::RGBA(255, 255, 255, 255), int blendMode = graphics::BlendMode::Mix, int filter = graphics::FilterMode::Nearest);
+                static void DrawBatch(const graphics::Image* image, const graphics::DrawBatchItem* items, int count, int blendMode = graphics::BlendMode::Mix, int filter = graphics::FilterMode::Nearest);
+                static void Drawq(const graphics::Image* image, const core::Recti& image_rect, const core::Vec2i& ul, const core::Vec2i& ur, const core::Vec2i& lr, const core::Vec2i& ll, graphics::RGBA color = graphics::RGBA(255, 255, 255, 255), int blendMode = graphics::BlendMode::Mix, int filter = graphics::FilterMode::Nearest);
                 static void DrawText(const graphics::Font* font, core::Vec2i pos, const char* text, int len = -1, float scale = 1.0, graphics::RGBA color = graphics::RGBA(255, 255, 255, 255));
                 static void DrawWindow(const graphics::WindowSkin* windowSkin, core::Recti windowRect);
 
@@ -66,6 +68,8 @@ namespace rpgss {
                 Screen(); // non-instantiable
                 static void Clear_generic(graphics::RGBA color);
                 static void Clear_sse2(graphics::RGBA color);
+                static void Grey_generic();
+                static void Grey_sse2();
 
             private:
                 static core::Recti _clipRect;
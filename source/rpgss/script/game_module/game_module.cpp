@@ -33,6 +33,7 @@
 #include "../core_module/core_module.hpp"
 #include "../graphics_module/graphics_module.hpp"
 #include "Screen.hpp"
+#include "Lightmap.hpp"
 #include "game_module.hpp"
 
 #define RPGSS_SANE_SWITCH_ARRAY_SIZE_LIMIT   999999
@@ -910,6 +911,41 @@ namespace rpgss {
                 return 0;
             }
 
+            //---------------------------------------------------------
+            int game_screen_applyColorMatrix(lua_State* L)
+            {
+                Screen::ApplyColorMatrix(graphics_module::GetColorMatrix(L, 1));
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int game_screen_tone(lua_State* L)
+            {
+                int red   = luaL_checkint(L, 1);
+                int green = luaL_checkint(L, 2);
+                int blue  = luaL_checkint(L, 3);
+                int grey  = luaL_optint(L, 4, 0);
+
+                Screen::ApplyColorMatrix(graphics::ColorMatrix::Tone(red, green, blue, grey));
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int game_screen_saturate(lua_State* L)
+            {
+                float saturation = luaL_checknumber(L, 1);
+                Screen::ApplyColorMatrix(graphics::ColorMatrix::Saturation(saturation));
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int game_screen_rotateHue(lua_State* L)
+            {
+                float angle = luaL_checknumber(L, 1);
+                Screen::ApplyColorMatrix(graphics::ColorMatrix::HueRotation(angle));
+                return 0;
+            }
+
             //---------------------------------------------------------
             int game_screen_getPixel(lua_State* L)
             {
@@ -1052,7 +1088,6 @@ namespace rpgss {
             //---------------------------------------------------------
             int game_screen_drawTriangle(lua_State* L)
             {
-                /*
                 bool fill = lua_toboolean(L, 1);
                 int    x1 = luaL_checkint(L, 2);
                 int    y1 = luaL_checkint(L, 3);
@@ -1060,18 +1095,26 @@ namespace rpgss {
                 int    y2 = luaL_checkint(L, 5);
                 int    x3 = luaL_checkint(L, 6);
                 int    y3 = luaL_checkint(L, 7);
-                u32    c1 = luaL_checkunsigned(L, 8);
-                u32    c2 = luaL_optunsigned(L, 9, c1);
-                u32    c3 = luaL_optunsigned(L, 10, c1);
+                u32    c1 = luaL_checkint(L, 8);
+                u32    c2 = luaL_optint(L, 9, c1);
+                u32    c3 = luaL_optint(L, 10, c1);
 
                 int blend_mode;
                 const char* blend_mode_str = luaL_optstring(L, 11, "mix");
                 if (!graphics_module::GetBlendModeConstant(blend_mode_str, blend_mode)) {
                     return luaL_argerror(L, 11, "invalid blend mode constant");
                 }
-                */
 
-                // TODO
+                Screen::DrawTriangle(
+                    fill,
+                    core::Vec2i(x1, y1),
+                    core::Vec2i(x2, y2),
+                    core::Vec2i(x3, y3),
+                    graphics::RGBA8888ToRGBA(c1),
+                    graphics::RGBA8888ToRGBA(c2),
+                    graphics::RGBA8888ToRGBA(c3),
+                    blend_mode
+                );
 
                 return 0;
             }
@@ -1086,6 +1129,7 @@ namespace rpgss {
                 float scale;
                 u32   color;
                 int blend_mode;
+                int filter;
 
                 int nargs = lua_gettop(L);
                 if (nargs >= 7 && lua_type(L, 7) == LUA_TNUMBER)
@@ -1105,6 +1149,11 @@ namespace rpgss {
                     if (!graphics_module::GetBlendModeConstant(blend_mode_str, blend_mode)) {
                         return luaL_argerror(L, 11, "invalid blend mode constant");
                     }
+
+                    const char* filter_str = luaL_optstring(L, 12, "nearest");
+                    if (!graphics_module::GetFilterModeConstant(filter_str, filter)) {
+                        return luaL_argerror(L, 12, "invalid filter mode constant");
+                    }
                 }
                 else
                 {
@@ -1120,6 +1169,11 @@ namespace rpgss {
                         return luaL_argerror(L, 7, "invalid blend mode constant");
                     }
 
+                    const char* filter_str = luaL_optstring(L, 8, "nearest");
+                    if (!graphics_module::GetFilterModeConstant(filter_str, filter)) {
+                        return luaL_argerror(L, 8, "invalid filter mode constant");
+                    }
+
                     sx = 0;
                     sy = 0;
                     sw = that->getWidth();
@@ -1133,7 +1187,8 @@ namespace rpgss {
                     angle,
                     scale,
                     graphics::RGBA8888ToRGBA(color),
-                    blend_mode
+                    blend_mode,
+                    filter
                 );
 
                 return 0;
@@ -1150,6 +1205,7 @@ namespace rpgss {
                 int x4, y4;
                 u32 color;
                 int blend_mode;
+                int filter;
 
                 int nargs = lua_gettop(L);
                 if (nargs >= 13)
@@ -1173,6 +1229,11 @@ namespace rpgss {
                     if (!graphics_module::GetBlendModeConstant(blend_mode_str, blend_mode)) {
                         return luaL_argerror(L, 15, "invalid blend mode constant");
                     }
+
+                    const char* filter_str = luaL_optstring(L, 16, "nearest");
+                    if (!graphics_module::GetFilterModeConstant(filter_str, filter)) {
+                        return luaL_argerror(L, 16, "invalid filter mode constant");
+                    }
                 }
                 else
                 {
@@ -1192,6 +1253,11 @@ namespace rpgss {
                         return luaL_argerror(L, 11, "invalid blend mode constant");
                     }
 
+                    const char* filter_str = luaL_optstring(L, 12, "nearest");
+                    if (!graphics_module::GetFilterModeConstant(filter_str, filter)) {
+                        return luaL_argerror(L, 12, "invalid filter mode constant");
+                    }
+
                     sx = 0;
                     sy = 0;
                     sw = that->getWidth();
@@ -1206,12 +1272,40 @@ namespace rpgss {
                     core::Vec2i(x3, y3),
                     core::Vec2i(x4, y4),
                     graphics::RGBA8888ToRGBA(color),
-                    blend_mode
+                    blend_mode,
+                    filter
                 );
 
                 return 0;
             }
 
+            //---------------------------------------------------------
+            int game_screen_drawBatch(lua_State* L)
+            {
+                static std::vector<graphics::DrawBatchItem> items; // reused across calls
+
+                graphics::Image* that = graphics_module::ImageWrapper::Get(L, 1);
+                graphics_module::GetDrawBatchItems(L, 2, items);
+
+                int blend_mode;
+                const char* blend_mode_str = luaL_optstring(L, 3, "mix");
+                if (!graphics_module::GetBlendModeConstant(blend_mode_str, blend_mode)) {
+                    return luaL_argerror(L, 3, "invalid blend mode constant");
+                }
+
+                int filter;
+                const char* filter_str = luaL_optstring(L, 4, "nearest");
+                if (!graphics_module::GetFilterModeConstant(filter_str, filter)) {
+                    return luaL_argerror(L, 4, "invalid filter mode constant");
+                }
+
+                if (!items.empty()) {
+                    Screen::DrawBatch(that, &items[0], (int)items.size(), blend_mode, filter);
+                }
+
+                return 0;
+            }
+
             //---------------------------------------------------------
             int game_screen_drawText(lua_State* L)
             {
@@ -1255,6 +1349,63 @@ namespace rpgss {
                 return 0;
             }
 
+            /***********************************************************
+             *                        LIGHTMAP
+             **********************************************************/
+
+            //---------------------------------------------------------
+            int game_lightmap_get_opacity()
+            {
+                return Lightmap::GetOpacity();
+            }
+
+            //---------------------------------------------------------
+            void game_lightmap_set_opacity(int opacity)
+            {
+                Lightmap::SetOpacity(opacity);
+            }
+
+            //---------------------------------------------------------
+            int game_lightmap_getImage(lua_State* L)
+            {
+                graphics::Image* image = Lightmap::GetImage();
+                if (image) {
+                    graphics_module::ImageWrapper::Push(L, image);
+                } else {
+                    lua_pushnil(L);
+                }
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int game_lightmap_setImage(lua_State* L)
+            {
+                Lightmap::SetImage(graphics_module::ImageWrapper::GetOpt(L, 1));
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int game_lightmap_getBlendMode(lua_State* L)
+            {
+                std::string blend_mode_str;
+                if (!graphics_module::GetBlendModeConstant(Lightmap::GetBlendMode(), blend_mode_str)) {
+                    return luaL_error(L, "unexpected internal value");
+                }
+                lua_pushlstring(L, blend_mode_str.c_str(), blend_mode_str.length());
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int game_lightmap_setBlendMode(lua_State* L)
+            {
+                int blend_mode;
+                const char* blend_mode_str = luaL_checkstring(L, 1);
+                if (!graphics_module::GetBlendModeConstant(blend_mode_str, blend_mode) || !Lightmap::SetBlendMode(blend_mode)) {
+                    return luaL_argerror(L, 1, "invalid blend mode constant");
+                }
+                return 0;
+            }
+
             /***********************************************************
              *                         GAME
              **********************************************************/
@@ -1772,6 +1923,10 @@ namespace rpgss {
                             .addCFunction("copyRect",               &game_screen_copyRect)
                             .addCFunction("clear",                  &game_screen_clear)
                             .addCFunction("grey",                   &game_screen_grey)
+                            .addCFunction("applyColorMatrix",       &game_screen_applyColorMatrix)
+                            .addCFunction("tone",                   &game_screen_tone)
+                            .addCFunction("saturate",               &game_screen_saturate)
+                            .addCFunction("rotateHue",              &game_screen_rotateHue)
                             .addCFunction("getPixel",               &game_screen_getPixel)
                             .addCFunction("setPixel",               &game_screen_setPixel)
                             .addCFunction("drawPoint",              &game_screen_drawPoint)
@@ -1781,10 +1936,19 @@ namespace rpgss {
                             .addCFunction("drawTriangle",           &game_screen_drawTriangle)
                             .addCFunction("draw",                   &game_screen_draw)
                             .addCFunction("drawq",                  &game_screen_drawq)
+                            .addCFunction("drawBatch",              &game_screen_drawBatch)
                             .addCFunction("drawText",               &game_screen_drawText)
                             .addCFunction("drawWindow",             &game_screen_drawWindow)
                         .endNamespace()
 
+                        .beginNamespace("lightmap")
+                            .addProperty("opacity",                 &game_lightmap_get_opacity, &game_lightmap_set_opacity)
+                            .addCFunction("getImage",               &game_lightmap_getImage)
+                            .addCFunction("setImage",               &game_lightmap_setImage)
+                            .addCFunction("getBlendMode",           &game_lightmap_getBlendMode)
+                            .addCFunction("setBlendMode",           &game_lightmap_setBlendMode)
+                        .endNamespace()
+
                     .endNamespace();
 
                 return true;
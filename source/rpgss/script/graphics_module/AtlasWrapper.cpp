@@ -0,0 +1,199 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <cassert>
+
+#include "../../Context.hpp"
+#include "../../graphics/graphics.hpp"
+#include "ImageWrapper.hpp"
+#include "AtlasWrapper.hpp"
+
+
+namespace rpgss {
+    namespace script {
+        namespace graphics_module {
+
+            //---------------------------------------------------------
+            void
+            AtlasWrapper::Push(lua_State* L, graphics::Atlas* atlas)
+            {
+                assert(atlas);
+                luabridge::push(L, AtlasWrapper(atlas));
+            }
+
+            //---------------------------------------------------------
+            bool
+            AtlasWrapper::Is(lua_State* L, int index)
+            {
+                assert(index != 0);
+
+                if (index < 0) { // allow negative indices
+                    index = lua_gettop(L) + index + 1;
+                }
+
+                return luabridge::Stack<AtlasWrapper*>::is_a(L, index);
+            }
+
+            //---------------------------------------------------------
+            graphics::Atlas*
+            AtlasWrapper::Get(lua_State* L, int index)
+            {
+                assert(index != 0);
+                int top = lua_gettop(L);
+                if (index < 0) { // allow negative indices
+                    index = top + index + 1;
+                }
+                if (index > top) {
+                    luaL_argerror(L, index, "Atlas expected, got nothing");
+                    return 0;
+                }
+                AtlasWrapper* wrapper = luabridge::Stack<AtlasWrapper*>::get(L, index);
+                if (wrapper) {
+                    return wrapper->This;
+                } else {
+                    const char* got = lua_typename(L, lua_type(L, index));
+                    const char* msg = lua_pushfstring(L, "Atlas expected, got %s", got);
+                    luaL_argerror(L, index, msg);
+                    return 0;
+                }
+            }
+
+            //---------------------------------------------------------
+            graphics::Atlas*
+            AtlasWrapper::GetOpt(lua_State* L, int index)
+            {
+                assert(index != 0);
+                int top = lua_gettop(L);
+                if (index < 0) { // allow negative indices
+                    index = top + index + 1;
+                }
+                if (index > top) {
+                    return 0;
+                }
+                AtlasWrapper* wrapper = luabridge::Stack<AtlasWrapper*>::get(L, index);
+                if (wrapper) {
+                    return wrapper->This;
+                } else {
+                    return 0;
+                }
+            }
+
+            //---------------------------------------------------------
+            AtlasWrapper::AtlasWrapper(graphics::Atlas* ptr)
+                : This(ptr)
+            {
+            }
+
+            //---------------------------------------------------------
+            int
+            AtlasWrapper::get_pageWidth() const
+            {
+                return This->getPageWidth();
+            }
+
+            //---------------------------------------------------------
+            int
+            AtlasWrapper::get_pageHeight() const
+            {
+                return This->getPageHeight();
+            }
+
+            //---------------------------------------------------------
+            int
+            AtlasWrapper::get_pageCount() const
+            {
+                return This->getPageCount();
+            }
+
+            //---------------------------------------------------------
+            int
+            AtlasWrapper::__len(lua_State* L)
+            {
+                lua_pushinteger(L, This->getEntryCount());
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int
+            AtlasWrapper::getPage(lua_State* L)
+            {
+                int index = luaL_checkint(L, 2);
+                luaL_argcheck(L, index >= 1 && index <= This->getPageCount(), 2, "invalid page index");
+                ImageWrapper::Push(L, This->getPage(index - 1));
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int
+            AtlasWrapper::insert(lua_State* L)
+            {
+                const char* name = luaL_checkstring(L, 2);
+
+                graphics::Image::Ptr image;
+                if (lua_type(L, 3) == LUA_TSTRING) {
+                    image = graphics::ReadImage(lua_tostring(L, 3));
+                } else {
+                    image = ImageWrapper::Get(L, 3);
+                }
+
+                graphics::Atlas::Entry entry;
+                if (!image || !This->insert(name, image, &entry)) {
+                    lua_pushnil(L);
+                    return 1;
+                }
+
+                return pushEntry(L, entry);
+            }
+
+            //---------------------------------------------------------
+            int
+            AtlasWrapper::get(lua_State* L)
+            {
+                const char* name = luaL_checkstring(L, 2);
+
+                const graphics::Atlas::Entry* entry = This->find(name);
+                if (!entry) {
+                    lua_pushnil(L);
+                    return 1;
+                }
+
+                return pushEntry(L, *entry);
+            }
+
+            //---------------------------------------------------------
+            int
+            AtlasWrapper::pushEntry(lua_State* L, const graphics::Atlas::Entry& entry)
+            {
+                // page, x, y, w, h as expected by Image:draw and game.screen.draw
+                ImageWrapper::Push(L, This->getPage(entry.page));
+                lua_pushinteger(L, entry.rect.getX());
+                lua_pushinteger(L, entry.rect.getY());
+                lua_pushinteger(L, entry.rect.getWidth());
+                lua_pushinteger(L, entry.rect.getHeight());
+                return 5;
+            }
+
+        } // namespace graphics_module
+    } // namespace script
+} // namespace rpgss
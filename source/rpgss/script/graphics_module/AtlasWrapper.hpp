@@ -0,0 +1,65 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#ifndef RPGSS_SCRIPT_GRAPHICS_MODULE_ATLASWRAPPER_HPP_INCLUDED
+#define RPGSS_SCRIPT_GRAPHICS_MODULE_ATLASWRAPPER_HPP_INCLUDED
+
+#include "../../graphics/Atlas.hpp"
+#include "../lua_include.hpp"
+
+
+namespace rpgss {
+    namespace script {
+        namespace graphics_module {
+
+            class AtlasWrapper {
+            public:
+                static void Push(lua_State* L, graphics::Atlas* atlas);
+                static bool Is(lua_State* L, int index);
+                static graphics::Atlas* Get(lua_State* L, int index);
+                static graphics::Atlas* GetOpt(lua_State* L, int index);
+
+                explicit AtlasWrapper(graphics::Atlas* ptr);
+
+                int get_pageWidth() const;
+                int get_pageHeight() const;
+                int get_pageCount() const;
+                int __len(lua_State* L);
+                int getPage(lua_State* L);
+                int insert(lua_State* L);
+                int get(lua_State* L);
+
+            private:
+                int pushEntry(lua_State* L, const graphics::Atlas::Entry& entry);
+
+            private:
+                graphics::Atlas::Ptr This;
+            };
+
+        } // namespace graphics_module
+    } // namespace script
+} // namespace rpgss
+
+
+#endif // RPGSS_SCRIPT_GRAPHICS_MODULE_ATLASWRAPPER_HPP_INCLUDED
@@ -0,0 +1,166 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <cassert>
+
+#include "ImageWrapper.hpp"
+#include "constants.hpp"
+#include "ImageRequestWrapper.hpp"
+
+
+namespace rpgss {
+    namespace script {
+        namespace graphics_module {
+
+            //---------------------------------------------------------
+            void
+            ImageRequestWrapper::Push(lua_State* L, graphics::loader::Request* request)
+            {
+                assert(request);
+                luabridge::push(L, ImageRequestWrapper(request));
+            }
+
+            //---------------------------------------------------------
+            bool
+            ImageRequestWrapper::Is(lua_State* L, int index)
+            {
+                assert(index != 0);
+
+                if (index < 0) { // allow negative indices
+                    index = lua_gettop(L) + index + 1;
+                }
+
+                return luabridge::Stack<ImageRequestWrapper*>::is_a(L, index);
+            }
+
+            //---------------------------------------------------------
+            graphics::loader::Request*
+            ImageRequestWrapper::Get(lua_State* L, int index)
+            {
+                assert(index != 0);
+                int top = lua_gettop(L);
+                if (index < 0) { // allow negative indices
+                    index = top + index + 1;
+                }
+                if (index > top) {
+                    luaL_argerror(L, index, "ImageRequest expected, got nothing");
+                    return 0;
+                }
+                ImageRequestWrapper* wrapper = luabridge::Stack<ImageRequestWrapper*>::get(L, index);
+                if (wrapper) {
+                    return wrapper->This;
+                } else {
+                    const char* got = lua_typename(L, lua_type(L, index));
+                    const char* msg = lua_pushfstring(L, "ImageRequest expected, got %s", got);
+                    luaL_argerror(L, index, msg);
+                    return 0;
+                }
+            }
+
+            //---------------------------------------------------------
+            graphics::loader::Request*
+            ImageRequestWrapper::GetOpt(lua_State* L, int index)
+            {
+                assert(index != 0);
+                int top = lua_gettop(L);
+                if (index < 0) { // allow negative indices
+                    index = top + index + 1;
+                }
+                if (index > top) {
+                    return 0;
+                }
+                ImageRequestWrapper* wrapper = luabridge::Stack<ImageRequestWrapper*>::get(L, index);
+                if (wrapper) {
+                    return wrapper->This;
+                } else {
+                    return 0;
+                }
+            }
+
+            //---------------------------------------------------------
+            ImageRequestWrapper::ImageRequestWrapper(graphics::loader::Request* ptr)
+                : This(ptr)
+            {
+            }
+
+            //---------------------------------------------------------
+            std::string
+            ImageRequestWrapper::get_filename() const
+            {
+                return This->getFilename();
+            }
+
+            //---------------------------------------------------------
+            std::string
+            ImageRequestWrapper::get_state() const
+            {
+                std::string state_str;
+                GetRequestStateConstant(This->getState(), state_str);
+                return state_str;
+            }
+
+            //---------------------------------------------------------
+            bool
+            ImageRequestWrapper::get_ready() const
+            {
+                return This->isReady();
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageRequestWrapper::get(lua_State* L)
+            {
+                graphics::Image* image = This->getImage();
+                if (image) {
+                    ImageWrapper::Push(L, image);
+                } else {
+                    lua_pushnil(L);
+                }
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageRequestWrapper::wait(lua_State* L)
+            {
+                graphics::Image* image = This->wait();
+                if (image) {
+                    ImageWrapper::Push(L, image);
+                } else {
+                    lua_pushnil(L);
+                }
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageRequestWrapper::cancel(lua_State* L)
+            {
+                lua_pushboolean(L, This->cancel());
+                return 1;
+            }
+
+        } // namespace graphics_module
+    } // namespace script
+} // namespace rpgss
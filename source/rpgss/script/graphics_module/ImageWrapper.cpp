@@ -26,8 +26,11 @@
 #include <cstring>
 
 #include "../../Context.hpp"
+#include "../../graphics/kernels.hpp"
 #include "../core_module/core_module.hpp"
 #include "constants.hpp"
+#include "batch.hpp"
+#include "colormatrix.hpp"
 #include "FontWrapper.hpp"
 #include "WindowSkinWrapper.hpp"
 #include "ImageWrapper.hpp"
@@ -122,6 +125,41 @@ namespace rpgss {
                 return This->getHeight();
             }
 
+            //---------------------------------------------------------
+            bool
+            ImageWrapper::get_premultiplied() const
+            {
+                return This->isPremultiplied();
+            }
+
+            //---------------------------------------------------------
+            bool
+            ImageWrapper::get_useSpanTable() const
+            {
+                return This->getUseSpanTable();
+            }
+
+            //---------------------------------------------------------
+            void
+            ImageWrapper::set_useSpanTable(bool useSpanTable)
+            {
+                This->setUseSpanTable(useSpanTable);
+            }
+
+            //---------------------------------------------------------
+            bool
+            ImageWrapper::get_trackDirty() const
+            {
+                return This->getTrackDirty();
+            }
+
+            //---------------------------------------------------------
+            void
+            ImageWrapper::set_trackDirty(bool trackDirty)
+            {
+                This->setTrackDirty(trackDirty);
+            }
+
             //---------------------------------------------------------
             int
             ImageWrapper::__len(lua_State* L)
@@ -171,11 +209,50 @@ namespace rpgss {
                 return 0;
             }
 
+            //---------------------------------------------------------
+            int
+            ImageWrapper::getDirtyRects(lua_State* L)
+            {
+                const std::vector<core::Recti>& dirty_rects = This->getDirtyRects();
+
+                lua_createtable(L, (int)dirty_rects.size(), 0);
+                for (int i = 0; i < (int)dirty_rects.size(); i++) {
+                    lua_createtable(L, 4, 0);
+                    lua_pushnumber(L, dirty_rects[i].getX());
+                    lua_rawseti(L, -2, 1);
+                    lua_pushnumber(L, dirty_rects[i].getY());
+                    lua_rawseti(L, -2, 2);
+                    lua_pushnumber(L, dirty_rects[i].getWidth());
+                    lua_rawseti(L, -2, 3);
+                    lua_pushnumber(L, dirty_rects[i].getHeight());
+                    lua_rawseti(L, -2, 4);
+                    lua_rawseti(L, -2, i+1);
+                }
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::clearDirty(lua_State* L)
+            {
+                This->clearDirty();
+                return 0;
+            }
+
             //---------------------------------------------------------
             int
             ImageWrapper::copyPixels(lua_State* L)
             {
-                core::ByteArray::Ptr pixels = core::ByteArray::New((const u8*)This->getPixels(), This->getSizeInBytes());
+                const graphics::Image* image = This.get();
+
+                core::ByteArray::Ptr pixels = core::ByteArray::New(image->getSizeInBytes());
+
+                // views are not stored contiguously
+                int row_size = image->getWidth() * sizeof(graphics::RGBA);
+                for (int y = 0; y < image->getHeight(); y++) {
+                    std::memcpy(pixels->getBuffer() + y * row_size, image->getPixels() + y * image->getPitch(), row_size);
+                }
+
                 core_module::ByteArrayWrapper::Push(L, pixels);
                 return 1;
             }
@@ -197,10 +274,42 @@ namespace rpgss {
                     return luaL_error(L, "invalid rect");
                 }
 
+                if (destination && destination->hasViews() && destination->getDimensions() != rect.getDimensions()) {
+                    return luaL_error(L, "destination image has views");
+                }
+
                 luabridge::push(L, ImageWrapper(This->copyRect(rect, destination)));
                 return 1;
             }
 
+            //---------------------------------------------------------
+            int
+            ImageWrapper::view(lua_State* L)
+            {
+                int x = luaL_checkint(L, 2);
+                int y = luaL_checkint(L, 3);
+                int w = luaL_checkint(L, 4);
+                int h = luaL_checkint(L, 5);
+
+                core::Recti rect = core::Recti(x, y, w, h);
+                core::Recti image_bounds = core::Recti(This->getDimensions());
+
+                if (!rect.isValid() || !rect.isInside(image_bounds)) {
+                    return luaL_error(L, "invalid rect");
+                }
+
+                luabridge::push(L, ImageWrapper(This->view(rect)));
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::clone(lua_State* L)
+            {
+                luabridge::push(L, ImageWrapper(This->clone()));
+                return 1;
+            }
+
             //---------------------------------------------------------
             int
             ImageWrapper::resize(lua_State* L)
@@ -209,7 +318,9 @@ namespace rpgss {
                 int height = luaL_checkint(L, 3);
                 luaL_argcheck(L, width  > 0, 2, "invalid width");
                 luaL_argcheck(L, height > 0, 3, "invalid height");
-                This->resize(width, height);
+                if (!This->resize(width, height)) {
+                    return luaL_error(L, "image has views");
+                }
                 return 0;
             }
 
@@ -239,6 +350,133 @@ namespace rpgss {
                 return 0;
             }
 
+            //---------------------------------------------------------
+            int
+            ImageWrapper::invert(lua_State* L)
+            {
+                This->invert();
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::multiplyAlpha(lua_State* L)
+            {
+                int alpha = luaL_checkint(L, 2);
+                This->multiplyAlpha(alpha);
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::swapChannels(lua_State* L)
+            {
+                // e.g. "bgra" swaps red and blue
+                const char* order_str = luaL_checkstring(L, 2);
+
+                if (std::strlen(order_str) != 4) {
+                    return luaL_argerror(L, 2, "invalid channel order");
+                }
+
+                const char* channels = "rgba";
+
+                int order[4];
+                for (int i = 0; i < 4; i++) {
+                    const char* channel = std::strchr(channels, order_str[i]);
+                    if (!channel) {
+                        return luaL_argerror(L, 2, "invalid channel order");
+                    }
+                    order[i] = channel - channels;
+                }
+
+                This->swapChannels(order[0], order[1], order[2], order[3]);
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::applyColorMatrix(lua_State* L)
+            {
+                This->applyColorMatrix(GetColorMatrix(L, 2));
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::tone(lua_State* L)
+            {
+                int red   = luaL_checkint(L, 2);
+                int green = luaL_checkint(L, 3);
+                int blue  = luaL_checkint(L, 4);
+                int grey  = luaL_optint(L, 5, 0);
+
+                This->applyColorMatrix(graphics::ColorMatrix::Tone(red, green, blue, grey));
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::saturate(lua_State* L)
+            {
+                float saturation = luaL_checknumber(L, 2);
+                This->applyColorMatrix(graphics::ColorMatrix::Saturation(saturation));
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::rotateHue(lua_State* L)
+            {
+                float angle = luaL_checknumber(L, 2);
+                This->applyColorMatrix(graphics::ColorMatrix::HueRotation(angle));
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::blur(lua_State* L)
+            {
+                int radius = luaL_checkint(L, 2);
+                int passes = luaL_optint(L, 3, 3);
+
+                luaL_argcheck(L, radius >= 0 && radius <= graphics::kernels::MaxBoxBlurRadius, 2, "invalid radius");
+                luaL_argcheck(L, passes >= 1, 3, "invalid passes");
+
+                This->blur(radius, passes);
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::glow(lua_State* L)
+            {
+                int radius = luaL_checkint(L, 2);
+                u32 color  = luaL_optint(L, 3, 0xFFFFFFFF);
+                int passes = luaL_optint(L, 4, 3);
+
+                luaL_argcheck(L, radius >= 0 && radius <= graphics::kernels::MaxBoxBlurRadius, 2, "invalid radius");
+                luaL_argcheck(L, passes >= 1, 4, "invalid passes");
+
+                This->glow(radius, graphics::RGBA8888ToRGBA(color), passes);
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::premultiply(lua_State* L)
+            {
+                This->premultiply();
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int
+            ImageWrapper::unpremultiply(lua_State* L)
+            {
+                This->unpremultiply();
+                return 0;
+            }
+
             //---------------------------------------------------------
             int
             ImageWrapper::flip(lua_State* L)
@@ -263,9 +501,15 @@ namespace rpgss {
                 const char* direction_str = luaL_checkstring(L, 2);
 
                 if (std::strcmp(direction_str, "cw") == 0) {
-                    This->rotateClockwise();
+                    if (!This->rotateClockwise()) {
+                        return luaL_error(L, "image has views");
+                    }
                 } else if (std::strcmp(direction_str, "ccw") == 0) {
-                    This->rotateCounterClockwise();
+                    if (!This->rotateCounterClockwise()) {
+                        return luaL_error(L, "image has views");
+                    }
+                } else if (std::strcmp(direction_str, "180") == 0) {
+                    This->rotate180();
                 } else {
                     return luaL_error(L, "invalid direction constant");
                 }
@@ -421,7 +665,6 @@ namespace rpgss {
             int
             ImageWrapper::drawTriangle(lua_State* L)
             {
-                /*
                 bool fill = lua_toboolean(L, 2);
                 int    x1 = luaL_checkint(L, 3);
                 int    y1 = luaL_checkint(L, 4);
@@ -429,18 +672,26 @@ namespace rpgss {
                 int    y2 = luaL_checkint(L, 6);
                 int    x3 = luaL_checkint(L, 7);
                 int    y3 = luaL_checkint(L, 8);
-                u32    c1 = luaL_checkunsigned(L, 9);
-                u32    c2 = luaL_optunsigned(L, 10, c1);
-                u32    c3 = luaL_optunsigned(L, 11, c1);
+                u32    c1 = luaL_checkint(L, 9);
+                u32    c2 = luaL_optint(L, 10, c1);
+                u32    c3 = luaL_optint(L, 11, c1);
 
                 int blend_mode;
                 const char* blend_mode_str = luaL_optstring(L, 12, "mix");
                 if (!GetBlendModeConstant(blend_mode_str, blend_mode)) {
                     return luaL_argerror(L, 12, "invalid blend mode constant");
                 }
-                */
 
-                // TODO
+                This->drawTriangle(
+                    fill,
+                    core::Vec2i(x1, y1),
+                    core::Vec2i(x2, y2),
+                    core::Vec2i(x3, y3),
+                    graphics::RGBA8888ToRGBA(c1),
+                    graphics::RGBA8888ToRGBA(c2),
+                    graphics::RGBA8888ToRGBA(c3),
+                    blend_mode
+                );
 
                 return 0;
             }
@@ -456,6 +707,7 @@ namespace rpgss {
                 float scale;
                 u32   color;
                 int blend_mode;
+                int filter;
 
                 int nargs = lua_gettop(L);
                 if (nargs >= 8 && lua_type(L, 8) == LUA_TNUMBER)
@@ -475,6 +727,11 @@ namespace rpgss {
                     if (!GetBlendModeConstant(blend_mode_str, blend_mode)) {
                         return luaL_argerror(L, 12, "invalid blend mode constant");
                     }
+
+                    const char* filter_str = luaL_optstring(L, 13, "nearest");
+                    if (!GetFilterModeConstant(filter_str, filter)) {
+                        return luaL_argerror(L, 13, "invalid filter mode constant");
+                    }
                 }
                 else
                 {
@@ -490,6 +747,11 @@ namespace rpgss {
                         return luaL_argerror(L, 8, "invalid blend mode constant");
                     }
 
+                    const char* filter_str = luaL_optstring(L, 9, "nearest");
+                    if (!GetFilterModeConstant(filter_str, filter)) {
+                        return luaL_argerror(L, 9, "invalid filter mode constant");
+                    }
+
                     sx = 0;
                     sy = 0;
                     sw = that->getWidth();
@@ -503,7 +765,8 @@ namespace rpgss {
                     angle,
                     scale,
                     graphics::RGBA8888ToRGBA(color),
-                    blend_mode
+                    blend_mode,
+                    filter
                 );
 
                 return 0;
@@ -521,6 +784,7 @@ namespace rpgss {
                 int x4, y4;
                 u32 color;
                 int blend_mode;
+                int filter;
 
                 int nargs = lua_gettop(L);
                 if (nargs >= 14)
@@ -544,6 +808,11 @@ namespace rpgss {
                     if (!GetBlendModeConstant(blend_mode_str, blend_mode)) {
                         return luaL_argerror(L, 16, "invalid blend mode constant");
                     }
+
+                    const char* filter_str = luaL_optstring(L, 17, "nearest");
+                    if (!GetFilterModeConstant(filter_str, filter)) {
+                        return luaL_argerror(L, 17, "invalid filter mode constant");
+                    }
                 }
                 else
                 {
@@ -563,6 +832,11 @@ namespace rpgss {
                         return luaL_argerror(L, 12, "invalid blend mode constant");
                     }
 
+                    const char* filter_str = luaL_optstring(L, 13, "nearest");
+                    if (!GetFilterModeConstant(filter_str, filter)) {
+                        return luaL_argerror(L, 13, "invalid filter mode constant");
+                    }
+
                     sx = 0;
                     sy = 0;
                     sw = that->getWidth();
@@ -577,12 +851,41 @@ namespace rpgss {
                     core::Vec2i(x3, y3),
                     core::Vec2i(x4, y4),
                     graphics::RGBA8888ToRGBA(color),
-                    blend_mode
+                    blend_mode,
+                    filter
                 );
 
                 return 0;
             }
 
+            //---------------------------------------------------------
+            int
+            ImageWrapper::drawBatch(lua_State* L)
+            {
+                static std::vector<graphics::DrawBatchItem> items; // reused across calls
+
+                graphics::Image* that = ImageWrapper::Get(L, 2);
+                GetDrawBatchItems(L, 3, items);
+
+                int blend_mode;
+                const char* blend_mode_str = luaL_optstring(L, 4, "mix");
+                if (!GetBlendModeConstant(blend_mode_str, blend_mode)) {
+                    return luaL_argerror(L, 4, "invalid blend mode constant");
+                }
+
+                int filter;
+                const char* filter_str = luaL_optstring(L, 5, "nearest");
+                if (!GetFilterModeConstant(filter_str, filter)) {
+                    return luaL_argerror(L, 5, "invalid filter mode constant");
+                }
+
+                if (!items.empty()) {
+                    This->drawBatch(that, &items[0], (int)items.size(), blend_mode, filter);
+                }
+
+                return 0;
+            }
+
             //---------------------------------------------------------
             int
             ImageWrapper::drawText(lua_State* L)
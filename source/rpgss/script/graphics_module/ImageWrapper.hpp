@@ -44,18 +44,38 @@ namespace rpgss {
 
                 int get_width() const;
                 int get_height() const;
+                bool get_premultiplied() const;
+                bool get_useSpanTable() const;
+                void set_useSpanTable(bool useSpanTable);
+                bool get_trackDirty() const;
+                void set_trackDirty(bool trackDirty);
                 int __len(lua_State* L);
                 int getDimensions(lua_State* L);
                 int getBlendMode(lua_State* L);
                 int setBlendMode(lua_State* L);
                 int getClipRect(lua_State* L);
                 int setClipRect(lua_State* L);
+                int getDirtyRects(lua_State* L);
+                int clearDirty(lua_State* L);
                 int copyPixels(lua_State* L);
                 int copyRect(lua_State* L);
+                int view(lua_State* L);
+                int clone(lua_State* L);
                 int resize(lua_State* L);
                 int setAlpha(lua_State* L);
                 int clear(lua_State* L);
                 int grey(lua_State* L);
+                int invert(lua_State* L);
+                int multiplyAlpha(lua_State* L);
+                int swapChannels(lua_State* L);
+                int applyColorMatrix(lua_State* L);
+                int tone(lua_State* L);
+                int saturate(lua_State* L);
+                int rotateHue(lua_State* L);
+                int blur(lua_State* L);
+                int glow(lua_State* L);
+                int premultiply(lua_State* L);
+                int unpremultiply(lua_State* L);
                 int flip(lua_State* L);
                 int rotate(lua_State* L);
                 int getPixel(lua_State* L);
@@ -67,6 +87,7 @@ namespace rpgss {
                 int drawTriangle(lua_State* L);
                 int draw(lua_State* L);
                 int drawq(lua_State* L);
+                int drawBatch(lua_State* L);
                 int drawText(lua_State* L);
                 int drawWindow(lua_State* L);
 
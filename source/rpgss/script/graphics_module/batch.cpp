@@ -0,0 +1,107 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <cstring>
+
+#include "../core_module/core_module.hpp"
+#include "batch.hpp"
+
+
+namespace rpgss {
+    namespace script {
+        namespace graphics_module {
+
+            //---------------------------------------------------------
+            void GetDrawBatchItems(lua_State* L, int index, std::vector<graphics::DrawBatchItem>& items)
+            {
+                items.clear();
+
+                if (core_module::ByteArrayWrapper::Is(L, index))
+                {
+                    core::ByteArray* data = core_module::ByteArrayWrapper::Get(L, index);
+                    if (data->getSize() % DrawBatchRecordSize != 0) {
+                        luaL_argerror(L, index, "size of batch data is not a multiple of the record size");
+                        return;
+                    }
+
+                    int count = data->getSize() / DrawBatchRecordSize;
+                    items.resize(count);
+
+                    const u8* p = data->getBuffer();
+                    for (int i = 0; i < count; i++) {
+                        i32 rect[6];
+                        u32 color;
+                        f32 angle;
+                        f32 scale;
+
+                        std::memcpy(rect,   p,      sizeof(rect));
+                        std::memcpy(&color, p + 24, sizeof(color));
+                        std::memcpy(&angle, p + 28, sizeof(angle));
+                        std::memcpy(&scale, p + 32, sizeof(scale));
+
+                        graphics::DrawBatchItem& item = items[i];
+                        item.srcRect = core::Recti(rect[0], rect[1], rect[2], rect[3]);
+                        item.pos     = core::Vec2i(rect[4], rect[5]);
+                        item.color   = graphics::RGBA8888ToRGBA(color);
+                        item.angle   = angle;
+                        item.scale   = scale;
+
+                        p += DrawBatchRecordSize;
+                    }
+                }
+                else
+                {
+                    luaL_checktype(L, index, LUA_TTABLE);
+
+                    int len = (int)lua_objlen(L, index);
+                    if (len % DrawBatchRecordFields != 0) {
+                        luaL_argerror(L, index, "length of batch data is not a multiple of the record length");
+                        return;
+                    }
+
+                    int count = len / DrawBatchRecordFields;
+                    items.resize(count);
+
+                    int n = 1;
+                    for (int i = 0; i < count; i++) {
+                        lua_Number fields[DrawBatchRecordFields];
+                        for (int j = 0; j < DrawBatchRecordFields; j++) {
+                            lua_rawgeti(L, index, n++);
+                            fields[j] = lua_tonumber(L, -1);
+                            lua_pop(L, 1);
+                        }
+
+                        graphics::DrawBatchItem& item = items[i];
+                        item.srcRect = core::Recti((int)fields[0], (int)fields[1], (int)fields[2], (int)fields[3]);
+                        item.pos     = core::Vec2i((int)fields[4], (int)fields[5]);
+                        item.color   = graphics::RGBA8888ToRGBA((u32)(i64)fields[6]);
+                        item.angle   = (float)fields[7];
+                        item.scale   = (float)fields[8];
+                    }
+                }
+            }
+
+        } // namespace graphics_module
+    } // namespace script
+} // namespace rpgss
@@ -0,0 +1,58 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include "colormatrix.hpp"
+
+
+namespace rpgss {
+    namespace script {
+        namespace graphics_module {
+
+            //---------------------------------------------------------
+            graphics::ColorMatrix GetColorMatrix(lua_State* L, int index)
+            {
+                graphics::ColorMatrix matrix;
+
+                luaL_checktype(L, index, LUA_TTABLE);
+
+                if (lua_objlen(L, index) != 20) {
+                    luaL_argerror(L, index, "color matrix must have 20 elements");
+                    return matrix;
+                }
+
+                int n = 1;
+                for (int i = 0; i < 4; i++) {
+                    for (int j = 0; j < 5; j++) {
+                        lua_rawgeti(L, index, n++);
+                        matrix.m[i][j] = (float)lua_tonumber(L, -1);
+                        lua_pop(L, 1);
+                    }
+                }
+
+                return matrix;
+            }
+
+        } // namespace graphics_module
+    } // namespace script
+} // namespace rpgss
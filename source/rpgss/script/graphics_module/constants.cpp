@@ -26,6 +26,7 @@
 #include <boost/assign/list_of.hpp>
 
 #include "../../graphics/Image.hpp"
+#include "../../graphics/loader.hpp"
 #include "constants.hpp"
 
 
@@ -77,6 +78,66 @@ namespace rpgss {
                 return true;
             }
 
+            //---------------------------------------------------------
+            bool GetFilterModeConstant(int filter_mode, std::string& out_filter_mode_str)
+            {
+                typedef boost::unordered_map<int, std::string> map_type;
+
+                static map_type map = boost::assign::map_list_of
+                    (graphics::FilterMode::Nearest,  "nearest")
+                    (graphics::FilterMode::Bilinear, "bilinear");
+
+                map_type::iterator mapped_value = map.find(filter_mode);
+
+                if (mapped_value == map.end()) {
+                    return false;
+                }
+
+                out_filter_mode_str = mapped_value->second;
+                return true;
+            }
+
+            //---------------------------------------------------------
+            bool GetFilterModeConstant(const std::string& filter_mode_str, int& out_filter_mode)
+            {
+                typedef boost::unordered_map<std::string, int> map_type;
+
+                static map_type map = boost::assign::map_list_of
+                    ("nearest",  graphics::FilterMode::Nearest )
+                    ("bilinear", graphics::FilterMode::Bilinear);
+
+                map_type::iterator mapped_value = map.find(filter_mode_str);
+
+                if (mapped_value == map.end()) {
+                    return false;
+                }
+
+                out_filter_mode = mapped_value->second;
+                return true;
+            }
+
+            //---------------------------------------------------------
+            bool GetRequestStateConstant(int request_state, std::string& out_request_state_str)
+            {
+                typedef boost::unordered_map<int, std::string> map_type;
+
+                static map_type map = boost::assign::map_list_of
+                    (graphics::loader::Request::State::Queued,    "queued"   )
+                    (graphics::loader::Request::State::Loading,   "loading"  )
+                    (graphics::loader::Request::State::Done,      "done"     )
+                    (graphics::loader::Request::State::Failed,    "failed"   )
+                    (graphics::loader::Request::State::Cancelled, "cancelled");
+
+                map_type::iterator mapped_value = map.find(request_state);
+
+                if (mapped_value == map.end()) {
+                    return false;
+                }
+
+                out_request_state_str = mapped_value->second;
+                return true;
+            }
+
         } // namespace graphics_module
     } // namespace script
 } // namespace rpgss
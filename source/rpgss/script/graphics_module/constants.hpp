@@ -35,6 +35,11 @@ namespace rpgss {
             bool GetBlendModeConstant(int blend_mode, std::string& out_blend_mode_str);
             bool GetBlendModeConstant(const std::string& blend_mode_str, int& out_blend_mode);
 
+            bool GetFilterModeConstant(int filter_mode, std::string& out_filter_mode_str);
+            bool GetFilterModeConstant(const std::string& filter_mode_str, int& out_filter_mode);
+
+            bool GetRequestStateConstant(int request_state, std::string& out_request_state_str);
+
         } // namespace graphics_module
     } // namespace script
 } // namespace rpgss
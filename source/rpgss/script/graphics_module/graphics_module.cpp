@@ -25,6 +25,10 @@
 #define NOT_MAIN_MODULE
 #include <DynRPG/DynRPG.h>
 
+#include "../../graphics/imagecache.hpp"
+#include "../../graphics/parallel.hpp"
+#include "../../graphics/pixelpool.hpp"
+#include "../../graphics/textcache.hpp"
 #include "../core_module/core_module.hpp"
 #include "../io_module/io_module.hpp"
 #include "graphics_module.hpp"
@@ -59,6 +63,107 @@ namespace rpgss {
                 return 4;
             }
 
+            //---------------------------------------------------------
+            int graphics_getWorkerCount(lua_State* L)
+            {
+                lua_pushinteger(L, graphics::parallel::GetWorkerCount());
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int graphics_setWorkerCount(lua_State* L)
+            {
+                int count = luaL_checkint(L, 1);
+                luaL_argcheck(L, count >= 0 && count <= graphics::parallel::MaxWorkers, 1, "invalid worker count");
+                graphics::parallel::SetWorkerCount(count);
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int graphics_getTextCacheBudget(lua_State* L)
+            {
+                lua_pushinteger(L, graphics::textcache::GetBudget());
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int graphics_setTextCacheBudget(lua_State* L)
+            {
+                int bytes = luaL_checkint(L, 1);
+                luaL_argcheck(L, bytes >= 0, 1, "invalid budget");
+                graphics::textcache::SetBudget(bytes);
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int graphics_getTextCacheStats(lua_State* L)
+            {
+                lua_pushinteger(L, graphics::textcache::GetHits());
+                lua_pushinteger(L, graphics::textcache::GetMisses());
+                lua_pushinteger(L, graphics::textcache::GetSize());
+                lua_pushinteger(L, graphics::textcache::GetRunCount());
+                return 4;
+            }
+
+            //---------------------------------------------------------
+            int graphics_clearTextCache(lua_State* L)
+            {
+                graphics::textcache::Clear();
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int graphics_getPixelPoolLimit(lua_State* L)
+            {
+                lua_pushinteger(L, graphics::pixelpool::GetLimit());
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int graphics_setPixelPoolLimit(lua_State* L)
+            {
+                int bytes = luaL_checkint(L, 1);
+                luaL_argcheck(L, bytes >= 0, 1, "invalid limit");
+                graphics::pixelpool::SetLimit(bytes);
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int graphics_getPixelPoolStats(lua_State* L)
+            {
+                lua_pushinteger(L, graphics::pixelpool::GetLiveBytes());
+                lua_pushinteger(L, graphics::pixelpool::GetPooledBytes());
+                return 2;
+            }
+
+            //---------------------------------------------------------
+            int graphics_getImageCacheDirectory(lua_State* L)
+            {
+                std::string dirname = graphics::imagecache::GetDirectory();
+                if (dirname.empty()) {
+                    lua_pushnil(L);
+                } else {
+                    lua_pushstring(L, dirname.c_str());
+                }
+                return 1;
+            }
+
+            //---------------------------------------------------------
+            int graphics_setImageCacheDirectory(lua_State* L)
+            {
+                // setImageCacheDirectory(dirname), nil disables the cache
+                const char* dirname = luaL_optstring(L, 1, "");
+                graphics::imagecache::SetDirectory(dirname);
+                return 0;
+            }
+
+            //---------------------------------------------------------
+            int graphics_clearImageCache(lua_State* L)
+            {
+                graphics::imagecache::Clear();
+                return 0;
+            }
+
             //---------------------------------------------------------
             int graphics_newFont(lua_State* L)
             {
@@ -204,6 +309,25 @@ namespace rpgss {
                 return 1;
             }
 
+            //---------------------------------------------------------
+            int graphics_newAtlas(lua_State* L)
+            {
+                int page_width  = luaL_optint(L, 1, 1024);
+                int page_height = luaL_optint(L, 2, page_width);
+
+                luaL_argcheck(L, page_width  > 0, 1, "invalid page width");
+                luaL_argcheck(L, page_height > 0, 2, "invalid page height");
+
+                graphics::Atlas::Ptr atlas = graphics::Atlas::New(page_width, page_height);
+                if (atlas) {
+                    AtlasWrapper::Push(L, atlas);
+                } else {
+                    lua_pushnil(L);
+                }
+
+                return 1;
+            }
+
             //---------------------------------------------------------
             int graphics_newImage(lua_State* L)
             {
@@ -243,9 +367,10 @@ namespace rpgss {
             {
                 if (lua_isstring(L, 1))
                 {
-                    // readImage(filename)
+                    // readImage(filename [, premultiply])
                     const char* filename = lua_tostring(L, 1);
-                    graphics::Image::Ptr image = graphics::ReadImage(filename);
+                    bool premultiply = lua_toboolean(L, 2);
+                    graphics::Image::Ptr image = graphics::ReadImage(filename, premultiply);
                     if (image) {
                         ImageWrapper::Push(L, image);
                     } else {
@@ -254,9 +379,10 @@ namespace rpgss {
                 }
                 else
                 {
-                    // readImage(stream)
+                    // readImage(stream [, premultiply])
                     io::File* file = io_module::FileWrapper::Get(L, 1);
-                    graphics::Image::Ptr image = graphics::ReadImage(file);
+                    bool premultiply = lua_toboolean(L, 2);
+                    graphics::Image::Ptr image = graphics::ReadImage(file, premultiply);
                     if (image) {
                         ImageWrapper::Push(L, image);
                     } else {
@@ -266,28 +392,58 @@ namespace rpgss {
                 return 1;
             }
 
+            //---------------------------------------------------------
+            int graphics_readImageAsync(lua_State* L)
+            {
+                // readImageAsync(filename [, premultiply])
+                const char* filename = luaL_checkstring(L, 1);
+                bool premultiply = lua_toboolean(L, 2);
+                graphics::loader::Request::Ptr request = graphics::loader::ReadImageAsync(filename, premultiply);
+                if (request) {
+                    ImageRequestWrapper::Push(L, request);
+                } else {
+                    lua_pushnil(L); // too many pending requests
+                }
+                return 1;
+            }
+
             //---------------------------------------------------------
             int graphics_writeImage(lua_State* L)
             {
-                int nargs = lua_gettop(L);
-                if (nargs >= 2 && lua_isstring(L, 2))
-                {
-                    // writeImage(image, filename [, palletize, mask])
-                    graphics::Image* image = ImageWrapper::Get(L, 1);
-                    const char* filename = luaL_checkstring(L, 2);
-                    bool palletize = lua_toboolean(L, 3);
-                    i32 mask = luaL_optint(L, 4, -1);
+                graphics::Image* image = ImageWrapper::Get(L, 1);
+
+                // writeImage(image, filename|stream [, palletize, mask])
+                // writeImage(image, filename|stream, "png" [, palletize, mask])
+                // writeImage(image, filename|stream, "rpgssimg" [, compress])
+                int  arg    = 3;
+                bool native = false;
+                if (lua_type(L, 3) == LUA_TSTRING) {
+                    std::string format = lua_tostring(L, 3);
+                    if (format == "rpgssimg") {
+                        native = true;
+                    } else if (format != "png") {
+                        return luaL_argerror(L, 3, "invalid image format");
+                    }
+                    arg++;
+                }
 
-                    lua_pushboolean(L, graphics::WriteImage(image, filename, palletize, mask));
+                io::File::Ptr file;
+                if (lua_isstring(L, 2)) {
+                    file = io::OpenFile(lua_tostring(L, 2), io::File::Out);
+                    if (!file) {
+                        lua_pushboolean(L, false);
+                        return 1;
+                    }
+                } else {
+                    file = io_module::FileWrapper::Get(L, 2);
                 }
-                else
-                {
-                    // writeImage(image, stream [, palletize, mask])
-                    graphics::Image* image = ImageWrapper::Get(L, 1);
-                    io::File* file = io_module::FileWrapper::Get(L, 2);
-                    bool palletize = lua_toboolean(L, 3);
-                    i32 mask = luaL_optint(L, 4, -1);
 
+                if (native) {
+                    bool compress = lua_isnoneornil(L, arg) || lua_toboolean(L, arg);
+                    lua_pushboolean(L, graphics::WriteNativeImage(image, file, compress));
+                } else {
+                    bool palletize = lua_toboolean(L, arg);
+                    i32 mask = luaL_optint(L, arg + 1, -1);
                     lua_pushboolean(L, graphics::WriteImage(image, file, palletize, mask));
                 }
                 return 1;
@@ -301,6 +457,18 @@ namespace rpgss {
 
                         .addCFunction("packColor",   &graphics_packColor)
                         .addCFunction("unpackColor", &graphics_unpackColor)
+                        .addCFunction("getWorkerCount", &graphics_getWorkerCount)
+                        .addCFunction("setWorkerCount", &graphics_setWorkerCount)
+                        .addCFunction("getTextCacheBudget", &graphics_getTextCacheBudget)
+                        .addCFunction("setTextCacheBudget", &graphics_setTextCacheBudget)
+                        .addCFunction("getTextCacheStats",  &graphics_getTextCacheStats)
+                        .addCFunction("clearTextCache",     &graphics_clearTextCache)
+                        .addCFunction("getPixelPoolLimit",  &graphics_getPixelPoolLimit)
+                        .addCFunction("setPixelPoolLimit",  &graphics_setPixelPoolLimit)
+                        .addCFunction("getPixelPoolStats",  &graphics_getPixelPoolStats)
+                        .addCFunction("getImageCacheDirectory", &graphics_getImageCacheDirectory)
+                        .addCFunction("setImageCacheDirectory", &graphics_setImageCacheDirectory)
+                        .addCFunction("clearImageCache",        &graphics_clearImageCache)
 
                         .beginClass<FontWrapper>("Font")
                             .addProperty("maxCharWidth",        &FontWrapper::get_maxCharWidth)
@@ -322,19 +490,49 @@ namespace rpgss {
 
                         .addCFunction("newWindowSkin", &graphics_newWindowSkin)
 
+                        .beginClass<AtlasWrapper>("Atlas")
+                            .addProperty("pageWidth",           &AtlasWrapper::get_pageWidth)
+                            .addProperty("pageHeight",          &AtlasWrapper::get_pageHeight)
+                            .addProperty("pageCount",           &AtlasWrapper::get_pageCount)
+                            .addCFunction("__len",              &AtlasWrapper::__len)
+                            .addCFunction("getPage",            &AtlasWrapper::getPage)
+                            .addCFunction("insert",             &AtlasWrapper::insert)
+                            .addCFunction("get",                &AtlasWrapper::get)
+                        .endClass()
+
+                        .addCFunction("newAtlas", &graphics_newAtlas)
+
                         .beginClass<ImageWrapper>("Image")
                             .addProperty("width",               &ImageWrapper::get_width)
                             .addProperty("height",              &ImageWrapper::get_height)
+                            .addProperty("premultiplied",       &ImageWrapper::get_premultiplied)
+                            .addProperty("useSpanTable",        &ImageWrapper::get_useSpanTable,     &ImageWrapper::set_useSpanTable)
+                            .addProperty("trackDirty",          &ImageWrapper::get_trackDirty,       &ImageWrapper::set_trackDirty)
                             .addCFunction("__len",              &ImageWrapper::__len)
                             .addCFunction("getDimensions",      &ImageWrapper::getDimensions)
                             .addCFunction("getClipRect",        &ImageWrapper::getClipRect)
                             .addCFunction("setClipRect",        &ImageWrapper::setClipRect)
+                            .addCFunction("getDirtyRects",      &ImageWrapper::getDirtyRects)
+                            .addCFunction("clearDirty",         &ImageWrapper::clearDirty)
                             .addCFunction("copyPixels",         &ImageWrapper::copyPixels)
                             .addCFunction("copyRect",           &ImageWrapper::copyRect)
+                            .addCFunction("view",               &ImageWrapper::view)
+                            .addCFunction("clone",              &ImageWrapper::clone)
                             .addCFunction("resize",             &ImageWrapper::resize)
                             .addCFunction("setAlpha",           &ImageWrapper::setAlpha)
                             .addCFunction("clear",              &ImageWrapper::clear)
                             .addCFunction("grey",               &ImageWrapper::grey)
+                            .addCFunction("invert",             &ImageWrapper::invert)
+                            .addCFunction("multiplyAlpha",      &ImageWrapper::multiplyAlpha)
+                            .addCFunction("swapChannels",       &ImageWrapper::swapChannels)
+                            .addCFunction("applyColorMatrix",   &ImageWrapper::applyColorMatrix)
+                            .addCFunction("tone",               &ImageWrapper::tone)
+                            .addCFunction("saturate",           &ImageWrapper::saturate)
+                            .addCFunction("rotateHue",          &ImageWrapper::rotateHue)
+                            .addCFunction("blur",               &ImageWrapper::blur)
+                            .addCFunction("glow",               &ImageWrapper::glow)
+                            .addCFunction("premultiply",        &ImageWrapper::premultiply)
+                            .addCFunction("unpremultiply",      &ImageWrapper::unpremultiply)
                             .addCFunction("flip",               &ImageWrapper::flip)
                             .addCFunction("rotate",             &ImageWrapper::rotate)
                             .addCFunction("getPixel",           &ImageWrapper::getPixel)
@@ -346,13 +544,24 @@ namespace rpgss {
                             .addCFunction("drawTriangle",       &ImageWrapper::drawTriangle)
                             .addCFunction("draw",               &ImageWrapper::draw)
                             .addCFunction("drawq",              &ImageWrapper::drawq)
+                            .addCFunction("drawBatch",          &ImageWrapper::drawBatch)
                             .addCFunction("drawText",           &ImageWrapper::drawText)
                             .addCFunction("drawWindow",         &ImageWrapper::drawWindow)
                         .endClass()
 
-                        .addCFunction("newImage",   &graphics_newImage)
-                        .addCFunction("readImage",  &graphics_readImage)
-                        .addCFunction("writeImage", &graphics_writeImage)
+                        .addCFunction("newImage",       &graphics_newImage)
+                        .addCFunction("readImage",      &graphics_readImage)
+                        .addCFunction("readImageAsync", &graphics_readImageAsync)
+                        .addCFunction("writeImage",     &graphics_writeImage)
+
+                        .beginClass<ImageRequestWrapper>("ImageRequest")
+                            .addProperty("filename",            &ImageRequestWrapper::get_filename)
+                            .addProperty("state",               &ImageRequestWrapper::get_state)
+                            .addProperty("ready",               &ImageRequestWrapper::get_ready)
+                            .addCFunction("get",                &ImageRequestWrapper::get)
+                            .addCFunction("wait",               &ImageRequestWrapper::wait)
+                            .addCFunction("cancel",             &ImageRequestWrapper::cancel)
+                        .endClass()
 
                     .endNamespace();
 
@@ -30,7 +30,11 @@
 #include "ImageWrapper.hpp"
 #include "FontWrapper.hpp"
 #include "WindowSkinWrapper.hpp"
+#include "AtlasWrapper.hpp"
+#include "ImageRequestWrapper.hpp"
 #include "constants.hpp"
+#include "batch.hpp"
+#include "colormatrix.hpp"
 
 
 namespace rpgss {
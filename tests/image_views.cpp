@@ -0,0 +1,121 @@
+/*
+    The MIT License (MIT)
+
+    Copyright (c) 2014 Anatoli Steinmark
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// checks that an image with live views refuses to be resized or rotated
+// and that copying into such an image does not write past its pixels,
+// build with the image sources of the plugin, e.g. from source/rpgss
+//
+//   g++ -I. ../../tests/image_views.cpp common/cpuinfo.cpp graphics/Image.cpp
+//       graphics/{ColorMatrix,Font,SpanTable,WindowSkin}.cpp
+//       graphics/{kernels,kernels_sse2,kernels_avx2,parallel,pixelpool,textcache}.cpp
+//
+// and run it, the exit code is the number of failed checks
+
+#include <cstdio>
+#include "graphics/Image.hpp"
+
+using namespace rpgss;
+using namespace rpgss::graphics;
+
+
+namespace {
+
+    int Failed = 0;
+
+    #define CHECK(expr) \
+        if (!(expr)) { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            Failed++; \
+        }
+
+    //---------------------------------------------------------------------
+    void TestResizeWithViews()
+    {
+        Image::Ptr image = Image::New(8, 8, RGBA(1, 2, 3, 255));
+        Image::Ptr view  = image->view(core::Recti(2, 2, 4, 4));
+
+        CHECK(image->hasViews());
+        CHECK(!image->resize(16, 16));
+        CHECK(!image->rotateClockwise());
+        CHECK(!image->rotateCounterClockwise());
+        CHECK(image->getWidth() == 8 && image->getHeight() == 8);
+
+        // the view still shows the pixels of the image
+        image->setPixel(2, 2, RGBA(9, 9, 9, 255));
+        CHECK(view->getPixel(0, 0) == RGBA(9, 9, 9, 255));
+
+        // resizing to the same size is not a change
+        CHECK(image->resize(8, 8));
+
+        view = 0;
+        CHECK(!image->hasViews());
+        CHECK(image->resize(16, 4));
+        CHECK(image->getWidth() == 16 && image->getHeight() == 4);
+        CHECK(image->rotateClockwise());
+        CHECK(image->getWidth() == 4 && image->getHeight() == 16);
+    }
+
+    //---------------------------------------------------------------------
+    void TestResizeView()
+    {
+        Image::Ptr image = Image::New(8, 8, RGBA(1, 2, 3, 255));
+        Image::Ptr view  = image->view(core::Recti(2, 2, 4, 4));
+
+        // a view without views of its own gets its own pixels
+        CHECK(view->resize(6, 6));
+        CHECK(!view->isView());
+        CHECK(!image->hasViews());
+        CHECK(image->resize(2, 2));
+    }
+
+    //---------------------------------------------------------------------
+    void TestCopyIntoImageWithViews()
+    {
+        Image::Ptr source      = Image::New(8, 8, RGBA(4, 5, 6, 255));
+        Image::Ptr destination = Image::New(4, 4);
+        Image::Ptr view        = destination->view(core::Recti(0, 0, 2, 2));
+
+        CHECK(!source->copyRect(core::Recti(0, 0, 8, 8), destination.get()));
+        CHECK(destination->getWidth() == 4 && destination->getHeight() == 4);
+
+        // copies of the same size need no resize
+        CHECK(source->copyRect(core::Recti(0, 0, 4, 4), destination.get()));
+        CHECK(view->getPixel(1, 1) == RGBA(4, 5, 6, 255));
+    }
+
+} // anonymous namespace
+
+
+//-------------------------------------------------------------------------
+int main()
+{
+    TestResizeWithViews();
+    TestResizeView();
+    TestCopyIntoImageWithViews();
+
+    if (Failed == 0) {
+        std::printf("all checks passed\n");
+    }
+    return Failed;
+}